@@ -0,0 +1,336 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Audit Log
+ *  File        : audit_log.c
+ *  Description : Source file for the append-only access audit log kept as a
+ *                ring buffer in the external EEPROM
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "audit_log.h"
+#include "external_eeprom.h"
+#include "eeprom_queue.h"
+#include "crc.h"
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+/* Optional time source for the record timestamps */
+static uint32 (*g_AUDIT_TimeSourcePtr)(void) = NULL;
+
+/* Ring index where the next record is written */
+static uint8 g_next_index = 0;
+
+/* Sequence number of the next record */
+static uint16 g_next_sequence = 0;
+
+/* Records waiting to be written */
+static uint8 g_stage[AUDIT_STAGE_RECORDS][AUDIT_RECORD_SIZE];
+static uint8 g_stage_count = 0;
+
+/* Events lost because the stage was full */
+static uint16 g_dropped_count = 0;
+
+/* Export in progress: next ring index to read and records left to read */
+static uint8 g_export_index = 0;
+static uint8 g_export_remaining = 0;
+
+/* Records sent by the export: from the cursor up to the end sequence number */
+static uint16 g_export_cursor = AUDIT_EXPORT_ALL;
+static uint16 g_export_end = 0;
+static uint8 g_export_skipped = 0;
+
+/*------------------------------------------------------------------------------
+ *  Private Functions
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] AUDIT_recordAddress
+ * [Description]   EEPROM address of a ring index.
+ *----------------------------------------------------------------------------*/
+static uint16 AUDIT_recordAddress(uint8 index)
+{
+    return (uint16)(AUDIT_RING_BASE_ADDRESS + ((uint16)index * AUDIT_RECORD_SIZE));
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] AUDIT_nextSequence
+ * [Description]   Increments a sequence number skipping the erased value.
+ *----------------------------------------------------------------------------*/
+static uint16 AUDIT_nextSequence(uint16 sequence)
+{
+    sequence++;
+    if (sequence == AUDIT_EMPTY_SEQUENCE)
+    {
+        sequence = 0;
+    }
+    return sequence;
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] AUDIT_isValid
+ * [Description]   TRUE if a record image holds a whole record (not erased, a
+ *                 known event and its check byte matches), fills in its
+ *                 sequence number. The event test rejects most of the 1 in
+ *                 256 torn records whose check byte matches by chance.
+ *----------------------------------------------------------------------------*/
+static boolean AUDIT_isValid(const uint8 *record, uint16 *sequence)
+{
+    *sequence = (uint16)record[AUDIT_SEQUENCE_OFFSET] | ((uint16)record[AUDIT_SEQUENCE_OFFSET + 1] << 8);
+
+    return (boolean)((*sequence != AUDIT_EMPTY_SEQUENCE) &&
+                     (record[AUDIT_EVENT_OFFSET] >= AUDIT_EVENT_BOOT) &&
+                     (record[AUDIT_EVENT_OFFSET] <= AUDIT_EVENT_LAST) &&
+                     (CRC8_compute(record, AUDIT_CHECK_OFFSET) == record[AUDIT_CHECK_OFFSET]));
+}
+
+/*------------------------------------------------------------------------------
+ *  Functions Definitions
+ *----------------------------------------------------------------------------*/
+
+void AUDIT_init(void)
+{
+    uint8 block[AUDIT_SCAN_RECORDS * AUDIT_RECORD_SIZE];
+    uint8 index = 0;
+    uint8 count;
+    uint8 record_idx;
+    uint16 sequence;
+    uint16 newest_sequence = 0;
+    boolean found = FALSE;
+
+    g_next_index = 0;
+    g_next_sequence = 0;
+    g_stage_count = 0;
+
+    while (index < AUDIT_RING_RECORDS)
+    {
+        count = AUDIT_SCAN_RECORDS;
+        if (count > (uint8)(AUDIT_RING_RECORDS - index))
+        {
+            count = (uint8)(AUDIT_RING_RECORDS - index);
+        }
+
+        if (EEPROM_QUEUE_read(AUDIT_recordAddress(index), block, (uint16)count * AUDIT_RECORD_SIZE) == ERROR)
+        {
+            return;
+        }
+
+        for (record_idx = 0; record_idx < count; record_idx++, index++)
+        {
+            /* A torn record is not the newest one, its slot is written again */
+            if (!AUDIT_isValid(&block[record_idx * AUDIT_RECORD_SIZE], &sequence))
+            {
+                continue;
+            }
+
+            /* Serial number arithmetic, the ring is far shorter than half the sequence space */
+            if (!found || ((int16)(sequence - newest_sequence) > 0))
+            {
+                newest_sequence = sequence;
+                g_next_index = (uint8)((index + 1) % AUDIT_RING_RECORDS);
+                found = TRUE;
+            }
+        }
+    }
+
+    if (found)
+    {
+        g_next_sequence = AUDIT_nextSequence(newest_sequence);
+    }
+}
+
+void AUDIT_setTimeSource(uint32 (*a_ptr)(void))
+{
+    g_AUDIT_TimeSourcePtr = a_ptr;
+}
+
+void AUDIT_log(AUDIT_EventType event, uint16 detail)
+{
+    uint8 *record;
+    uint32 timestamp = 0;
+
+    if (g_stage_count >= AUDIT_STAGE_RECORDS)
+    {
+        g_dropped_count++;
+        return;
+    }
+
+    if (g_AUDIT_TimeSourcePtr)
+    {
+        timestamp = g_AUDIT_TimeSourcePtr();
+    }
+
+    record = g_stage[g_stage_count];
+    record[AUDIT_TIMESTAMP_OFFSET] = (uint8)timestamp;
+    record[AUDIT_TIMESTAMP_OFFSET + 1] = (uint8)(timestamp >> 8);
+    record[AUDIT_TIMESTAMP_OFFSET + 2] = (uint8)(timestamp >> 16);
+    record[AUDIT_TIMESTAMP_OFFSET + 3] = (uint8)(timestamp >> 24);
+    record[AUDIT_EVENT_OFFSET] = (uint8)event;
+    record[AUDIT_DETAIL_OFFSET] = (uint8)detail;
+    record[AUDIT_DETAIL_OFFSET + 1] = (uint8)(detail >> 8);
+
+    /* The sequence number is assigned at flush time */
+    g_stage_count++;
+}
+
+uint8 AUDIT_flush(void)
+{
+    uint8 block[AUDIT_STAGE_RECORDS * AUDIT_RECORD_SIZE];
+    uint8 staged = 0;
+    uint8 length;
+    uint8 first_index;
+    uint16 first_sequence;
+
+    while (staged < g_stage_count)
+    {
+        /* Gather the staged records up to the end of the ring, the queue splits them into pages */
+        first_index = g_next_index;
+        first_sequence = g_next_sequence;
+        length = 0;
+
+        do
+        {
+            uint8 *record = &block[length];
+            uint8 byte_idx;
+
+            for (byte_idx = 0; byte_idx < AUDIT_SEQUENCE_OFFSET; byte_idx++)
+            {
+                record[byte_idx] = g_stage[staged][byte_idx];
+            }
+            record[AUDIT_SEQUENCE_OFFSET] = (uint8)g_next_sequence;
+            record[AUDIT_SEQUENCE_OFFSET + 1] = (uint8)(g_next_sequence >> 8);
+            record[AUDIT_CHECK_OFFSET] = CRC8_compute(record, AUDIT_CHECK_OFFSET);
+
+            length += AUDIT_RECORD_SIZE;
+            staged++;
+            g_next_sequence = AUDIT_nextSequence(g_next_sequence);
+            g_next_index = (uint8)((g_next_index + 1) % AUDIT_RING_RECORDS);
+        } while ((staged < g_stage_count) && (g_next_index != 0));
+
+        if (EEPROM_QUEUE_write(AUDIT_recordAddress(first_index), block, length) == ERROR)
+        {
+            /* Keep the records that did not reach the EEPROM for the next flush */
+            uint8 keep_idx;
+            uint8 byte_idx;
+
+            staged -= (uint8)(length / AUDIT_RECORD_SIZE);
+            for (keep_idx = 0; (uint8)(staged + keep_idx) < g_stage_count; keep_idx++)
+            {
+                for (byte_idx = 0; byte_idx < AUDIT_RECORD_SIZE; byte_idx++)
+                {
+                    g_stage[keep_idx][byte_idx] = g_stage[staged + keep_idx][byte_idx];
+                }
+            }
+            g_stage_count = keep_idx;
+            g_next_index = first_index;
+            g_next_sequence = first_sequence;
+            return ERROR;
+        }
+    }
+
+    g_stage_count = 0;
+    return SUCCESS;
+}
+
+uint8 AUDIT_exportBegin(uint16 cursor)
+{
+    /* Staged records join the queue, the reads of the steps see them without waiting for their writes */
+    uint8 result = AUDIT_flush();
+
+    /* The slot about to be overwritten is the oldest one, erased slots are skipped */
+    g_export_index = g_next_index;
+    g_export_remaining = AUDIT_RING_RECORDS;
+    g_export_cursor = cursor;
+    g_export_end = g_next_sequence;
+    g_export_skipped = 0;
+
+    return result;
+}
+
+boolean AUDIT_exportStep(void (*a_send)(uint8))
+{
+    uint8 chunk[AUDIT_EXPORT_FRAME_RECORDS * AUDIT_RECORD_SIZE];
+    uint8 count;
+    uint8 kept;
+    uint8 record_idx;
+    uint8 byte_idx;
+    uint16 sequence;
+
+    if (g_export_remaining == 0)
+    {
+        /* The end frame carries the cursor for the next incremental export */
+        chunk[0] = (uint8)g_export_end;
+        chunk[1] = (uint8)(g_export_end >> 8);
+        chunk[2] = g_export_skipped;
+        chunk[3] = (uint8)g_dropped_count;
+        chunk[4] = (uint8)(g_dropped_count >> 8);
+        DIAG_sendFrame(a_send, AUDIT_EXPORT_FRAME_END, chunk, AUDIT_EXPORT_END_LENGTH);
+        return FALSE;
+    }
+
+    /* One sequential read per frame, never wrapping past the end of the ring */
+    count = AUDIT_EXPORT_FRAME_RECORDS;
+    if (count > g_export_remaining)
+    {
+        count = g_export_remaining;
+    }
+    if (count > (uint8)(AUDIT_RING_RECORDS - g_export_index))
+    {
+        count = (uint8)(AUDIT_RING_RECORDS - g_export_index);
+    }
+
+    if (EEPROM_QUEUE_read(AUDIT_recordAddress(g_export_index), chunk, (uint16)count * AUDIT_RECORD_SIZE) == ERROR)
+    {
+        /* Nothing more can be read, the next step ends the export */
+        g_export_remaining = 0;
+        return TRUE;
+    }
+
+    /* Compact the records to send at the start of the chunk */
+    kept = 0;
+    for (record_idx = 0; record_idx < count; record_idx++)
+    {
+        uint8 *record = &chunk[record_idx * AUDIT_RECORD_SIZE];
+
+        if (!AUDIT_isValid(record, &sequence))
+        {
+            if (sequence != AUDIT_EMPTY_SEQUENCE)
+            {
+                g_export_skipped++;
+            }
+            continue;
+        }
+
+        /* Records logged since the export began are left for the next one */
+        if (((g_export_cursor != AUDIT_EXPORT_ALL) && ((int16)(sequence - g_export_cursor) < 0)) ||
+            ((int16)(sequence - g_export_end) >= 0))
+        {
+            continue;
+        }
+
+        for (byte_idx = 0; byte_idx < AUDIT_RECORD_SIZE; byte_idx++)
+        {
+            chunk[(kept * AUDIT_RECORD_SIZE) + byte_idx] = record[byte_idx];
+        }
+        kept++;
+    }
+
+    if (kept > 0)
+    {
+        DIAG_sendFrame(a_send, AUDIT_EXPORT_FRAME_DATA, chunk, (uint8)(kept * AUDIT_RECORD_SIZE));
+    }
+
+    g_export_index = (uint8)((g_export_index + count) % AUDIT_RING_RECORDS);
+    g_export_remaining = (uint8)(g_export_remaining - count);
+
+    return TRUE;
+}
+
+uint16 AUDIT_getDroppedCount(void)
+{
+    return g_dropped_count;
+}
@@ -0,0 +1,157 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Audit Log
+ *  File        : audit_log.h
+ *  Description : Header file for the append-only access audit log kept as a
+ *                ring buffer in the external EEPROM
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+#ifndef AUDIT_LOG_H_
+#define AUDIT_LOG_H_
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "stdtypes.h"
+#include "diag_link.h"
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/* Ring location in the 24C16 (0x0040 - 0x02FB), 70 records of 10 bytes */
+#define AUDIT_RING_BASE_ADDRESS                 0x0040
+#define AUDIT_RING_RECORDS                      70
+#define AUDIT_RECORD_SIZE                       10
+
+/* Records staged in RAM before they are flushed */
+#define AUDIT_STAGE_RECORDS                     4
+
+/* Records read at once by AUDIT_init */
+#define AUDIT_SCAN_RECORDS                      5
+
+/*------------------------------------------------------------------------------
+ * Record layout:
+ *   [0..3] timestamp in seconds (little endian)
+ *   [4]    event type (AUDIT_EventType)
+ *   [5..6] detail (user id or outcome, little endian)
+ *   [7..8] sequence number (little endian)
+ *   [9]    CRC-8 of bytes 0..8
+ *
+ * The memory does not program the bytes of a page in a guaranteed order and
+ * a record may span two pages (two write cycles), so a power cut can leave
+ * any mix of old and new bytes. Records failing the check byte or holding an
+ * unknown event type are ignored.
+ *----------------------------------------------------------------------------*/
+#define AUDIT_TIMESTAMP_OFFSET                  0
+#define AUDIT_EVENT_OFFSET                      4
+#define AUDIT_DETAIL_OFFSET                     5
+#define AUDIT_SEQUENCE_OFFSET                   7
+#define AUDIT_CHECK_OFFSET                      9
+
+/* Sequence number of an erased record */
+#define AUDIT_EMPTY_SEQUENCE                    0xFFFF
+
+/*------------------------------------------------------------------------------
+ * Export frames (see AUDIT_exportStep and diag_link.h for the framing):
+ *   DATA frame payload: up to AUDIT_EXPORT_FRAME_RECORDS raw records
+ *   END frame payload : sequence number of the next record to be written
+ *                       (the cursor to resume from next time), the number
+ *                       of records skipped for a bad check byte, then the
+ *                       number of events dropped since boot because the
+ *                       stage was full (AUDIT_getDroppedCount, u16)
+ *----------------------------------------------------------------------------*/
+#define AUDIT_EXPORT_SOF                        DIAG_FRAME_SOF
+#define AUDIT_EXPORT_FRAME_DATA                 DIAG_FRAME_AUDIT_DATA
+#define AUDIT_EXPORT_FRAME_END                  DIAG_FRAME_AUDIT_END
+#define AUDIT_EXPORT_FRAME_RECORDS              8
+#define AUDIT_EXPORT_END_LENGTH                 5
+
+/* Export cursor meaning "from the oldest record" */
+#define AUDIT_EXPORT_ALL                        AUDIT_EMPTY_SEQUENCE
+
+/*------------------------------------------------------------------------------
+ *  Data Types Declarations
+ *----------------------------------------------------------------------------*/
+
+typedef enum
+{
+    AUDIT_EVENT_BOOT = 1,           /* Control ECU powered up */
+    AUDIT_EVENT_DOOR_OPENED,        /* detail: user id */
+    AUDIT_EVENT_DOOR_CLOSED,        /* detail: user id */
+    AUDIT_EVENT_ACCESS_DENIED,      /* detail: persistent failure count */
+    AUDIT_EVENT_LOCKDOWN_START,     /* detail: 0 */
+    AUDIT_EVENT_LOCKDOWN_END,       /* detail: 0 */
+    AUDIT_EVENT_PASSWORD_CHANGED,   /* detail: 0 */
+    AUDIT_EVENT_USER_ENROLLED,      /* detail: user id */
+    AUDIT_EVENT_USER_DELETED,       /* detail: user id */
+    AUDIT_EVENT_WATCHDOG_RESET,     /* detail: task running at the reset, 0xFF if none */
+    AUDIT_EVENT_STORAGE_ERROR       /* detail: EEPROM area whose write failed */
+} AUDIT_EventType;
+
+/* Highest event type, a record with any other value is not trusted */
+#define AUDIT_EVENT_LAST                        AUDIT_EVENT_STORAGE_ERROR
+
+/*------------------------------------------------------------------------------
+ *  Function Declarations
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] AUDIT_init
+ * [Description]   Scans the ring to find the newest record and resumes after it.
+ *                 Must be called after TWI_init().
+ *----------------------------------------------------------------------------*/
+void AUDIT_init(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] AUDIT_setTimeSource
+ * [Description]   Registers the function returning the current time in seconds.
+ *                 Records are stamped 0 until a time source is set.
+ *----------------------------------------------------------------------------*/
+void AUDIT_setTimeSource(uint32 (*a_ptr)(void));
+
+/*------------------------------------------------------------------------------
+ * [Function Name] AUDIT_log
+ * [Description]   Stages one record in RAM, never touches the EEPROM.
+ *                 If the stage is full the event is counted as dropped.
+ *----------------------------------------------------------------------------*/
+void AUDIT_log(AUDIT_EventType event, uint16 detail);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] AUDIT_flush
+ * [Description]   Hands the staged records to the EEPROM write-behind queue,
+ *                 one queue write per EEPROM page, so it does not wait on
+ *                 the memory either.
+ *----------------------------------------------------------------------------*/
+uint8 AUDIT_flush(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] AUDIT_exportBegin
+ * [Description]   Hands the stage to the write-behind queue and starts an
+ *                 export of the ring from oldest to newest. Only records
+ *                 whose sequence number is at or after the cursor are sent
+ *                 (AUDIT_EXPORT_ALL sends everything), records logged after
+ *                 this call are left for the next export. Nothing is sent
+ *                 until AUDIT_exportStep().
+ *----------------------------------------------------------------------------*/
+uint8 AUDIT_exportBegin(uint16 cursor);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] AUDIT_exportStep
+ * [Description]   Sends at most one CRC-protected frame of the export through
+ *                 the given byte sender, so a caller can spread the export
+ *                 over several scheduler passes. Each step is one sequential
+ *                 EEPROM read through the queue, records failing their check
+ *                 byte are left out and counted in the END frame. Returns
+ *                 FALSE once the END frame has been sent.
+ *----------------------------------------------------------------------------*/
+boolean AUDIT_exportStep(void (*a_send)(uint8));
+
+/*------------------------------------------------------------------------------
+ * [Function Name] AUDIT_getDroppedCount
+ * [Description]   Number of events lost because the stage was full.
+ *----------------------------------------------------------------------------*/
+uint16 AUDIT_getDroppedCount(void);
+
+#endif /* AUDIT_LOG_H_ */
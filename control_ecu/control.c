@@ -11,6 +11,21 @@
 
 #include "modules.h"
 
+/*------------------------------------------------------------------------------
+ *  Data Types Declarations
+ *----------------------------------------------------------------------------*/
+
+/* Position of the protocol task in the HMI exchange */
+typedef enum
+{
+    PROTOCOL_WAIT_COMMAND,      /* Phase two: waiting for a request */
+    PROTOCOL_AUDIT_CURSOR,      /* Receiving the two audit export cursor bytes */
+    PROTOCOL_WAIT_PASSWORD,     /* Waiting for RECIEVE_START_PASSWORD */
+    PROTOCOL_PASSWORD_DIGITS,   /* Receiving the password digits */
+    PROTOCOL_WAIT_DECISION,     /* Phase two: waiting for the HMI decision */
+    PROTOCOL_ADMIN_BYTES        /* Receiving a user enroll or remove request */
+} PROTOCOL_StateType;
+
 /*------------------------------------------------------------------------------
  *  Global Variables
  *----------------------------------------------------------------------------*/
@@ -21,193 +36,449 @@ UART_ConfigType UART_configurations = {UART_8_BIT_DATA, UART_NO_PARITY, UART_1_S
 /* TWI configuration structure */
 TWI_ConfigType TWI_configurations = {TWI_ADDRESS, TWI_BITRATE};
 
-/* TIMER configuration structure */
-TIMER_ConfigType TIMER_configuration = {0, 0, TIMER_TIMER2, TIMER_PRESCALER_64, TIMER_OVERFLOW_MODE};
-
 /* Array to store the accepted password */
 uint8 accepted_password[KEYPAD_PASSWORD_SIZE] = {-1};
 
 /* Array to store the extracted password from EEPROM */
 uint8 extracted_password[KEYPAD_PASSWORD_SIZE] = {-1};
 
+/* Password entries received from the HMI */
+uint8 first_received_password[KEYPAD_PASSWORD_SIZE];
+uint8 second_received_password[KEYPAD_PASSWORD_SIZE];
+
 /* Flags and counters */
 volatile boolean first_password_phase = TRUE;
 volatile boolean second_password_phase = FALSE;
-volatile uint16 overflow_counter = 0;
-volatile uint8 g_open_door_flag = 0;
 volatile uint8 g_phase_two_operation = 0;
 
+/* User id of the last successful verification */
+volatile uint16 g_authenticated_user = NO_USER_ID;
+
+/* Reply to the last phase two password, the HMI decision is only acted on after SEND_TRUE */
+uint8 g_last_verdict = SEND_FALSE;
+
+/* Task states */
+PROTOCOL_StateType g_protocol_state = PROTOCOL_WAIT_PASSWORD;
+
+/* Protocol task reception progress */
+uint8 g_password_entry = 0;
+uint8 g_received_count = 0;
+uint16 g_audit_cursor = 0;
+
+/* Audit export sent one frame per scheduler pass, the timer tag brings the next step */
+boolean g_audit_exporting = FALSE;
+uint8 g_export_timer_tag = AUDIT_EXPORT_TIMER_TAG;
+
+/* Statistics reply sent the same way, one frame per pass, NULL when none is running */
+DIAG_ReplyType g_diag_reply = NULL;
+uint8 g_diag_frame = 0;
+uint8 g_diag_timer_tag = DIAG_REPLY_TIMER_TAG;
+
+/* User administration request being received: credential, user id, flags, new credential */
+uint8 g_admin_command = 0;
+uint8 g_admin_request[USER_ENROLL_LENGTH];
+
+/* Last PIR state seen by the poll timer */
+volatile uint8 g_pir_state = 0;
+
 /*------------------------------------------------------------------------------
  *  Functions and ISR Definitions
  *----------------------------------------------------------------------------*/
 uint8 isPasswordCorrect(void);
+uint8 comparePassword(void);
+uint8 verifyAndAudit(void);
+uint8 administerUsers(void);
+boolean isAdministrator(const uint8 *credential);
+boolean isMasterPassword(const uint8 *password);
+void recordFailure(void);
+void resetFailures(void);
+uint32 uptimeSeconds(void);
 void savePassword(void);
 void extractPassword(void);
-void openDoorCallBack(void);
-void systemLockDown(void);
-void systemLockDownCallBack(void);
+void passwordReceived(void);
+void resumeAfterReset(void);
 void deInitAll(void);
+void continueAuditExport(void);
+void startDiagReply(DIAG_ReplyType a_reply);
+void continueDiagReply(void);
+void receiveByte(uint8 data);
+void pollPir(void *context);
+void exportTimerExpired(void *context);
+void protocolTask(const EVENT_Type *event);
+void doorTask(const EVENT_Type *event);
+void idleTask(void);
 
 /** Main function **/
 int main(void)
 {
+    uint8 crashed_task;
+    SCHEDULER_TaskIdType protocol_task;
+    SCHEDULER_TaskIdType door_task;
+
+    /* Watchdog first, a hang anywhere from here on resets the controller */
+    MONITOR_init();
+
     /* Enable global interrupts */
     SET_BIT(SREG, 7);
 
-    /* Initialize UART, TWI, and other modules */
+    /* Initialize UART, TWI, and other modules, the cycle counter only if something reads it */
+#if (PROFILE_ENABLE)
+    PROFILE_init();
+#endif
     UART_init(&UART_configurations);
     TWI_init(&TWI_configurations);
+#if (TWI_TRACE_ENABLE)
+    TWI_TRACE_init();
+#endif
+    CREDENTIAL_init();
+    AUDIT_init();
+    LOCKOUT_init();
+    SW_TIMER_init();
+    AUDIT_setTimeSource(uptimeSeconds);
+    AUDIT_log(AUDIT_EVENT_BOOT, 0);
     BUZZER_init();
     DC_MOTOR_init();
     PIR_init();
+    g_pir_state = PIR_getState();
+    DOOR_FSM_init();
 
-    /* Infinite loop */
-    for (;;)
+    if (MONITOR_wasWatchdogReset(&crashed_task))
     {
-        /* First phase: Initial password setup */
-        while (first_password_phase)
+        AUDIT_log(AUDIT_EVENT_WATCHDOG_RESET, crashed_task);
+        resumeAfterReset();
+    }
+
+    /* Tasks only run from the main loop, the interrupts just post events */
+    SCHEDULER_init();
+    protocol_task = SCHEDULER_addTask(protocolTask, SCHEDULER_EVENT_MASK(EVENT_UART_BYTE) |
+                                                    SCHEDULER_EVENT_MASK(EVENT_TIMER_EXPIRED));
+    door_task = SCHEDULER_addTask(doorTask, SCHEDULER_EVENT_MASK(EVENT_TIMER_EXPIRED) |
+                                            SCHEDULER_EVENT_MASK(EVENT_PIR_EDGE));
+    SCHEDULER_setIdleHook(idleTask);
+    MONITOR_setLimits(protocol_task, PROTOCOL_TASK_BUDGET_US, 0);
+    MONITOR_setLimits(door_task, DOOR_TASK_BUDGET_US, 0);
+    MONITOR_setLimits(MONITOR_IDLE_TASK, IDLE_TASK_BUDGET_US, IDLE_TASK_PERIOD_MS);
+
+    SW_TIMER_start(PIR_POLL_PERIOD_MS, SW_TIMER_PERIODIC, pollPir, NULL);
+    UART_setReceiveCallBack(receiveByte);
+
+    SCHEDULER_run();
+}
+
+/*------------------------------------------------------------------------------
+ *  Event Sources (interrupt context)
+ *----------------------------------------------------------------------------*/
+
+/** UART receive callback **/
+void receiveByte(uint8 data)
+{
+    EVENT_QUEUE_post(EVENT_UART_BYTE, data);
+}
+
+/** Periodic PIR sample, only the changes become events **/
+void pollPir(void *context)
+{
+    uint8 state = PIR_getState();
+
+    (void)context;
+
+    if (state != g_pir_state)
+    {
+        g_pir_state = state;
+        EVENT_QUEUE_post(EVENT_PIR_EDGE, state);
+    }
+}
+
+/** Audit export and statistics pacing: the next frame goes out on a later scheduler pass **/
+void exportTimerExpired(void *context)
+{
+    EVENT_QUEUE_post(EVENT_TIMER_EXPIRED, *(uint8 *)context);
+}
+
+/*------------------------------------------------------------------------------
+ *  Tasks
+ *----------------------------------------------------------------------------*/
+
+/** HMI protocol: one received byte per call, or the next audit export frame **/
+void protocolTask(const EVENT_Type *event)
+{
+    uint8 data = event->data;
+
+    if (event->id == EVENT_TIMER_EXPIRED)
+    {
+        /* The door timer belongs to the door task */
+        if (data == AUDIT_EXPORT_TIMER_TAG)
+        {
+            continueAuditExport();
+        }
+        else if (data == DIAG_REPLY_TIMER_TAG)
+        {
+            continueDiagReply();
+        }
+        return;
+    }
+
+    switch (g_protocol_state)
+    {
+    case PROTOCOL_WAIT_COMMAND:
+        if (data == AUDIT_EXPORT_REQUEST)
+        {
+            /* Diagnostics: the cursor follows, low byte first */
+            g_received_count = 0;
+            g_protocol_state = PROTOCOL_AUDIT_CURSOR;
+        }
+#if (TWI_TRACE_ENABLE)
+        else if (data == TWI_STATS_REQUEST)
+        {
+            /* Diagnostics: EEPROM transaction timings since boot */
+            startDiagReply(TWI_TRACE_exportFrame);
+        }
+#endif
+#if (PROFILE_ENABLE)
+        else if (data == PROFILE_DUMP_REQUEST)
+        {
+            /* Diagnostics: cycle counts of the profiled regions */
+            startDiagReply(PROFILE_exportFrame);
+        }
+#endif
+        else if (data == TASK_STATS_REQUEST)
+        {
+            /* Diagnostics: task execution times, deadline misses, last reset */
+            startDiagReply(MONITOR_exportFrame);
+        }
+        else if (data == DOOR_STATS_REQUEST)
+        {
+            /* Diagnostics: door state machine transition latencies */
+            startDiagReply(DOOR_FSM_exportFrame);
+        }
+        else if (data == USER_ENROLL_REQUEST || data == USER_REMOVE_REQUEST)
+        {
+            /* Administration: the sender's credential and the user follow */
+            g_admin_command = data;
+            g_received_count = 0;
+            g_protocol_state = PROTOCOL_ADMIN_BYTES;
+        }
+        else if ((data == START_PHASE_TWO_DOOR || data == START_PHASE_TWO_CHANGE) &&
+                 (DOOR_FSM_getState() == DOOR_STATE_LOCKED))
         {
-            uint8 password_correct = isPasswordCorrect();
-            UART_sendByte(password_correct);
+            g_phase_two_operation = data;
+            g_password_entry = 0;
+            g_protocol_state = PROTOCOL_WAIT_PASSWORD;
+        }
+        break;
 
-            /* If the password is incorrect, reset */
-            if (password_correct == SEND_FALSE)
+    case PROTOCOL_AUDIT_CURSOR:
+        if (g_received_count == 0)
+        {
+            g_audit_cursor = data;
+            g_received_count = 1;
+        }
+        else
+        {
+            /* Diagnostics: stream the audit log from the requested cursor */
+            g_audit_cursor |= (uint16)data << 8;
+            AUDIT_exportBegin(g_audit_cursor);
+            if (!g_audit_exporting)
             {
-                UART_flush();
-                continue;
+                /* A running export restarts from the new cursor on its own timer */
+                g_audit_exporting = TRUE;
+                continueAuditExport();
             }
+            g_protocol_state = PROTOCOL_WAIT_COMMAND;
+        }
+        break;
 
-            /* Password is correct, save it to EEPROM */
-            savePassword();
-            first_password_phase = FALSE;
-            second_password_phase = TRUE;
+    case PROTOCOL_WAIT_PASSWORD:
+        if (data == RECIEVE_START_PASSWORD)
+        {
+            g_received_count = 0;
+            g_protocol_state = PROTOCOL_PASSWORD_DIGITS;
         }
+        break;
 
-        /* Second phase: Verify and allow password change */
-        while (second_password_phase)
+    case PROTOCOL_PASSWORD_DIGITS:
+        if (g_password_entry == 0)
         {
-            uint8 phase_two = UART_recieveByte();
-            while (phase_two != START_PHASE_TWO_DOOR && phase_two != START_PHASE_TWO_CHANGE);
+            first_received_password[g_received_count] = data;
+        }
+        else
+        {
+            second_received_password[g_received_count] = data;
+        }
 
-            if (phase_two == START_PHASE_TWO_DOOR)
-            {
-                UART_flush();
-                extractPassword();
-                UART_sendByte(isPasswordCorrect());
-                uint8 lock_down_on_one = UART_recieveByte();
-
-                /* Wait for start motor or system lock sequence */
-                while (lock_down_on_one != START_MOTOR && lock_down_on_one != SYSTEM_LOCK_SEQUENCE &&
-                       lock_down_on_one != PASSWORD_INCORRECT) {}
-
-                if (lock_down_on_one == START_MOTOR)
-                {
-                    /* Open door process */
-                    TIMER_init(&TIMER_configuration);
-                    TIMER_setCallBack(openDoorCallBack, TIMER_TIMER2);
-                    DC_MOTOR_rotate(CLOCKWISE, 255);
-
-                    while (g_open_door_flag == 0) {}
-
-                    /* Stop motor and wait for door close signal */
-                    DC_MOTOR_rotate(STOP, 0);
-
-                    /* Wait for PIR sensor */
-                    while (PIR_getState());
-
-                    UART_sendByte(CLEAR);
-
-                    /* Close door process */
-                    TIMER_deInit(TIMER_TIMER2);
-                    g_open_door_flag = 0;
-                    overflow_counter = 0;
-                    _delay_ms(50);
-
-                    TIMER_init(&TIMER_configuration);
-                    TIMER_setCallBack(openDoorCallBack, TIMER_TIMER2);
-                    DC_MOTOR_rotate(ANTI_CLOCKWISE, 255);
-
-                    while (g_open_door_flag == 0) {}
-
-                    /* Stop motor */
-                    DC_MOTOR_rotate(STOP, 0);
-                    TIMER_deInit(TIMER_TIMER2);
-                    g_open_door_flag = 0;
-                    overflow_counter = 0;
-                }
-                else if (lock_down_on_one == SYSTEM_LOCK_SEQUENCE)
-                {
-                    /* Initiate system lock down */
-                    systemLockDown();
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            else if (phase_two == START_PHASE_TWO_CHANGE)
-            {
-                /* Handle password change request */
-                extractPassword();
-                UART_sendByte(isPasswordCorrect());
-
-                uint8 lock_down_on_two = UART_recieveByte();
-                while (lock_down_on_two != RESET_PASSWORD && lock_down_on_two != SYSTEM_LOCK_SEQUENCE &&
-                       lock_down_on_two != PASSWORD_INCORRECT) {}
-
-                if (lock_down_on_two == RESET_PASSWORD)
-                {
-                    /* Password matches, allow a new password to be set */
-                    deInitAll();
-                }
-                else if (lock_down_on_two == SYSTEM_LOCK_SEQUENCE)
-                {
-                    /* Initiate system lock down */
-                    systemLockDown();
-                }
-                else
-                {
-                    continue;
-                }
-            }
+        if (++g_received_count == KEYPAD_PASSWORD_SIZE)
+        {
+            passwordReceived();
+        }
+        break;
+
+    case PROTOCOL_WAIT_DECISION:
+        /* A decision the verdict did not grant is ignored, the HMI follows up with a refusal */
+        if (data == START_MOTOR && g_last_verdict == SEND_TRUE &&
+            g_phase_two_operation == START_PHASE_TWO_DOOR)
+        {
+            g_last_verdict = SEND_FALSE;
+            DOOR_FSM_setUser(g_authenticated_user);
+            DOOR_FSM_dispatch(DOOR_EVENT_OPEN, event->time_us);
+            g_protocol_state = PROTOCOL_WAIT_COMMAND;
         }
+        else if (data == RESET_PASSWORD && g_last_verdict == SEND_TRUE &&
+                 g_phase_two_operation == START_PHASE_TWO_CHANGE)
+        {
+            /* Master password or an administrator matched (verifyAndAudit), allow a new password */
+            g_last_verdict = SEND_FALSE;
+            deInitAll();
+        }
+        else if (data == SYSTEM_LOCK_SEQUENCE)
+        {
+            DOOR_FSM_dispatch(DOOR_EVENT_LOCKDOWN, event->time_us);
+            g_protocol_state = PROTOCOL_WAIT_COMMAND;
+        }
+        else if (data == PASSWORD_INCORRECT)
+        {
+            /* The HMI asks again, starting with a new request */
+            g_protocol_state = PROTOCOL_WAIT_COMMAND;
+        }
+        break;
+
+    case PROTOCOL_ADMIN_BYTES:
+        g_admin_request[g_received_count++] = data;
+
+        if (g_received_count == ((g_admin_command == USER_ENROLL_REQUEST) ? USER_ENROLL_LENGTH : USER_REMOVE_LENGTH))
+        {
+            UART_sendByte(administerUsers());
+            g_protocol_state = PROTOCOL_WAIT_COMMAND;
+        }
+        break;
     }
 }
 
-/** Function to check if the entered password is correct **/
-uint8 isPasswordCorrect(void)
+/** Door: feeds the door state machine with its timer and the PIR edges **/
+void doorTask(const EVENT_Type *event)
+{
+    if ((event->id == EVENT_TIMER_EXPIRED) && (event->data == DOOR_TIMER_TAG))
+    {
+        DOOR_FSM_dispatch(DOOR_EVENT_TIMEOUT, event->time_us);
+    }
+    else if ((event->id == EVENT_PIR_EDGE) && (event->data == 0))
+    {
+        DOOR_FSM_dispatch(DOOR_EVENT_PIR_CLEAR, event->time_us);
+    }
+}
+
+/** Background work done while no event is waiting **/
+void idleTask(void)
 {
-    uint8 first_received_password[KEYPAD_PASSWORD_SIZE];
-    uint8 second_received_password[KEYPAD_PASSWORD_SIZE];
+    AUDIT_flush();
+    EEPROM_QUEUE_service();
+}
 
-    /* Wait for the first password entry start signal */
-    while (UART_recieveByte() != RECIEVE_START_PASSWORD);
+/*------------------------------------------------------------------------------
+ *  Helper Functions
+ *----------------------------------------------------------------------------*/
 
-    /* Receive the first password entry */
-    for (uint8 loop_idx = 0; loop_idx < KEYPAD_PASSWORD_SIZE; loop_idx++)
+/** Send one audit export frame, a longer run would hold off the watchdog feed **/
+void continueAuditExport(void)
+{
+    if (!AUDIT_exportStep(UART_sendByte))
+    {
+        g_audit_exporting = FALSE;
+    }
+    else if (SW_TIMER_start(AUDIT_EXPORT_FRAME_GAP_MS, SW_TIMER_ONE_SHOT, exportTimerExpired,
+                            &g_export_timer_tag) == SW_TIMER_INVALID_ID)
     {
-        _delay_ms(50);
-        first_received_password[loop_idx] = UART_recieveByte();
+        /* No END frame, the reader times out and asks again from the same cursor */
+        g_audit_exporting = FALSE;
     }
+}
 
-    if (first_password_phase && !second_password_phase)
+/** Start a statistics reply, a running one is replaced and its timer sends the new one **/
+void startDiagReply(DIAG_ReplyType a_reply)
+{
+    boolean running = (boolean)(g_diag_reply != NULL);
+
+    g_diag_reply = a_reply;
+    g_diag_frame = 0;
+    if (!running)
+    {
+        continueDiagReply();
+    }
+}
+
+/** Send one statistics frame, like continueAuditExport **/
+void continueDiagReply(void)
+{
+    if (!g_diag_reply(g_diag_frame++, UART_sendByte))
+    {
+        g_diag_reply = NULL;
+    }
+    else if (SW_TIMER_start(DIAG_REPLY_FRAME_GAP_MS, SW_TIMER_ONE_SHOT, exportTimerExpired,
+                            &g_diag_timer_tag) == SW_TIMER_INVALID_ID)
     {
-        /* Wait for the second password entry start signal */
-        while (UART_recieveByte() != RECIEVE_START_PASSWORD) {}
+        /* The reply is cut short, the reader times out and asks again */
+        g_diag_reply = NULL;
+    }
+}
 
-        /* Receive the second password entry */
-        for (uint8 loop_idx = 0; loop_idx < KEYPAD_PASSWORD_SIZE; loop_idx++)
+/** Function to act on a complete password entry **/
+void passwordReceived(void)
+{
+    if (first_password_phase)
+    {
+        /* First phase: Initial password setup, entered twice */
+        if (g_password_entry == 0)
         {
-            _delay_ms(50);
-            second_received_password[loop_idx] = UART_recieveByte();
+            g_password_entry = 1;
+            g_protocol_state = PROTOCOL_WAIT_PASSWORD;
+            return;
         }
 
+        uint8 password_correct = isPasswordCorrect();
+        UART_sendByte(password_correct);
+
+        g_password_entry = 0;
+        g_protocol_state = PROTOCOL_WAIT_PASSWORD;
+
+        if (password_correct == SEND_TRUE)
+        {
+            /* Password is correct, save it to EEPROM */
+            savePassword();
+            first_password_phase = FALSE;
+            second_password_phase = TRUE;
+            g_protocol_state = PROTOCOL_WAIT_COMMAND;
+        }
+    }
+    else
+    {
+        /* Second phase: Verify before opening the door or changing the password */
+        extractPassword();
+        UART_sendByte(verifyAndAudit());
+        g_protocol_state = PROTOCOL_WAIT_DECISION;
+    }
+}
+
+/** Function to check if the received password is correct **/
+uint8 isPasswordCorrect(void)
+{
+    uint8 verdict;
+
+    PROFILE_BEGIN(PROFILE_IS_PASSWORD_CORRECT);
+    verdict = comparePassword();
+    PROFILE_END(PROFILE_IS_PASSWORD_CORRECT);
+
+    return verdict;
+}
+
+/** Compare the received password with the first entry, the stored one or the user table **/
+uint8 comparePassword(void)
+{
+    if (first_password_phase && !second_password_phase)
+    {
         /* Compare both password entries */
         for (uint8 loop_idx = 0; loop_idx < KEYPAD_PASSWORD_SIZE; loop_idx++)
         {
             if (first_received_password[loop_idx] != second_received_password[loop_idx])
             {
-                UART_flush();
                 return SEND_FALSE; /* Passwords do not match */
             }
         }
@@ -218,83 +489,212 @@ uint8 isPasswordCorrect(void)
             accepted_password[loop_idx] = first_received_password[loop_idx];
         }
 
-        UART_flush();
         return SEND_TRUE; /* Passwords match */
     }
-    else if (!first_password_phase && second_password_phase)
+    else
     {
         /* Compare with extracted password */
-        for (uint8 loop_idx = 0; loop_idx < KEYPAD_PASSWORD_SIZE; loop_idx++)
+        uint16 user_id = MASTER_USER_ID;
+        if (!isMasterPassword(first_received_password) && USER_TABLE_verify(first_received_password, &user_id, NULL) == ERROR)
         {
-            if (first_received_password[loop_idx] != extracted_password[loop_idx])
-            {
-                UART_flush();
-                return SEND_FALSE; /* Passwords do not match */
-            }
+            g_authenticated_user = NO_USER_ID;
+            return SEND_FALSE; /* Matches neither the master password nor an enrolled user */
         }
-        UART_flush();
+        g_authenticated_user = user_id;
+
         return SEND_TRUE;
     }
 }
 
-/** Function to save the accepted password to EEPROM **/
-void savePassword(void)
+/** Function to verify a phase two password, count failures and record refusals **/
+uint8 verifyAndAudit(void)
+{
+    uint8 password_correct = isPasswordCorrect();
+
+    /* While a lockdown is owed (even from before a power cycle) nothing is accepted */
+    if (LOCKOUT_isLocked())
+    {
+        password_correct = SEND_FALSE;
+    }
+
+    if (password_correct == SEND_TRUE && g_phase_two_operation == START_PHASE_TWO_CHANGE)
+    {
+        /* Only the master or an administrator replaces the master password, counted by isAdministrator */
+        password_correct = isAdministrator(first_received_password) ? SEND_TRUE : SEND_FALSE;
+    }
+    else if (password_correct == SEND_FALSE)
+    {
+        recordFailure();
+    }
+    else
+    {
+        resetFailures();
+    }
+
+    g_last_verdict = password_correct;
+    return password_correct;
+}
+
+/** Function to count and log a refused attempt, a count the EEPROM did not take is logged too **/
+void recordFailure(void)
+{
+    if (LOCKOUT_recordFailure() == ERROR)
+    {
+        AUDIT_log(AUDIT_EVENT_STORAGE_ERROR, LOCKOUT_AREA_ADDRESS);
+    }
+    AUDIT_log(AUDIT_EVENT_ACCESS_DENIED, LOCKOUT_getFailures());
+}
+
+/** Function to clear the failure count after an accepted attempt **/
+void resetFailures(void)
+{
+    if (LOCKOUT_reset() == ERROR)
+    {
+        AUDIT_log(AUDIT_EVENT_STORAGE_ERROR, LOCKOUT_AREA_ADDRESS);
+    }
+}
+
+/** Function to run a complete enroll or remove request, returns the reply byte **/
+uint8 administerUsers(void)
 {
+    const uint8 *credential = &g_admin_request[USER_ADMIN_NEW_OFFSET];
+    uint16 user_id = (uint16)g_admin_request[USER_ADMIN_ID_OFFSET] |
+                     ((uint16)g_admin_request[USER_ADMIN_ID_OFFSET + 1] << 8);
+
+    /* Only keypad digits, an unset master password reads as 0xFF digits */
     for (uint8 loop_idx = 0; loop_idx < KEYPAD_PASSWORD_SIZE; loop_idx++)
     {
-        EEPROM_writeByte(EEPROM_STARTBYTE + loop_idx, accepted_password[loop_idx]);
-        _delay_ms(20); /* Add a delay to ensure EEPROM write completes */
+        if (g_admin_request[USER_ADMIN_CREDENTIAL_OFFSET + loop_idx] > 9 ||
+            (g_admin_command == USER_ENROLL_REQUEST && credential[loop_idx] > 9))
+        {
+            return SEND_FALSE;
+        }
+    }
+
+    if (!isAdministrator(&g_admin_request[USER_ADMIN_CREDENTIAL_OFFSET]))
+    {
+        return SEND_FALSE;
+    }
+
+    /* The master password is only changed from the keypad */
+    if (user_id == MASTER_USER_ID)
+    {
+        return SEND_FALSE;
     }
+
+    if (g_admin_command == USER_ENROLL_REQUEST)
+    {
+        /* A user holding the master password would be logged as the master */
+        if (isMasterPassword(credential) ||
+            USER_TABLE_enroll(user_id, credential, g_admin_request[USER_ADMIN_FLAGS_OFFSET]) == ERROR)
+        {
+            return SEND_FALSE;
+        }
+        AUDIT_log(AUDIT_EVENT_USER_ENROLLED, user_id);
+    }
+    else
+    {
+        if (USER_TABLE_remove(user_id) == ERROR)
+        {
+            return SEND_FALSE;
+        }
+        AUDIT_log(AUDIT_EVENT_USER_DELETED, user_id);
+    }
+
+    return SEND_TRUE;
 }
 
-/** Function to extract the saved password from EEPROM **/
-void extractPassword(void)
+/** Function to check the master password or an admin user's credential, failures count as for the door **/
+boolean isAdministrator(const uint8 *credential)
+{
+    uint8 flags = 0;
+    boolean granted;
+
+    /* While a lockdown is owed nothing is accepted */
+    if (LOCKOUT_isLocked())
+    {
+        return FALSE;
+    }
+
+    extractPassword();
+    granted = (boolean)(isMasterPassword(credential) ||
+                        (USER_TABLE_verify(credential, NULL, &flags) == SUCCESS && (flags & USER_FLAG_ADMIN)));
+
+    if (!granted)
+    {
+        recordFailure();
+
+        /* Guessing over the serial line ends in the same lockdown as at the keypad */
+        if (LOCKOUT_isLocked())
+        {
+            DOOR_FSM_dispatch(DOOR_EVENT_LOCKDOWN, SW_TIMER_micros());
+        }
+        return FALSE;
+    }
+
+    resetFailures();
+    return TRUE;
+}
+
+/** Function to compare a password with the stored master password (extractPassword first) **/
+boolean isMasterPassword(const uint8 *password)
 {
     for (uint8 loop_idx = 0; loop_idx < KEYPAD_PASSWORD_SIZE; loop_idx++)
     {
-        uint8 eeprom_value = 0;
-        EEPROM_readByte(EEPROM_STARTBYTE + loop_idx, &eeprom_value);
-        extracted_password[loop_idx] = eeprom_value;
-        _delay_ms(20);
+        if (password[loop_idx] != extracted_password[loop_idx])
+        {
+            return FALSE;
+        }
     }
+
+    return TRUE;
 }
 
-/** Timer callback function for door opening/closing control **/
-void openDoorCallBack(void)
+/** Function to save the accepted password to EEPROM **/
+void savePassword(void)
 {
-    overflow_counter++;
-    if (overflow_counter == TARGET_OVERFLOWS)
+    /* Written to the inactive slot, the previous password survives a reset */
+    if (CREDENTIAL_save(accepted_password) == SUCCESS)
     {
-        g_open_door_flag = 1;  // Set flag when target time is reached
-        overflow_counter = 0;  // Reset tick counter
+        AUDIT_log(AUDIT_EVENT_PASSWORD_CHANGED, 0);
     }
 }
 
-/** Timer callback function for system lock down control **/
-void systemLockDownCallBack(void)
+/** Function to extract the saved password from EEPROM **/
+void extractPassword(void)
 {
-    overflow_counter++;
-    if (overflow_counter == LOCK_DOWN_TIME)
+    if (CREDENTIAL_load(extracted_password) == ERROR)
     {
-        g_open_door_flag = 1;  // Set flag when target time is reached
-        overflow_counter = 0;  // Reset tick counter
+        /* No valid password stored, use a value no keypad digit can match */
+        for (uint8 loop_idx = 0; loop_idx < KEYPAD_PASSWORD_SIZE; loop_idx++)
+        {
+            extracted_password[loop_idx] = 0xFF;
+        }
     }
 }
 
-/** Function to initiate system lock down **/
-void systemLockDown(void)
+/** Audit log time source: seconds since power up **/
+uint32 uptimeSeconds(void)
 {
-    TIMER_init(&TIMER_configuration);
-    TIMER_setCallBack(systemLockDownCallBack, TIMER_TIMER2);
-    BUZZER_on();
-    while (g_open_door_flag == 0) {}
+    return SW_TIMER_millis() / 1000;
+}
 
-    UART_sendByte(CLEAR);
-    g_open_door_flag = 1;
-    overflow_counter = 0;
+/** Function to pick the exchange up again after a watchdog reset, the HMI kept running **/
+void resumeAfterReset(void)
+{
+    /* A password was set before the reset: the HMI is past phase one */
+    if (CREDENTIAL_load(extracted_password) == SUCCESS)
+    {
+        first_password_phase = FALSE;
+        second_password_phase = TRUE;
+        g_protocol_state = PROTOCOL_WAIT_COMMAND;
+    }
 
-    BUZZER_off();
-    TIMER_deInit(TIMER_TIMER2);
+    /* A lockdown cut short is served again, the HMI waits for its CLEAR */
+    if (LOCKOUT_isLocked())
+    {
+        DOOR_FSM_dispatch(DOOR_EVENT_LOCKDOWN, SW_TIMER_micros());
+    }
 }
 
 /** Function to deinitialize all modules and reset flags **/
@@ -302,8 +702,7 @@ void deInitAll(void)
 {
     first_password_phase = TRUE;
     second_password_phase = FALSE;
-    overflow_counter = 0;
-    g_open_door_flag = 0;
     g_phase_two_operation = 0;
-    UART_flush();
+    g_password_entry = 0;
+    g_protocol_state = PROTOCOL_WAIT_PASSWORD;
 }
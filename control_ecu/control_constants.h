@@ -22,19 +22,67 @@
 #define TWI_ADDRESS                 0x65
 #define TWI_BITRATE                 2
 
-#define EEPROM_STARTBYTE            0x0310
+#define MASTER_USER_ID              0x0000
+#define NO_USER_ID                  0xFFFF
 
 #define START_PHASE_TWO_CHANGE      0x4A
 #define START_PHASE_TWO_DOOR        0x4B
 #define PASSWORD_RETRY              0x33
 #define PASSWORD_SUCCESS            0x34
 #define START_MOTOR                 0x3A
-#define TARGET_OVERFLOWS            7324
+#define DOOR_MOTOR_TIME_MS          15000
+#define DOOR_REVERSE_DELAY_MS       50
 #define CLEAR                       0x3B
 #define SYSTEM_LOCK_SEQUENCE        0x3C
-#define LOCK_DOWN_TIME              29296
+#define LOCK_DOWN_TIME_MS           60000
 #define RESET_PASSWORD              0x4C
 #define PASSWORD_INCORRECT          0x4D
 
+/* Diagnostics requests */
+#define AUDIT_EXPORT_REQUEST        0x6A
+#define TWI_STATS_REQUEST           0x6B
+#define PROFILE_DUMP_REQUEST        0x6C
+#define TASK_STATS_REQUEST          0x6D
+#define DOOR_STATS_REQUEST          0x6E
+
+/*
+ * User administration requests, answered with SEND_TRUE or SEND_FALSE.
+ * Request bytes: master password or an admin user's credential (5), user id
+ * (2, low byte first), then for an enroll the user flags (1) and credential (5).
+ */
+#define USER_ENROLL_REQUEST         0x6F
+#define USER_REMOVE_REQUEST         0x70
+#define USER_REMOVE_LENGTH          7
+#define USER_ENROLL_LENGTH          13
+#define USER_ADMIN_CREDENTIAL_OFFSET 0
+#define USER_ADMIN_ID_OFFSET        5
+#define USER_ADMIN_FLAGS_OFFSET     7
+#define USER_ADMIN_NEW_OFFSET       8
+
+/* Scheduler event sources */
+#define PIR_POLL_PERIOD_MS          10
+#define DOOR_TIMER_TAG              1
+#define AUDIT_EXPORT_TIMER_TAG      2
+#define AUDIT_EXPORT_FRAME_GAP_MS   1
+#define DIAG_REPLY_TIMER_TAG        3
+#define DIAG_REPLY_FRAME_GAP_MS     1
+
+/*
+ * Task monitor deadlines, bus times measured on the 24C16 model (make -C host
+ * test / bench):
+ * protocol: a user removal or enrollment scans the whole table, 356 ms; an
+ *           audit export step (one read and one frame at 9600 baud) is
+ *           113 ms; the statistics replies go one frame per pass too, the
+ *           longest frame (a TWI operation, 44 bytes) is 46 ms
+ * door    : the lockout reset at the end of a lockdown, 0.9 ms after up to
+ *           one write cycle (5 ms)
+ * idle    : a page commit, 18 bytes at 31.25 kHz (5.6 ms) after up to one
+ *           write cycle (5 ms)
+ */
+#define PROTOCOL_TASK_BUDGET_US     400000
+#define DOOR_TASK_BUDGET_US         7000
+#define IDLE_TASK_BUDGET_US         12000
+#define IDLE_TASK_PERIOD_MS         500
+
 
 #endif /* CONTROL_CONSTANTS_H_ */
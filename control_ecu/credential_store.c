@@ -0,0 +1,210 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Credential Store
+ *  File        : credential_store.c
+ *  Description : Source file for the power-fail-safe password storage in the
+ *                external EEPROM (two alternating slots with sequence and CRC)
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "credential_store.h"
+#include "external_eeprom.h"
+#include "eeprom_queue.h"
+#include "crc.h"
+
+#if (CREDENTIAL_STORAGE_BACKEND == CREDENTIAL_BACKEND_INTERNAL)
+#include "internal_eeprom.h"
+#endif
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+/* EEPROM address of each slot */
+static const uint16 g_slot_address[2] = {CREDENTIAL_SLOT_A_ADDRESS, CREDENTIAL_SLOT_B_ADDRESS};
+
+/* Index of the slot holding the newest valid record */
+static uint8 g_active_slot = CREDENTIAL_NO_SLOT;
+
+/* Sequence number of the active record */
+static uint16 g_active_sequence = 0;
+
+/*------------------------------------------------------------------------------
+ *  Private Functions
+ *----------------------------------------------------------------------------*/
+
+#if (CREDENTIAL_STORAGE_BACKEND == CREDENTIAL_BACKEND_INTERNAL)
+/*------------------------------------------------------------------------------
+ * [Function Name] CREDENTIAL_storageRead / CREDENTIAL_storageWrite
+ * [Description]   On-chip EEPROM backend. The write returns as soon as the
+ *                 record is buffered, the following read-back waits for it.
+ *----------------------------------------------------------------------------*/
+static uint8 CREDENTIAL_storageRead(uint16 address, uint8 *data, uint8 length)
+{
+    return INTERNAL_EEPROM_readBlock(address, data, length);
+}
+
+static uint8 CREDENTIAL_storageWrite(uint16 address, const uint8 *data, uint8 length)
+{
+    return INTERNAL_EEPROM_writeBlock(address, data, length);
+}
+#elif (CREDENTIAL_STORAGE_BACKEND == CREDENTIAL_BACKEND_EXTERNAL)
+/*------------------------------------------------------------------------------
+ * [Function Name] CREDENTIAL_storageRead / CREDENTIAL_storageWrite
+ * [Description]   External 24C16 backend: sequential read (seeing the bytes
+ *                 still in the write-behind queue) and page write.
+ *----------------------------------------------------------------------------*/
+static uint8 CREDENTIAL_storageRead(uint16 address, uint8 *data, uint8 length)
+{
+    return EEPROM_QUEUE_read(address, data, length);
+}
+
+static uint8 CREDENTIAL_storageWrite(uint16 address, const uint8 *data, uint8 length)
+{
+    return EEPROM_writePage(address, data, length);
+}
+#else
+#error "CREDENTIAL_STORAGE_BACKEND must be CREDENTIAL_BACKEND_EXTERNAL or CREDENTIAL_BACKEND_INTERNAL"
+#endif
+
+/*------------------------------------------------------------------------------
+ * [Function Name] CREDENTIAL_readSlot
+ * [Description]   Reads one slot and checks its CRC. Returns TRUE and fills the
+ *                 record buffer and its sequence number if the slot is valid.
+ *----------------------------------------------------------------------------*/
+static boolean CREDENTIAL_readSlot(uint8 slot, uint8 *record, uint16 *sequence)
+{
+    uint16 stored_crc;
+
+    if (CREDENTIAL_storageRead(g_slot_address[slot], record, CREDENTIAL_RECORD_SIZE) == ERROR)
+    {
+        return FALSE;
+    }
+
+    stored_crc = (uint16)record[CREDENTIAL_CRC_OFFSET] |
+                 ((uint16)record[CREDENTIAL_CRC_OFFSET + 1] << 8);
+
+    if (CRC16_compute(record, CREDENTIAL_CRC_OFFSET) != stored_crc)
+    {
+        return FALSE; /* Erased, torn or corrupted slot */
+    }
+
+    *sequence = (uint16)record[CREDENTIAL_SEQUENCE_OFFSET] |
+                ((uint16)record[CREDENTIAL_SEQUENCE_OFFSET + 1] << 8);
+
+    return TRUE;
+}
+
+/*------------------------------------------------------------------------------
+ *  Functions Definitions
+ *----------------------------------------------------------------------------*/
+
+void CREDENTIAL_init(void)
+{
+    uint8 record[CREDENTIAL_RECORD_SIZE];
+    uint16 sequence[2];
+    boolean valid[2];
+
+    valid[0] = CREDENTIAL_readSlot(0, record, &sequence[0]);
+    valid[1] = CREDENTIAL_readSlot(1, record, &sequence[1]);
+
+    if (valid[0] && valid[1])
+    {
+        /* Serial number arithmetic so the sequence may wrap around */
+        g_active_slot = ((int16)(sequence[1] - sequence[0]) > 0) ? 1 : 0;
+    }
+    else if (valid[0])
+    {
+        g_active_slot = 0;
+    }
+    else if (valid[1])
+    {
+        g_active_slot = 1;
+    }
+    else
+    {
+        g_active_slot = CREDENTIAL_NO_SLOT;
+        return;
+    }
+
+    g_active_sequence = sequence[g_active_slot];
+}
+
+uint8 CREDENTIAL_save(const uint8 *password)
+{
+    uint8 record[CREDENTIAL_RECORD_SIZE];
+    uint8 target_slot;
+    uint16 sequence;
+    uint16 crc;
+    uint8 loop_idx;
+
+    /* Never overwrite the active record, it is the fallback if this save is cut */
+    target_slot = (g_active_slot == 0) ? 1 : 0;
+    sequence = (g_active_slot == CREDENTIAL_NO_SLOT) ? 0 : (uint16)(g_active_sequence + 1);
+
+    for (loop_idx = 0; loop_idx < CREDENTIAL_RECORD_SIZE; loop_idx++)
+    {
+        record[loop_idx] = 0xFF;
+    }
+
+    record[CREDENTIAL_SEQUENCE_OFFSET] = (uint8)sequence;
+    record[CREDENTIAL_SEQUENCE_OFFSET + 1] = (uint8)(sequence >> 8);
+
+    for (loop_idx = 0; loop_idx < CREDENTIAL_PASSWORD_SIZE; loop_idx++)
+    {
+        record[CREDENTIAL_PASSWORD_OFFSET + loop_idx] = password[loop_idx];
+    }
+
+    crc = CRC16_compute(record, CREDENTIAL_CRC_OFFSET);
+    record[CREDENTIAL_CRC_OFFSET] = (uint8)crc;
+    record[CREDENTIAL_CRC_OFFSET + 1] = (uint8)(crc >> 8);
+
+    /* External backend: one page write, the whole record is programmed in one write cycle */
+    if (CREDENTIAL_storageWrite(g_slot_address[target_slot], record, CREDENTIAL_RECORD_SIZE) == ERROR)
+    {
+        return ERROR;
+    }
+
+    /* Read back (waits for the write cycle) before switching the active slot */
+    if (CREDENTIAL_readSlot(target_slot, record, &sequence) == FALSE)
+    {
+        return ERROR;
+    }
+
+    g_active_slot = target_slot;
+    g_active_sequence = sequence;
+
+    return SUCCESS;
+}
+
+uint8 CREDENTIAL_load(uint8 *password)
+{
+    uint8 record[CREDENTIAL_RECORD_SIZE];
+    uint16 sequence;
+    uint8 loop_idx;
+
+    if (g_active_slot == CREDENTIAL_NO_SLOT)
+    {
+        return ERROR;
+    }
+
+    if (CREDENTIAL_readSlot(g_active_slot, record, &sequence) == FALSE)
+    {
+        return ERROR;
+    }
+
+    for (loop_idx = 0; loop_idx < CREDENTIAL_PASSWORD_SIZE; loop_idx++)
+    {
+        password[loop_idx] = record[CREDENTIAL_PASSWORD_OFFSET + loop_idx];
+    }
+
+    return SUCCESS;
+}
+
+uint8 CREDENTIAL_getActiveSlot(void)
+{
+    return g_active_slot;
+}
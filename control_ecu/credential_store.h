@@ -0,0 +1,96 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Credential Store
+ *  File        : credential_store.h
+ *  Description : Header file for the power-fail-safe password storage in the
+ *                external EEPROM (two alternating slots with sequence and CRC)
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+#ifndef CREDENTIAL_STORE_H_
+#define CREDENTIAL_STORE_H_
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "stdtypes.h"
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/*
+ * Storage backend, selected at build time (e.g. -DCREDENTIAL_STORAGE_BACKEND=1):
+ *   CREDENTIAL_BACKEND_EXTERNAL: 24C16 over TWI (page writes)
+ *   CREDENTIAL_BACKEND_INTERNAL: ATmega32 on-chip EEPROM (EE_RDY interrupt writes)
+ * The slot addresses below are valid for both memories.
+ */
+#define CREDENTIAL_BACKEND_EXTERNAL             0
+#define CREDENTIAL_BACKEND_INTERNAL             1
+
+#ifndef CREDENTIAL_STORAGE_BACKEND
+#define CREDENTIAL_STORAGE_BACKEND              CREDENTIAL_BACKEND_EXTERNAL
+#endif
+
+/* Number of digits of a stored password */
+#define CREDENTIAL_PASSWORD_SIZE                5
+
+/*
+ * Each slot is one EEPROM page so a save is a single page write: either the
+ * whole record reaches the cells or the CRC check rejects it. Slot A keeps the
+ * location of the old single-copy password. The internal EEPROM programs byte
+ * by byte, a cut save is rejected by the same CRC check.
+ */
+#define CREDENTIAL_SLOT_A_ADDRESS               0x0310
+#define CREDENTIAL_SLOT_B_ADDRESS               0x0320
+
+/*------------------------------------------------------------------------------
+ * Slot record layout (one 16 bytes page):
+ *   [0..1]   sequence number (little endian), incremented on every save
+ *   [2..6]   password digits
+ *   [7..13]  reserved (0xFF)
+ *   [14..15] CRC-16 of bytes 0..13 (little endian)
+ *----------------------------------------------------------------------------*/
+#define CREDENTIAL_RECORD_SIZE                  16
+#define CREDENTIAL_SEQUENCE_OFFSET              0
+#define CREDENTIAL_PASSWORD_OFFSET              2
+#define CREDENTIAL_CRC_OFFSET                   14
+
+/* Value returned by CREDENTIAL_getActiveSlot() when no slot holds a valid record */
+#define CREDENTIAL_NO_SLOT                      0xFF
+
+/*------------------------------------------------------------------------------
+ *  Function Declarations
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] CREDENTIAL_init
+ * [Description]   Boot-time scan of both slots, selects the newest slot whose
+ *                 CRC is valid. Must be called after TWI_init().
+ *----------------------------------------------------------------------------*/
+void CREDENTIAL_init(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] CREDENTIAL_save
+ * [Description]   Writes the password into the slot that does not hold the
+ *                 active record, then makes it active once it is read back
+ *                 valid. A reset at any point leaves the previous record intact.
+ *                 Returns SUCCESS or ERROR.
+ *----------------------------------------------------------------------------*/
+uint8 CREDENTIAL_save(const uint8 *password);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] CREDENTIAL_load
+ * [Description]   Reads the password of the active slot.
+ *                 Returns ERROR if no valid record exists.
+ *----------------------------------------------------------------------------*/
+uint8 CREDENTIAL_load(uint8 *password);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] CREDENTIAL_getActiveSlot
+ * [Description]   Returns the index (0 = A, 1 = B) of the active slot or
+ *                 CREDENTIAL_NO_SLOT.
+ *----------------------------------------------------------------------------*/
+uint8 CREDENTIAL_getActiveSlot(void);
+
+#endif /* CREDENTIAL_STORE_H_ */
@@ -0,0 +1,431 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Door State Machine
+ *  File        : door_fsm.c
+ *  Description : Source file for the table driven door lifecycle (locked,
+ *                opening, held open, closing, lockdown, fault) driving the
+ *                motor and the buzzer, with the latency of every transition
+ *                from its event to the actuator change
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "door_fsm.h"
+#include "dc_motor.h"
+#include "buzzer.h"
+#include "pir_sensor.h"
+#include "uart.h"
+#include "audit_log.h"
+#include "lockout_counter.h"
+#include "external_eeprom.h"
+#include "sw_timer.h"
+#include "event_queue.h"
+#include "diag_link.h"
+#include "control_constants.h"
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+#define DOOR_FSM_MOTOR_SPEED                    255
+
+/* In the 'state' column: the row matches in every state */
+#define DOOR_FSM_ANY_STATE                      DOOR_STATES
+
+/* In the 'next' column: internal transition, no exit or entry action */
+#define DOOR_FSM_SAME_STATE                     DOOR_STATES
+
+/* Payload: row, state, event, next, count (2), last_us (4), max_us (4) */
+#define DOOR_FSM_TRANSITION_FRAME_SIZE          14
+
+/*------------------------------------------------------------------------------
+ *  Data Types Declarations
+ *----------------------------------------------------------------------------*/
+
+typedef struct
+{
+    uint8 state;                /* DOOR_StateType or DOOR_FSM_ANY_STATE */
+    uint8 event;                /* DOOR_EventType */
+    uint8 next;                 /* DOOR_StateType or DOOR_FSM_SAME_STATE */
+    void (*action)(void);       /* Runs between the exit and the entry action, may be NULL */
+} DOOR_FSM_TransitionType;
+
+typedef struct
+{
+    void (*entry)(void);        /* May be NULL */
+    void (*exit)(void);         /* May be NULL */
+} DOOR_FSM_StateActionsType;
+
+/*------------------------------------------------------------------------------
+ *  Private Function Prototypes
+ *----------------------------------------------------------------------------*/
+
+static void DOOR_FSM_enterOpening(void);
+static void DOOR_FSM_enterHeld(void);
+static void DOOR_FSM_enterClosing(void);
+static void DOOR_FSM_enterLockdown(void);
+static void DOOR_FSM_enterFault(void);
+static void DOOR_FSM_stopMotor(void);
+static void DOOR_FSM_exitLockdown(void);
+static void DOOR_FSM_release(void);
+static void DOOR_FSM_closed(void);
+static void DOOR_FSM_lockdownServed(void);
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+/*
+ * Searched from the top, the first matching row wins. Every state leaves on
+ * the timeout of the timer its entry action started, only the fault leaves
+ * a state earlier, and the fault state ignores the late timeout.
+ */
+static const DOOR_FSM_TransitionType g_transitions[] =
+{
+    {DOOR_STATE_LOCKED,   DOOR_EVENT_OPEN,      DOOR_STATE_OPENING,  NULL},
+    {DOOR_STATE_LOCKED,   DOOR_EVENT_LOCKDOWN,  DOOR_STATE_LOCKDOWN, NULL},
+    {DOOR_STATE_OPENING,  DOOR_EVENT_TIMEOUT,   DOOR_STATE_HELD,     NULL},
+    {DOOR_STATE_HELD,     DOOR_EVENT_PIR_CLEAR, DOOR_FSM_SAME_STATE, DOOR_FSM_release},
+    {DOOR_STATE_HELD,     DOOR_EVENT_TIMEOUT,   DOOR_STATE_CLOSING,  NULL},
+    {DOOR_STATE_CLOSING,  DOOR_EVENT_TIMEOUT,   DOOR_STATE_LOCKED,   DOOR_FSM_closed},
+    {DOOR_STATE_LOCKDOWN, DOOR_EVENT_TIMEOUT,   DOOR_STATE_LOCKED,   DOOR_FSM_lockdownServed},
+    {DOOR_STATE_FAULT,    DOOR_EVENT_FAULT,     DOOR_FSM_SAME_STATE, NULL},
+    {DOOR_FSM_ANY_STATE,  DOOR_EVENT_FAULT,     DOOR_STATE_FAULT,    NULL}
+};
+
+#define DOOR_FSM_TRANSITIONS    (sizeof(g_transitions) / sizeof(g_transitions[0]))
+
+/* Indexed by DOOR_StateType */
+static const DOOR_FSM_StateActionsType g_state_actions[DOOR_STATES] =
+{
+    {NULL,                   NULL},                     /* DOOR_STATE_LOCKED */
+    {DOOR_FSM_enterOpening,  DOOR_FSM_stopMotor},       /* DOOR_STATE_OPENING */
+    {DOOR_FSM_enterHeld,     NULL},                     /* DOOR_STATE_HELD */
+    {DOOR_FSM_enterClosing,  DOOR_FSM_stopMotor},       /* DOOR_STATE_CLOSING */
+    {DOOR_FSM_enterLockdown, DOOR_FSM_exitLockdown},    /* DOOR_STATE_LOCKDOWN */
+    {DOOR_FSM_enterFault,    NULL}                      /* DOOR_STATE_FAULT */
+};
+
+static DOOR_TransitionStatsType g_stats[DOOR_FSM_TRANSITIONS];
+
+static DOOR_StateType g_state = DOOR_STATE_LOCKED;
+static uint16 g_user = 0;
+
+/* Set by the held state once the HMI was told the way is clear */
+static boolean g_released = FALSE;
+
+/* Set by an action whose timer could not be started */
+static boolean g_fault_pending = FALSE;
+
+/* Time of the first motor or buzzer change of the running transition */
+static boolean g_actuated = FALSE;
+static uint32 g_actuated_us = 0;
+
+/* Posted back as the timer event data */
+static uint8 g_timer_tag = DOOR_TIMER_TAG;
+
+/*------------------------------------------------------------------------------
+ *  Private Functions
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] DOOR_FSM_timerExpired
+ * [Description]   Software timer callback (tick interrupt), queues the
+ *                 timeout for the door task.
+ *----------------------------------------------------------------------------*/
+static void DOOR_FSM_timerExpired(void *context)
+{
+    EVENT_QUEUE_post(EVENT_TIMER_EXPIRED, *(uint8 *)context);
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] DOOR_FSM_startTimer
+ * [Description]   Starts the timer ending the current state, raises a fault
+ *                 when no software timer is free.
+ *----------------------------------------------------------------------------*/
+static void DOOR_FSM_startTimer(uint32 milliseconds)
+{
+    if (SW_TIMER_start(milliseconds, SW_TIMER_ONE_SHOT, DOOR_FSM_timerExpired, &g_timer_tag)
+        == SW_TIMER_INVALID_ID)
+    {
+        g_fault_pending = TRUE;
+    }
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] DOOR_FSM_actuated
+ * [Description]   Notes the time of the first actuator change of the
+ *                 running transition.
+ *----------------------------------------------------------------------------*/
+static void DOOR_FSM_actuated(void)
+{
+    if (!g_actuated)
+    {
+        g_actuated_us = SW_TIMER_micros();
+        g_actuated = TRUE;
+    }
+}
+
+static void DOOR_FSM_motor(DC_MOTOR_State state)
+{
+    DC_MOTOR_rotate(state, (state == STOP) ? 0 : DOOR_FSM_MOTOR_SPEED);
+    DOOR_FSM_actuated();
+}
+
+static void DOOR_FSM_buzzer(boolean on)
+{
+    if (on)
+    {
+        BUZZER_on();
+    }
+    else
+    {
+        BUZZER_off();
+    }
+    DOOR_FSM_actuated();
+}
+
+/* Entry and exit actions */
+
+static void DOOR_FSM_enterOpening(void)
+{
+    AUDIT_log(AUDIT_EVENT_DOOR_OPENED, g_user);
+    DOOR_FSM_motor(CLOCKWISE);
+    DOOR_FSM_startTimer(DOOR_MOTOR_TIME_MS);
+}
+
+static void DOOR_FSM_enterHeld(void)
+{
+    g_released = FALSE;
+
+    /* Nobody in the way already, no PIR edge will come */
+    if (!PIR_getState())
+    {
+        DOOR_FSM_release();
+    }
+}
+
+static void DOOR_FSM_enterClosing(void)
+{
+    DOOR_FSM_motor(ANTI_CLOCKWISE);
+    DOOR_FSM_startTimer(DOOR_MOTOR_TIME_MS);
+}
+
+static void DOOR_FSM_enterLockdown(void)
+{
+    DOOR_FSM_buzzer(TRUE);
+    AUDIT_log(AUDIT_EVENT_LOCKDOWN_START, 0);
+    DOOR_FSM_startTimer(LOCK_DOWN_TIME_MS);
+}
+
+static void DOOR_FSM_enterFault(void)
+{
+    DOOR_FSM_motor(STOP);
+    DOOR_FSM_buzzer(TRUE);
+}
+
+static void DOOR_FSM_stopMotor(void)
+{
+    DOOR_FSM_motor(STOP);
+}
+
+static void DOOR_FSM_exitLockdown(void)
+{
+    DOOR_FSM_buzzer(FALSE);
+}
+
+/* Transition actions */
+
+/*------------------------------------------------------------------------------
+ * [Function Name] DOOR_FSM_release
+ * [Description]   Tells the HMI the way is clear and lets the motor rest
+ *                 DOOR_REVERSE_DELAY_MS before closing. Once per hold.
+ *----------------------------------------------------------------------------*/
+static void DOOR_FSM_release(void)
+{
+    if (g_released)
+    {
+        return;
+    }
+
+    UART_sendByte(CLEAR);
+    DOOR_FSM_startTimer(DOOR_REVERSE_DELAY_MS);
+    g_released = TRUE;
+}
+
+static void DOOR_FSM_closed(void)
+{
+    AUDIT_log(AUDIT_EVENT_DOOR_CLOSED, g_user);
+}
+
+static void DOOR_FSM_lockdownServed(void)
+{
+    UART_sendByte(CLEAR);
+    AUDIT_log(AUDIT_EVENT_LOCKDOWN_END, 0);
+
+    /* Lockdown served, the persistent failure count starts over */
+    if (LOCKOUT_reset() == ERROR)
+    {
+        AUDIT_log(AUDIT_EVENT_STORAGE_ERROR, LOCKOUT_AREA_ADDRESS);
+    }
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] DOOR_FSM_run
+ * [Description]   Looks the transition up and runs its actions.
+ *----------------------------------------------------------------------------*/
+static void DOOR_FSM_run(DOOR_EventType event, uint32 event_time_us)
+{
+    const DOOR_FSM_TransitionType *transition = NULL;
+    uint8 row;
+    uint32 latency;
+
+    for (row = 0; row < DOOR_FSM_TRANSITIONS; row++)
+    {
+        if ((g_transitions[row].event == event) &&
+            ((g_transitions[row].state == g_state) || (g_transitions[row].state == DOOR_FSM_ANY_STATE)))
+        {
+            transition = &g_transitions[row];
+            break;
+        }
+    }
+
+    if (transition == NULL)
+    {
+        return;
+    }
+
+    g_actuated = FALSE;
+
+    if (transition->next == DOOR_FSM_SAME_STATE)
+    {
+        if (transition->action != NULL)
+        {
+            transition->action();
+        }
+    }
+    else
+    {
+        if (g_state_actions[g_state].exit != NULL)
+        {
+            g_state_actions[g_state].exit();
+        }
+        if (transition->action != NULL)
+        {
+            transition->action();
+        }
+        g_state = (DOOR_StateType)transition->next;
+        if (g_state_actions[g_state].entry != NULL)
+        {
+            g_state_actions[g_state].entry();
+        }
+    }
+
+    /* Transitions moving neither the motor nor the buzzer count until their actions are done */
+    latency = (g_actuated ? g_actuated_us : SW_TIMER_micros()) - event_time_us;
+
+    if (g_stats[row].count != 0xFFFF)
+    {
+        g_stats[row].count++;
+    }
+    g_stats[row].last_us = latency;
+    if (latency > g_stats[row].max_us)
+    {
+        g_stats[row].max_us = latency;
+    }
+}
+
+static uint8 DOOR_FSM_put32(uint8 *buffer, uint8 offset, uint32 value)
+{
+    uint8 byte_idx;
+
+    for (byte_idx = 0; byte_idx < 4; byte_idx++)
+    {
+        buffer[offset++] = (uint8)(value >> (8 * byte_idx));
+    }
+
+    return offset;
+}
+
+/*------------------------------------------------------------------------------
+ *  Functions Definitions
+ *----------------------------------------------------------------------------*/
+
+void DOOR_FSM_init(void)
+{
+    uint8 row;
+
+    for (row = 0; row < DOOR_FSM_TRANSITIONS; row++)
+    {
+        g_stats[row].count = 0;
+        g_stats[row].last_us = 0;
+        g_stats[row].max_us = 0;
+    }
+
+    g_state = DOOR_STATE_LOCKED;
+    g_released = FALSE;
+    g_fault_pending = FALSE;
+}
+
+void DOOR_FSM_dispatch(DOOR_EventType event, uint32 event_time_us)
+{
+    DOOR_FSM_run(event, event_time_us);
+
+    /* An action failed to start its timer, the door would never move on */
+    if (g_fault_pending)
+    {
+        g_fault_pending = FALSE;
+        DOOR_FSM_run(DOOR_EVENT_FAULT, SW_TIMER_micros());
+    }
+}
+
+DOOR_StateType DOOR_FSM_getState(void)
+{
+    return g_state;
+}
+
+void DOOR_FSM_setUser(uint16 user)
+{
+    g_user = user;
+}
+
+boolean DOOR_FSM_getStats(uint8 row, DOOR_TransitionStatsType *stats)
+{
+    if (row >= DOOR_FSM_TRANSITIONS)
+    {
+        return FALSE;
+    }
+
+    *stats = g_stats[row];
+
+    return TRUE;
+}
+
+boolean DOOR_FSM_exportFrame(uint8 frame, void (*a_send)(uint8))
+{
+    uint8 payload[DOOR_FSM_TRANSITION_FRAME_SIZE];
+    uint8 offset;
+
+    if (frame < DOOR_FSM_TRANSITIONS)
+    {
+        payload[0] = frame;
+        payload[1] = g_transitions[frame].state;
+        payload[2] = g_transitions[frame].event;
+        payload[3] = g_transitions[frame].next;
+        payload[4] = (uint8)g_stats[frame].count;
+        payload[5] = (uint8)(g_stats[frame].count >> 8);
+        offset = DOOR_FSM_put32(payload, 6, g_stats[frame].last_us);
+        offset = DOOR_FSM_put32(payload, offset, g_stats[frame].max_us);
+
+        DIAG_sendFrame(a_send, DIAG_FRAME_DOOR_TRANSITION, payload, offset);
+        return TRUE;
+    }
+
+    payload[0] = (uint8)g_state;
+    payload[1] = (uint8)DOOR_FSM_TRANSITIONS;
+    DIAG_sendFrame(a_send, DIAG_FRAME_DOOR_STATE, payload, 2);
+
+    return FALSE;
+}
@@ -0,0 +1,102 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Door State Machine
+ *  File        : door_fsm.h
+ *  Description : Header file for the table driven door lifecycle (locked,
+ *                opening, held open, closing, lockdown, fault) driving the
+ *                motor and the buzzer, with the latency of every transition
+ *                from its event to the actuator change
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+#ifndef DOOR_FSM_H_
+#define DOOR_FSM_H_
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "stdtypes.h"
+
+/*------------------------------------------------------------------------------
+ *  Data Types Declarations
+ *----------------------------------------------------------------------------*/
+
+typedef enum
+{
+    DOOR_STATE_LOCKED,      /* Closed, waiting for an open or a lockdown request */
+    DOOR_STATE_OPENING,     /* Motor opening for DOOR_MOTOR_TIME_MS */
+    DOOR_STATE_HELD,        /* Open until the PIR sensor clears, then a short pause */
+    DOOR_STATE_CLOSING,     /* Motor closing for DOOR_MOTOR_TIME_MS */
+    DOOR_STATE_LOCKDOWN,    /* Buzzer on for LOCK_DOWN_TIME_MS */
+    DOOR_STATE_FAULT,       /* Motor stopped and buzzer on until the next reset */
+    DOOR_STATES
+} DOOR_StateType;
+
+typedef enum
+{
+    DOOR_EVENT_OPEN,        /* Link: START_MOTOR after an accepted password */
+    DOOR_EVENT_LOCKDOWN,    /* Link: SYSTEM_LOCK_SEQUENCE after too many attempts */
+    DOOR_EVENT_TIMEOUT,     /* The timer started by the current state expired */
+    DOOR_EVENT_PIR_CLEAR,   /* The PIR sensor stopped detecting somebody */
+    DOOR_EVENT_FAULT,       /* An action could not be carried out */
+    DOOR_EVENTS
+} DOOR_EventType;
+
+typedef struct
+{
+    uint16 count;           /* Times the transition was taken, saturating */
+    uint32 last_us;         /* Event to actuator change, last time */
+    uint32 max_us;          /* Event to actuator change, worst case */
+} DOOR_TransitionStatsType;
+
+/*------------------------------------------------------------------------------
+ *  Function Declarations
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] DOOR_FSM_init
+ * [Description]   Starts in DOOR_STATE_LOCKED and clears the statistics. The
+ *                 motor, buzzer, PIR and software timer drivers must be
+ *                 initialized.
+ *----------------------------------------------------------------------------*/
+void DOOR_FSM_init(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] DOOR_FSM_dispatch
+ * [Description]   Takes the transition matching the current state and the
+ *                 event (exit action, transition action, entry action) and
+ *                 records its latency from event_time_us (SW_TIMER_micros()
+ *                 when the event occurred). Events without a transition in
+ *                 the current state are ignored. Main loop only.
+ *----------------------------------------------------------------------------*/
+void DOOR_FSM_dispatch(DOOR_EventType event, uint32 event_time_us);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] DOOR_FSM_getState
+ * [Description]   Current state.
+ *----------------------------------------------------------------------------*/
+DOOR_StateType DOOR_FSM_getState(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] DOOR_FSM_setUser
+ * [Description]   User id logged with the next door opening and closing.
+ *----------------------------------------------------------------------------*/
+void DOOR_FSM_setUser(uint16 user);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] DOOR_FSM_getStats
+ * [Description]   Copies the statistics of transition table row 'row',
+ *                 returns FALSE past the last row.
+ *----------------------------------------------------------------------------*/
+boolean DOOR_FSM_getStats(uint8 row, DOOR_TransitionStatsType *stats);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] DOOR_FSM_exportFrame
+ * [Description]   Sends frame 'frame' of the statistics through a_send: one
+ *                 DIAG_FRAME_DOOR_TRANSITION frame per table row then a
+ *                 DIAG_FRAME_DOOR_STATE frame. Returns FALSE once the last
+ *                 frame has been sent.
+ *----------------------------------------------------------------------------*/
+boolean DOOR_FSM_exportFrame(uint8 frame, void (*a_send)(uint8));
+
+#endif /* DOOR_FSM_H_ */
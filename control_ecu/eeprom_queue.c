@@ -0,0 +1,232 @@
+/*------------------------------------------------------------------------------
+ *  Module      : EEPROM Write-Behind Queue
+ *  File        : eeprom_queue.c
+ *  Description : Source file for the RAM write-behind queue in front of the
+ *                external EEPROM
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "eeprom_queue.h"
+#include "external_eeprom.h"
+
+/*------------------------------------------------------------------------------
+ *  Data Types Declarations
+ *----------------------------------------------------------------------------*/
+
+typedef struct
+{
+    uint16 page_address;                /* First byte of the EEPROM page */
+    uint16 dirty_mask;                  /* One bit per queued byte, 0 = free entry */
+    uint8 age;                          /* Allocation order, lowest is the oldest */
+    uint8 data[EEPROM_PAGE_SIZE];       /* Page image (only dirty bytes are valid) */
+} EEPROM_QUEUE_EntryType;
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+static EEPROM_QUEUE_EntryType g_entries[EEPROM_QUEUE_ENTRIES];
+static uint8 g_next_age = 0;
+
+/*------------------------------------------------------------------------------
+ *  Private Functions
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] EEPROM_QUEUE_oldest
+ * [Description]   Index of the oldest used entry or EEPROM_QUEUE_ENTRIES.
+ *----------------------------------------------------------------------------*/
+static uint8 EEPROM_QUEUE_oldest(void)
+{
+    uint8 oldest = EEPROM_QUEUE_ENTRIES;
+    uint8 entry_idx;
+
+    for (entry_idx = 0; entry_idx < EEPROM_QUEUE_ENTRIES; entry_idx++)
+    {
+        if ((g_entries[entry_idx].dirty_mask != 0) &&
+            ((oldest == EEPROM_QUEUE_ENTRIES) ||
+             ((int8)(g_entries[entry_idx].age - g_entries[oldest].age) < 0)))
+        {
+            oldest = entry_idx;
+        }
+    }
+
+    return oldest;
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] EEPROM_QUEUE_commit
+ * [Description]   Writes one entry with a single page write. Clean bytes lying
+ *                 between dirty ones are read from the EEPROM first so the
+ *                 page write covers one contiguous range.
+ *----------------------------------------------------------------------------*/
+static uint8 EEPROM_QUEUE_commit(uint8 entry_idx)
+{
+    EEPROM_QUEUE_EntryType *entry = &g_entries[entry_idx];
+    uint8 first = 0;
+    uint8 last = EEPROM_PAGE_SIZE - 1;
+    uint8 offset;
+
+    while (!(entry->dirty_mask & (1u << first)))
+    {
+        first++;
+    }
+    while (!(entry->dirty_mask & (1u << last)))
+    {
+        last--;
+    }
+
+    for (offset = first; offset <= last; offset++)
+    {
+        if (!(entry->dirty_mask & (1u << offset)))
+        {
+            /* Hole in the range: fetch the current page content once */
+            uint8 current[EEPROM_PAGE_SIZE];
+
+            if (EEPROM_readBlock(entry->page_address, current, EEPROM_PAGE_SIZE) == ERROR)
+            {
+                return ERROR;
+            }
+
+            for (; offset <= last; offset++)
+            {
+                if (!(entry->dirty_mask & (1u << offset)))
+                {
+                    entry->data[offset] = current[offset];
+                }
+            }
+            break;
+        }
+    }
+
+    if (EEPROM_writePage(entry->page_address + first, &entry->data[first], (uint8)(last - first + 1)) == ERROR)
+    {
+        return ERROR;
+    }
+
+    entry->dirty_mask = 0;
+    return SUCCESS;
+}
+
+/*------------------------------------------------------------------------------
+ *  Functions Definitions
+ *----------------------------------------------------------------------------*/
+
+uint8 EEPROM_QUEUE_write(uint16 address, const uint8 *data, uint16 length)
+{
+    while (length > 0)
+    {
+        uint16 page_address = (uint16)(address & ~(EEPROM_PAGE_SIZE - 1));
+        uint8 offset = (uint8)(address & (EEPROM_PAGE_SIZE - 1));
+        uint8 chunk = (uint8)(EEPROM_PAGE_SIZE - offset);
+        uint8 entry_idx;
+        uint8 free_idx = EEPROM_QUEUE_ENTRIES;
+
+        if (chunk > length)
+        {
+            chunk = (uint8)length;
+        }
+
+        /* Coalesce with a queued write to the same page */
+        for (entry_idx = 0; entry_idx < EEPROM_QUEUE_ENTRIES; entry_idx++)
+        {
+            if (g_entries[entry_idx].dirty_mask == 0)
+            {
+                free_idx = entry_idx;
+            }
+            else if (g_entries[entry_idx].page_address == page_address)
+            {
+                break;
+            }
+        }
+
+        if (entry_idx == EEPROM_QUEUE_ENTRIES)
+        {
+            if (free_idx == EEPROM_QUEUE_ENTRIES)
+            {
+                /* Queue full: the caller pays for committing the oldest page */
+                free_idx = EEPROM_QUEUE_oldest();
+                if (EEPROM_QUEUE_commit(free_idx) == ERROR)
+                {
+                    return ERROR;
+                }
+            }
+
+            entry_idx = free_idx;
+            g_entries[entry_idx].page_address = page_address;
+            g_entries[entry_idx].age = g_next_age++;
+        }
+
+        for (; chunk > 0; chunk--, offset++, length--, address++)
+        {
+            g_entries[entry_idx].data[offset] = *data++;
+            g_entries[entry_idx].dirty_mask |= (uint16)(1u << offset);
+        }
+    }
+
+    return SUCCESS;
+}
+
+uint8 EEPROM_QUEUE_read(uint16 address, uint8 *data, uint16 length)
+{
+    uint8 entry_idx;
+    uint16 byte_idx;
+
+    if (EEPROM_readBlock(address, data, length) == ERROR)
+    {
+        return ERROR;
+    }
+
+    for (entry_idx = 0; entry_idx < EEPROM_QUEUE_ENTRIES; entry_idx++)
+    {
+        EEPROM_QUEUE_EntryType *entry = &g_entries[entry_idx];
+
+        if (entry->dirty_mask == 0)
+        {
+            continue;
+        }
+
+        for (byte_idx = 0; byte_idx < length; byte_idx++)
+        {
+            uint16 byte_address = (uint16)(address + byte_idx);
+
+            if (((byte_address & ~(EEPROM_PAGE_SIZE - 1)) == entry->page_address) &&
+                (entry->dirty_mask & (1u << (byte_address & (EEPROM_PAGE_SIZE - 1)))))
+            {
+                data[byte_idx] = entry->data[byte_address & (EEPROM_PAGE_SIZE - 1)];
+            }
+        }
+    }
+
+    return SUCCESS;
+}
+
+void EEPROM_QUEUE_service(void)
+{
+    uint8 oldest = EEPROM_QUEUE_oldest();
+
+    /* One page per call, and only if the memory would not make us wait */
+    if ((oldest != EEPROM_QUEUE_ENTRIES) && EEPROM_isReady())
+    {
+        EEPROM_QUEUE_commit(oldest);
+    }
+}
+
+uint8 EEPROM_QUEUE_flush(void)
+{
+    uint8 oldest;
+
+    while ((oldest = EEPROM_QUEUE_oldest()) != EEPROM_QUEUE_ENTRIES)
+    {
+        if (EEPROM_QUEUE_commit(oldest) == ERROR)
+        {
+            return ERROR;
+        }
+    }
+
+    return SUCCESS;
+}
@@ -0,0 +1,61 @@
+/*------------------------------------------------------------------------------
+ *  Module      : EEPROM Write-Behind Queue
+ *  File        : eeprom_queue.h
+ *  Description : Header file for the RAM write-behind queue in front of the
+ *                external EEPROM: writes return immediately, writes to the
+ *                same page are coalesced and pages are committed when the
+ *                system is idle
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+#ifndef EEPROM_QUEUE_H_
+#define EEPROM_QUEUE_H_
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "stdtypes.h"
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/* Number of EEPROM pages that can wait in RAM (EEPROM_PAGE_SIZE + 4 bytes each) */
+#define EEPROM_QUEUE_ENTRIES                    4
+
+/*------------------------------------------------------------------------------
+ *  Function Declarations
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] EEPROM_QUEUE_write
+ * [Description]   Queues a write of any length. Bytes for a page already in
+ *                 the queue are merged into it. Only blocks when all entries
+ *                 are taken, the oldest one is then committed first.
+ *----------------------------------------------------------------------------*/
+uint8 EEPROM_QUEUE_write(uint16 address, const uint8 *data, uint16 length);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] EEPROM_QUEUE_read
+ * [Description]   Reads from the EEPROM and overlays the queued bytes so the
+ *                 caller always sees its own writes.
+ *----------------------------------------------------------------------------*/
+uint8 EEPROM_QUEUE_read(uint16 address, uint8 *data, uint16 length);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] EEPROM_QUEUE_service
+ * [Description]   Idle-time work: commits the oldest page if the memory is not
+ *                 in a write cycle. Never waits on the memory.
+ *----------------------------------------------------------------------------*/
+void EEPROM_QUEUE_service(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] EEPROM_QUEUE_flush
+ * [Description]   Durability barrier: every queued page has been handed to the
+ *                 memory when it returns. The last write cycle completes on
+ *                 its own (tWR), the next EEPROM access waits for it.
+ *----------------------------------------------------------------------------*/
+uint8 EEPROM_QUEUE_flush(void);
+
+#endif /* EEPROM_QUEUE_H_ */
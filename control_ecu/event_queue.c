@@ -0,0 +1,117 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Event Queue
+ *  File        : event_queue.c
+ *  Description : Source file for the queue carrying the interrupt events
+ *                (received UART bytes, timer expiries, PIR edges) to the
+ *                scheduler
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "event_queue.h"
+#include "sw_timer.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+#define EVENT_QUEUE_INDEX_MASK                  (EVENT_QUEUE_SIZE - 1)
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+/*
+ * Single producer (the interrupts) / single consumer (the main loop).
+ * g_tail is only written by the producer and g_head only by the consumer,
+ * both are free running bytes so reading or writing one is atomic and
+ * (g_tail - g_head) is the number of queued events, even across the wrap.
+ * The slots are volatile so the compiler keeps an event written before the
+ * g_tail store publishing it, and read before the g_head store releasing it.
+ */
+static volatile EVENT_Type g_events[EVENT_QUEUE_SIZE];
+static volatile uint8 g_head = 0;
+static volatile uint8 g_tail = 0;
+
+/* Written by the producer only, saturates at 0xFFFF */
+static volatile uint16 g_dropped_count = 0;
+
+/*------------------------------------------------------------------------------
+ *  Functions Definitions
+ *----------------------------------------------------------------------------*/
+
+void EVENT_QUEUE_init(void)
+{
+    uint8 sreg = SREG;
+
+    cli();
+    g_head = 0;
+    g_tail = 0;
+    g_dropped_count = 0;
+    SREG = sreg;
+}
+
+boolean EVENT_QUEUE_post(uint8 id, uint8 data)
+{
+    uint8 tail = g_tail;
+
+    if ((uint8)(tail - g_head) >= EVENT_QUEUE_SIZE)
+    {
+        if (g_dropped_count != 0xFFFF)
+        {
+            g_dropped_count++;
+        }
+        return FALSE;
+    }
+
+    g_events[tail & EVENT_QUEUE_INDEX_MASK].id = id;
+    g_events[tail & EVENT_QUEUE_INDEX_MASK].data = data;
+    g_events[tail & EVENT_QUEUE_INDEX_MASK].time_us = SW_TIMER_micros();
+
+    /* Publishes the event */
+    g_tail = (uint8)(tail + 1);
+
+    return TRUE;
+}
+
+boolean EVENT_QUEUE_get(EVENT_Type *event)
+{
+    uint8 head = g_head;
+
+    if (head == g_tail)
+    {
+        return FALSE;
+    }
+
+    event->id = g_events[head & EVENT_QUEUE_INDEX_MASK].id;
+    event->data = g_events[head & EVENT_QUEUE_INDEX_MASK].data;
+    event->time_us = g_events[head & EVENT_QUEUE_INDEX_MASK].time_us;
+
+    /* Releases the slot to the producer */
+    g_head = (uint8)(head + 1);
+
+    return TRUE;
+}
+
+boolean EVENT_QUEUE_isEmpty(void)
+{
+    return (g_head == g_tail) ? TRUE : FALSE;
+}
+
+uint16 EVENT_QUEUE_getDroppedCount(void)
+{
+    uint16 count;
+
+    /* Two byte read without disabling interrupts: repeat until no post came in between */
+    do
+    {
+        count = g_dropped_count;
+    } while (count != g_dropped_count);
+
+    return count;
+}
@@ -0,0 +1,88 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Event Queue
+ *  File        : event_queue.h
+ *  Description : Header file for the queue carrying the interrupt events
+ *                (received UART bytes, timer expiries, PIR edges) to the
+ *                scheduler
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+#ifndef EVENT_QUEUE_H_
+#define EVENT_QUEUE_H_
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "stdtypes.h"
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/* Number of events the queue holds, a power of two up to 128 */
+#define EVENT_QUEUE_SIZE                        16
+
+#if ((EVENT_QUEUE_SIZE & (EVENT_QUEUE_SIZE - 1)) != 0) || (EVENT_QUEUE_SIZE > 128)
+#error "EVENT_QUEUE_SIZE must be a power of two up to 128"
+#endif
+
+/*------------------------------------------------------------------------------
+ *  Data Types Declarations
+ *----------------------------------------------------------------------------*/
+
+typedef enum
+{
+    EVENT_UART_BYTE,        /* data: received byte */
+    EVENT_TIMER_EXPIRED,    /* data: tag of the software timer */
+    EVENT_PIR_EDGE,         /* data: new PIR state */
+    EVENT_TYPES
+} EVENT_IdType;
+
+typedef struct
+{
+    uint8 id;               /* EVENT_IdType */
+    uint8 data;
+    uint32 time_us;         /* SW_TIMER_micros() when it was posted */
+} EVENT_Type;
+
+/*------------------------------------------------------------------------------
+ *  Function Declarations
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] EVENT_QUEUE_init
+ * [Description]   Empties the queue and clears the dropped event count.
+ *----------------------------------------------------------------------------*/
+void EVENT_QUEUE_init(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] EVENT_QUEUE_post
+ * [Description]   Appends an event stamped with the current time, returns
+ *                 FALSE and counts it as dropped when the queue is full. Never disables interrupts.
+ *                 Interrupt context only: the ISRs do not nest, so together
+ *                 they are the single producer the queue allows.
+ *----------------------------------------------------------------------------*/
+boolean EVENT_QUEUE_post(uint8 id, uint8 data);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] EVENT_QUEUE_get
+ * [Description]   Removes the oldest event, returns FALSE when empty.
+ *                 Main loop only (the single consumer).
+ *----------------------------------------------------------------------------*/
+boolean EVENT_QUEUE_get(EVENT_Type *event);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] EVENT_QUEUE_isEmpty
+ * [Description]   TRUE when no event is waiting.
+ *----------------------------------------------------------------------------*/
+boolean EVENT_QUEUE_isEmpty(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] EVENT_QUEUE_getDroppedCount
+ * [Description]   Events refused because the queue was full since init,
+ *                 saturating at 0xFFFF.
+ *----------------------------------------------------------------------------*/
+uint16 EVENT_QUEUE_getDroppedCount(void);
+
+#endif /* EVENT_QUEUE_H_ */
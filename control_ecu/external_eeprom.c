@@ -1,82 +1,285 @@
- /******************************************************************************
- *
- * Module: External EEPROM
- *
- * File Name: external_eeprom.c
- *
- * Description: Source file for the External EEPROM Memory
- *
- * Author: Mohamed Tarek
- *
- *******************************************************************************/
-#include "external_eeprom.h"
-#include "twi.h"
-
-uint8 EEPROM_writeByte(uint16 u16addr, uint8 u8data)
-{
-	/* Send the Start Bit */
-    TWI_start();
-    if (TWI_getStatus() != TWI_START)
-        return ERROR;
-		
-    /* Send the device address, we need to get A8 A9 A10 address bits from the
-     * memory location address and R/W=0 (write) */
-    TWI_writeByte((uint8)(0xA0 | ((u16addr & 0x0700)>>7)));
-    if (TWI_getStatus() != TWI_MT_SLA_W_ACK)
-        return ERROR; 
-		 
-    /* Send the required memory location address */
-    TWI_writeByte((uint8)(u16addr));
-    if (TWI_getStatus() != TWI_MT_DATA_ACK)
-        return ERROR;
-		
-    /* write byte to eeprom */
-    TWI_writeByte(u8data);
-    if (TWI_getStatus() != TWI_MT_DATA_ACK)
-        return ERROR;
-
-    /* Send the Stop Bit */
-    TWI_stop();
-	
-    return SUCCESS;
-}
-
-uint8 EEPROM_readByte(uint16 u16addr, uint8 *u8data)
-{
-	/* Send the Start Bit */
-    TWI_start();
-    if (TWI_getStatus() != TWI_START)
-        return ERROR;
-		
-    /* Send the device address, we need to get A8 A9 A10 address bits from the
-     * memory location address and R/W=0 (write) */
-    TWI_writeByte((uint8)((0xA0) | ((u16addr & 0x0700)>>7)));
-    if (TWI_getStatus() != TWI_MT_SLA_W_ACK)
-        return ERROR;
-		
-    /* Send the required memory location address */
-    TWI_writeByte((uint8)(u16addr));
-    if (TWI_getStatus() != TWI_MT_DATA_ACK)
-        return ERROR;
-		
-    /* Send the Repeated Start Bit */
-    TWI_start();
-    if (TWI_getStatus() != TWI_REP_START)
-        return ERROR;
-		
-    /* Send the device address, we need to get A8 A9 A10 address bits from the
-     * memory location address and R/W=1 (Read) */
-    TWI_writeByte((uint8)((0xA0) | ((u16addr & 0x0700)>>7) | 1));
-    if (TWI_getStatus() != TWI_MT_SLA_R_ACK)
-        return ERROR;
-
-    /* Read Byte from Memory without send ACK */
-    *u8data = TWI_readByteWithNACK();
-    if (TWI_getStatus() != TWI_MR_DATA_NACK)
-        return ERROR;
-
-    /* Send the Stop Bit */
-    TWI_stop();
-
-    return SUCCESS;
-}
+ /******************************************************************************
+ *
+ * Module: External EEPROM
+ *
+ * File Name: external_eeprom.c
+ *
+ * Description: Source file for the External EEPROM Memory
+ *
+ * Author: Mohamed Tarek
+ *
+ *******************************************************************************/
+#include "external_eeprom.h"
+#include "twi.h"
+#include "twi_trace.h"
+#include "profile.h"
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Function responsible for addressing the memory for a write (or for the dummy
+ * write of a random read): it keeps sending START + SLA+W while the memory is
+ * busy programming a previous page, then sends the memory location address.
+ */
+static uint8 EEPROM_beginTransaction(uint16 u16addr);
+
+/*
+ * Transactions behind the public functions, which only add the trace
+ * timestamps around them (compiled out with TWI_TRACE_ENABLE = 0).
+ */
+static uint8 EEPROM_performWriteByte(uint16 u16addr, uint8 u8data);
+static uint8 EEPROM_performReadByte(uint16 u16addr, uint8 *u8data);
+static uint8 EEPROM_performWritePage(uint16 u16addr, const uint8 *u8data, uint8 u8length);
+static uint8 EEPROM_performReadBlock(uint16 u16addr, uint8 *u8data, uint16 u16length);
+static uint8 EEPROM_performWaitReady(void);
+static boolean EEPROM_performReadyPoll(void);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+uint8 EEPROM_writeByte(uint16 u16addr, uint8 u8data)
+{
+    uint8 result;
+
+    TWI_TRACE_BEGIN(TWI_TRACE_OP_WRITE_BYTE);
+    result = EEPROM_performWriteByte(u16addr, u8data);
+    TWI_TRACE_END(result);
+
+    return result;
+}
+
+uint8 EEPROM_readByte(uint16 u16addr, uint8 *u8data)
+{
+    uint8 result;
+
+    TWI_TRACE_BEGIN(TWI_TRACE_OP_READ_BYTE);
+    result = EEPROM_performReadByte(u16addr, u8data);
+    TWI_TRACE_END(result);
+
+    return result;
+}
+
+uint8 EEPROM_writePage(uint16 u16addr, const uint8 *u8data, uint8 u8length)
+{
+    uint8 result;
+
+    TWI_TRACE_BEGIN(TWI_TRACE_OP_WRITE_PAGE);
+    result = EEPROM_performWritePage(u16addr, u8data, u8length);
+    TWI_TRACE_END(result);
+
+    return result;
+}
+
+uint8 EEPROM_readBlock(uint16 u16addr, uint8 *u8data, uint16 u16length)
+{
+    uint8 result;
+
+    PROFILE_BEGIN(PROFILE_EEPROM_READ_BLOCK);
+    TWI_TRACE_BEGIN(TWI_TRACE_OP_READ_BLOCK);
+    result = EEPROM_performReadBlock(u16addr, u8data, u16length);
+    TWI_TRACE_END(result);
+    PROFILE_END(PROFILE_EEPROM_READ_BLOCK);
+
+    return result;
+}
+
+uint8 EEPROM_waitReady(void)
+{
+    uint8 result;
+
+    TWI_TRACE_BEGIN(TWI_TRACE_OP_WAIT_READY);
+    result = EEPROM_performWaitReady();
+    TWI_TRACE_END(result);
+
+    return result;
+}
+
+boolean EEPROM_isReady(void)
+{
+    boolean ready;
+
+    TWI_TRACE_BEGIN(TWI_TRACE_OP_READY_POLL);
+    ready = EEPROM_performReadyPoll();
+    TWI_TRACE_END(SUCCESS);
+
+    return ready;
+}
+
+static uint8 EEPROM_performWriteByte(uint16 u16addr, uint8 u8data)
+{
+    /* Address the memory (waits for any previous write cycle to finish) */
+    if (EEPROM_beginTransaction(u16addr) == ERROR)
+        return ERROR;
+		
+    /* write byte to eeprom */
+    TWI_writeByte(u8data);
+    if (TWI_getStatus() != TWI_MT_DATA_ACK)
+        return ERROR;
+
+    /* Send the Stop Bit */
+    TWI_stop();
+	
+    return SUCCESS;
+}
+
+static uint8 EEPROM_performReadByte(uint16 u16addr, uint8 *u8data)
+{
+    /* Address the memory (waits for any previous write cycle to finish) */
+    if (EEPROM_beginTransaction(u16addr) == ERROR)
+        return ERROR;
+		
+    /* Send the Repeated Start Bit */
+    TWI_start();
+    if (TWI_getStatus() != TWI_REP_START)
+        return ERROR;
+		
+    /* Send the device address, we need to get A8 A9 A10 address bits from the
+     * memory location address and R/W=1 (Read) */
+    TWI_writeByte((uint8)((0xA0) | ((u16addr & 0x0700)>>7) | 1));
+    if (TWI_getStatus() != TWI_MT_SLA_R_ACK)
+        return ERROR;
+
+    /* Read Byte from Memory without send ACK */
+    *u8data = TWI_readByteWithNACK();
+    if (TWI_getStatus() != TWI_MR_DATA_NACK)
+        return ERROR;
+
+    /* Send the Stop Bit */
+    TWI_stop();
+
+    return SUCCESS;
+}
+
+static uint8 EEPROM_performWritePage(uint16 u16addr, const uint8 *u8data, uint8 u8length)
+{
+    uint8 i;
+
+    /* The memory wraps inside the page, refuse a range crossing its end */
+    if ((u8length == 0) ||
+        (((u16addr & (EEPROM_PAGE_SIZE - 1)) + u8length) > EEPROM_PAGE_SIZE))
+        return ERROR;
+
+    /* Address the memory (waits for any previous write cycle to finish) */
+    if (EEPROM_beginTransaction(u16addr) == ERROR)
+        return ERROR;
+
+    /* Fill the page buffer of the memory */
+    for (i = 0; i < u8length; i++)
+    {
+        TWI_writeByte(u8data[i]);
+        if (TWI_getStatus() != TWI_MT_DATA_ACK)
+            return ERROR;
+    }
+
+    /* Send the Stop Bit, the memory programs the page after it */
+    TWI_stop();
+
+    return SUCCESS;
+}
+
+static uint8 EEPROM_performReadBlock(uint16 u16addr, uint8 *u8data, uint16 u16length)
+{
+    uint16 i;
+
+    if (u16length == 0)
+        return ERROR;
+
+    /* Address the memory (waits for any previous write cycle to finish) */
+    if (EEPROM_beginTransaction(u16addr) == ERROR)
+        return ERROR;
+
+    /* Send the Repeated Start Bit */
+    TWI_start();
+    if (TWI_getStatus() != TWI_REP_START)
+        return ERROR;
+
+    /* Send the device address with R/W=1 (Read) */
+    TWI_writeByte((uint8)((0xA0) | ((u16addr & 0x0700)>>7) | 1));
+    if (TWI_getStatus() != TWI_MT_SLA_R_ACK)
+        return ERROR;
+
+    /* Read all bytes with ACK except the last one, the memory increments its
+     * address counter after each byte */
+    for (i = 0; i < (u16length - 1); i++)
+    {
+        u8data[i] = TWI_readByteWithACK();
+        if (TWI_getStatus() != TWI_MR_DATA_ACK)
+            return ERROR;
+    }
+
+    /* Read the last byte without ACK to end the sequential read */
+    u8data[i] = TWI_readByteWithNACK();
+    if (TWI_getStatus() != TWI_MR_DATA_NACK)
+        return ERROR;
+
+    /* Send the Stop Bit */
+    TWI_stop();
+
+    return SUCCESS;
+}
+
+static uint8 EEPROM_performWaitReady(void)
+{
+    /* Address any location then release the bus without transferring data */
+    if (EEPROM_beginTransaction(0) == ERROR)
+        return ERROR;
+
+    TWI_stop();
+
+    return SUCCESS;
+}
+
+static boolean EEPROM_performReadyPoll(void)
+{
+    boolean ready;
+
+    /* Send the Start Bit */
+    TWI_start();
+    if (TWI_getStatus() != TWI_START)
+        return FALSE;
+
+    /* Send the device address of block 0 with R/W=0, the memory ACKs only when idle */
+    TWI_writeByte(0xA0);
+    ready = (TWI_getStatus() == TWI_MT_SLA_W_ACK) ? TRUE : FALSE;
+
+    /* Send the Stop Bit */
+    TWI_stop();
+
+    return ready;
+}
+
+static uint8 EEPROM_beginTransaction(uint16 u16addr)
+{
+    uint8 poll;
+
+    for (poll = 0; poll < EEPROM_ACK_POLL_LIMIT; poll++)
+    {
+        /* Send the Start Bit */
+        TWI_start();
+        if (TWI_getStatus() != TWI_START)
+            return ERROR;
+
+        /* Send the device address, we need to get A8 A9 A10 address bits from the
+         * memory location address and R/W=0 (write) */
+        TWI_writeByte((uint8)(0xA0 | ((u16addr & 0x0700)>>7)));
+        if (TWI_getStatus() == TWI_MT_SLA_W_ACK)
+        {
+            /* Send the required memory location address */
+            TWI_writeByte((uint8)(u16addr));
+            if (TWI_getStatus() != TWI_MT_DATA_ACK)
+                return ERROR;
+
+            TWI_TRACE_ADDRESSED();
+            return SUCCESS;
+        }
+
+        /* No ACK, the memory is still in its write cycle. Release the bus and retry */
+        TWI_stop();
+        TWI_TRACE_RETRY();
+    }
+
+    return ERROR;
+}
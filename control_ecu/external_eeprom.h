@@ -22,11 +22,50 @@
 #define ERROR 0
 #define SUCCESS 1
 
+/* 24C16 geometry: 2 KBytes organized as 128 pages of 16 bytes */
+#define EEPROM_SIZE                 2048
+#define EEPROM_PAGE_SIZE            16
+
+/*
+ * Number of START + SLA+W attempts made while the memory is busy in its
+ * internal write cycle (it NACKs its address until the cycle is over).
+ */
+#define EEPROM_ACK_POLL_LIMIT       250
+
 /*******************************************************************************
  *                      Functions Prototypes                                   *
  *******************************************************************************/
 
 uint8 EEPROM_writeByte(uint16 u16addr,uint8 u8data);
 uint8 EEPROM_readByte(uint16 u16addr,uint8 *u8data);
- 
+
+/*
+ * Description :
+ * Write up to EEPROM_PAGE_SIZE bytes in one page write transaction.
+ * The range must not cross a page boundary, the memory would wrap around
+ * inside the page and overwrite its first bytes.
+ * The function returns once the STOP is sent, the memory then programs the
+ * whole page in one internal write cycle.
+ */
+uint8 EEPROM_writePage(uint16 u16addr, const uint8 *u8data, uint8 u8length);
+
+/*
+ * Description :
+ * Read a block of bytes using one sequential read transaction.
+ */
+uint8 EEPROM_readBlock(uint16 u16addr, uint8 *u8data, uint16 u16length);
+
+/*
+ * Description :
+ * Block until the memory finished its internal write cycle (acknowledge polling).
+ */
+uint8 EEPROM_waitReady(void);
+
+/*
+ * Description :
+ * Single acknowledge poll: returns TRUE if the memory answers its address
+ * (no write cycle running), never blocks on a busy memory.
+ */
+boolean EEPROM_isReady(void);
+
 #endif /* EXTERNAL_EEPROM_H_ */
@@ -0,0 +1,154 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Internal EEPROM Driver
+ *  File        : internal_eeprom.c
+ *  Description : Source file for the ATmega32 on-chip EEPROM driver with
+ *                interrupt driven (EE_RDY) writes
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "internal_eeprom.h"
+#include "external_eeprom.h"
+#include "bit_manipulation.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+/* Block being written by the EE_RDY interrupt */
+static uint8 g_write_buffer[INTERNAL_EEPROM_WRITE_BUFFER_SIZE];
+static volatile uint16 g_write_address = 0;
+static volatile uint8 g_write_index = 0;
+static volatile uint8 g_write_length = 0;
+
+/*------------------------------------------------------------------------------
+ *  Private Functions
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] INTERNAL_EEPROM_readByte
+ * [Description]   Reads one byte, the EEPROM must not be writing.
+ *----------------------------------------------------------------------------*/
+static uint8 INTERNAL_EEPROM_readByte(uint16 address)
+{
+    EEAR = address;
+    SET_BIT(EECR, EERE);
+    return EEDR;
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] INTERNAL_EEPROM_startNextByte
+ * [Description]   Starts programming the next byte that differs from the
+ *                 EEPROM content. Returns FALSE when the block is complete.
+ *                 Called with interrupts disabled (EEMWE must be followed by
+ *                 EEWE within four cycles).
+ *----------------------------------------------------------------------------*/
+static boolean INTERNAL_EEPROM_startNextByte(void)
+{
+    while (g_write_index < g_write_length)
+    {
+        uint16 address = g_write_address + g_write_index;
+        uint8 value = g_write_buffer[g_write_index];
+
+        g_write_index++;
+
+        if (INTERNAL_EEPROM_readByte(address) != value)
+        {
+            EEAR = address;
+            EEDR = value;
+            EECR |= (1 << EEMWE);
+            EECR |= (1 << EEWE);
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/*------------------------------------------------------------------------------
+ *  Functions Definitions
+ *----------------------------------------------------------------------------*/
+
+uint8 INTERNAL_EEPROM_readBlock(uint16 address, uint8 *data, uint16 length)
+{
+    uint16 byte_idx;
+
+    if ((uint32)address + length > INTERNAL_EEPROM_SIZE)
+    {
+        return ERROR;
+    }
+
+    /* A read cannot start while a byte is programmed */
+    while (INTERNAL_EEPROM_isBusy()) {}
+
+    for (byte_idx = 0; byte_idx < length; byte_idx++)
+    {
+        data[byte_idx] = INTERNAL_EEPROM_readByte(address + byte_idx);
+    }
+
+    return SUCCESS;
+}
+
+uint8 INTERNAL_EEPROM_writeBlock(uint16 address, const uint8 *data, uint8 length)
+{
+    uint8 byte_idx;
+    uint8 sreg;
+
+    if ((length == 0) || (length > INTERNAL_EEPROM_WRITE_BUFFER_SIZE) ||
+        ((uint32)address + length > INTERNAL_EEPROM_SIZE))
+    {
+        return ERROR;
+    }
+
+    while (INTERNAL_EEPROM_isBusy()) {}
+
+    for (byte_idx = 0; byte_idx < length; byte_idx++)
+    {
+        g_write_buffer[byte_idx] = data[byte_idx];
+    }
+
+    sreg = SREG;
+    cli();
+
+    g_write_address = address;
+    g_write_index = 0;
+    g_write_length = length;
+
+    /* Program the first byte here, the EE_RDY interrupt chains the others */
+    if (INTERNAL_EEPROM_startNextByte())
+    {
+        SET_BIT(EECR, EERIE);
+    }
+    else
+    {
+        g_write_length = 0; /* Nothing differs */
+    }
+
+    SREG = sreg;
+
+    return SUCCESS;
+}
+
+boolean INTERNAL_EEPROM_isBusy(void)
+{
+    return (IS_BIT_SET(EECR, EERIE) || IS_BIT_SET(EECR, EEWE)) ? TRUE : FALSE;
+}
+
+/*------------------------------------------------------------------------------
+ *  Interrupt Service Routines
+ *----------------------------------------------------------------------------*/
+
+ISR(EE_RDY_vect)   // ISR for EEPROM ready, previous byte programmed
+{
+    if (!INTERNAL_EEPROM_startNextByte())
+    {
+        /* Block complete, EE_RDY keeps firing while enabled */
+        CLEAR_BIT(EECR, EERIE);
+        g_write_length = 0;
+    }
+}
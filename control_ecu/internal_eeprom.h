@@ -0,0 +1,55 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Internal EEPROM Driver
+ *  File        : internal_eeprom.h
+ *  Description : Header file for the ATmega32 on-chip EEPROM driver with
+ *                interrupt driven (EE_RDY) writes
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+#ifndef INTERNAL_EEPROM_H_
+#define INTERNAL_EEPROM_H_
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "stdtypes.h"
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/* ATmega32 on-chip EEPROM size */
+#define INTERNAL_EEPROM_SIZE                    1024
+
+/* Largest block a single INTERNAL_EEPROM_writeBlock() call may queue */
+#define INTERNAL_EEPROM_WRITE_BUFFER_SIZE       16
+
+/*------------------------------------------------------------------------------
+ *  Function Declarations
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] INTERNAL_EEPROM_readBlock
+ * [Description]   Reads bytes, waiting first for a running write to finish.
+ *                 Returns SUCCESS or ERROR (range outside the EEPROM).
+ *----------------------------------------------------------------------------*/
+uint8 INTERNAL_EEPROM_readBlock(uint16 address, uint8 *data, uint16 length);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] INTERNAL_EEPROM_writeBlock
+ * [Description]   Copies the bytes into the driver buffer and returns; the
+ *                 EE_RDY interrupt programs them one after the other. Bytes
+ *                 that already hold the new value are skipped (each byte
+ *                 write takes ~8.5 ms). Waits if a previous block is still
+ *                 being written. Global interrupts must be enabled.
+ *----------------------------------------------------------------------------*/
+uint8 INTERNAL_EEPROM_writeBlock(uint16 address, const uint8 *data, uint8 length);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] INTERNAL_EEPROM_isBusy
+ * [Description]   TRUE while a block is being written.
+ *----------------------------------------------------------------------------*/
+boolean INTERNAL_EEPROM_isBusy(void);
+
+#endif /* INTERNAL_EEPROM_H_ */
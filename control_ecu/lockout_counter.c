@@ -0,0 +1,174 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Lockout Counter
+ *  File        : lockout_counter.c
+ *  Description : Source file for the persistent failed-attempt counter kept
+ *                in the external EEPROM so a power cycle does not reset it
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "lockout_counter.h"
+#include "external_eeprom.h"
+#include "eeprom_queue.h"
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+/* Offset of the active byte, LOCKOUT_AREA_SIZE when the area is used up */
+static uint8 g_active_offset = 0;
+
+/* Failures encoded in the active byte */
+static uint8 g_failures = 0;
+
+/*------------------------------------------------------------------------------
+ *  Private Functions
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] LOCKOUT_decode
+ * [Description]   Number of cleared low bits of a counter byte. A value that
+ *                 is not a valid unary pattern (torn write) counts as the
+ *                 maximum so a power cut can never lower the count.
+ *----------------------------------------------------------------------------*/
+static uint8 LOCKOUT_decode(uint8 value)
+{
+    uint8 count;
+
+    for (count = 0; count <= LOCKOUT_COUNTER_BITS; count++)
+    {
+        if (value == (uint8)(0xFF << count))
+        {
+            return count;
+        }
+    }
+
+    return LOCKOUT_COUNTER_BITS;
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] LOCKOUT_eraseArea
+ * [Description]   Sets the whole area back to 0xFF, first byte active.
+ *----------------------------------------------------------------------------*/
+static uint8 LOCKOUT_eraseArea(void)
+{
+    uint8 page[EEPROM_PAGE_SIZE];
+    uint8 offset;
+
+    for (offset = 0; offset < EEPROM_PAGE_SIZE; offset++)
+    {
+        page[offset] = 0xFF;
+    }
+
+    for (offset = 0; offset < LOCKOUT_AREA_SIZE; offset += EEPROM_PAGE_SIZE)
+    {
+        if (EEPROM_QUEUE_write(LOCKOUT_AREA_ADDRESS + offset, page, EEPROM_PAGE_SIZE) == ERROR)
+        {
+            return ERROR;
+        }
+    }
+
+    g_active_offset = 0;
+    return SUCCESS;
+}
+
+/*------------------------------------------------------------------------------
+ *  Functions Definitions
+ *----------------------------------------------------------------------------*/
+
+void LOCKOUT_init(void)
+{
+    uint8 area[LOCKOUT_AREA_SIZE];
+
+    g_active_offset = LOCKOUT_AREA_SIZE;
+    g_failures = 0;
+
+    if (EEPROM_QUEUE_read(LOCKOUT_AREA_ADDRESS, area, LOCKOUT_AREA_SIZE) == ERROR)
+    {
+        /* Unreadable counter: fail safe, a lockdown is owed */
+        g_failures = LOCKOUT_MAX_FAILURES;
+        return;
+    }
+
+    for (g_active_offset = 0; g_active_offset < LOCKOUT_AREA_SIZE; g_active_offset++)
+    {
+        if (area[g_active_offset] != LOCKOUT_RETIRED_BYTE)
+        {
+            g_failures = LOCKOUT_decode(area[g_active_offset]);
+            break;
+        }
+    }
+}
+
+uint8 LOCKOUT_recordFailure(void)
+{
+    uint8 value;
+
+    if (g_failures >= LOCKOUT_COUNTER_BITS)
+    {
+        return SUCCESS; /* Saturated, nothing to write */
+    }
+
+    /* Counted first: a failed write must not make the attempt free */
+    g_failures++;
+
+    if ((g_active_offset >= LOCKOUT_AREA_SIZE) && (LOCKOUT_eraseArea() == ERROR))
+    {
+        return ERROR;
+    }
+
+    value = (uint8)(0xFF << g_failures);
+    if (EEPROM_QUEUE_write(LOCKOUT_AREA_ADDRESS + g_active_offset, &value, 1) == ERROR)
+    {
+        return ERROR;
+    }
+
+    /* A failure must reach the memory before the reply, it is merged with a
+     * pending retire of the previous byte when both share a page */
+    return EEPROM_QUEUE_flush();
+}
+
+uint8 LOCKOUT_reset(void)
+{
+    uint8 value;
+    uint8 result;
+
+    if (g_failures == 0)
+    {
+        return SUCCESS; /* Coalesced: the stored count is already zero */
+    }
+
+    /* Committed at once: a retire lost to a power cut would lock out the user who just succeeded */
+    if (g_active_offset >= LOCKOUT_AREA_SIZE)
+    {
+        /* Area used up or unread: past its end is the audit ring, an erased area stores zero */
+        result = LOCKOUT_eraseArea();
+    }
+    else
+    {
+        value = LOCKOUT_RETIRED_BYTE;
+        result = EEPROM_QUEUE_write(LOCKOUT_AREA_ADDRESS + g_active_offset, &value, 1);
+        g_active_offset++;
+    }
+    g_failures = 0;
+
+    if (result == ERROR)
+    {
+        return ERROR;
+    }
+
+    return EEPROM_QUEUE_flush();
+}
+
+uint8 LOCKOUT_getFailures(void)
+{
+    return g_failures;
+}
+
+boolean LOCKOUT_isLocked(void)
+{
+    return (g_failures >= LOCKOUT_MAX_FAILURES) ? TRUE : FALSE;
+}
@@ -0,0 +1,81 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Lockout Counter
+ *  File        : lockout_counter.h
+ *  Description : Header file for the persistent failed-attempt counter kept
+ *                in the external EEPROM so a power cycle does not reset it
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+#ifndef LOCKOUT_COUNTER_H_
+#define LOCKOUT_COUNTER_H_
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "stdtypes.h"
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/* Counter area in the 24C16 (four pages) */
+#define LOCKOUT_AREA_ADDRESS                    0x0000
+#define LOCKOUT_AREA_SIZE                       64
+
+/* Failures after which a lockdown is owed (same as the HMI attempts limit) */
+#define LOCKOUT_MAX_FAILURES                    3
+
+/*------------------------------------------------------------------------------
+ * Encoding:
+ *   The counter is unary inside one byte of the area, the "active" byte is
+ *   the first one that is not 0x00. Each failure clears one more bit
+ *   (0xFF -> 0xFE -> 0xFC ...) so it costs a single byte write. A reset
+ *   retires the active byte by writing 0x00, the next byte becomes active.
+ *   The area is erased (four page writes) only after all 64 bytes were
+ *   retired, which spreads the wear over the whole area.
+ *----------------------------------------------------------------------------*/
+#define LOCKOUT_COUNTER_BITS                    7
+#define LOCKOUT_RETIRED_BYTE                    0x00
+
+/*------------------------------------------------------------------------------
+ *  Function Declarations
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] LOCKOUT_init
+ * [Description]   Reads the counter area (one sequential read) at boot.
+ *----------------------------------------------------------------------------*/
+void LOCKOUT_init(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] LOCKOUT_recordFailure
+ * [Description]   Counts one failed attempt, at most one byte write. Returns
+ *                 ERROR if the count could not be stored, it is counted in
+ *                 RAM anyway.
+ *----------------------------------------------------------------------------*/
+uint8 LOCKOUT_recordFailure(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] LOCKOUT_reset
+ * [Description]   Clears the count after a success or a served lockdown, the
+ *                 retire reaches the memory before it returns. No EEPROM
+ *                 access when the count is already zero. Returns ERROR if
+ *                 the stored count could not be retired, it then comes back
+ *                 after a power cycle.
+ *----------------------------------------------------------------------------*/
+uint8 LOCKOUT_reset(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] LOCKOUT_getFailures
+ * [Description]   Current failure count.
+ *----------------------------------------------------------------------------*/
+uint8 LOCKOUT_getFailures(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] LOCKOUT_isLocked
+ * [Description]   TRUE while a lockdown is owed (survives power cycles).
+ *----------------------------------------------------------------------------*/
+boolean LOCKOUT_isLocked(void);
+
+#endif /* LOCKOUT_COUNTER_H_ */
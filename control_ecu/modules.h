@@ -18,6 +18,7 @@
 #include "uart.h"
 #include "timer.h"
 #include "twi.h"
+#include "internal_eeprom.h"
 
 /* HCAL */
 #include "pir_sensor.h"
@@ -25,6 +26,22 @@
 #include "buzzer.h"
 #include "external_eeprom.h"
 
+/* Services */
+#include "credential_store.h"
+#include "user_table.h"
+#include "audit_log.h"
+#include "lockout_counter.h"
+#include "eeprom_queue.h"
+#include "sw_timer.h"
+#include "crc.h"
+#include "diag_link.h"
+#include "twi_trace.h"
+#include "event_queue.h"
+#include "scheduler.h"
+#include "door_fsm.h"
+#include "task_monitor.h"
+#include "profile.h"
+
 /* Utility */
 #include "stdtypes.h"
 #include "bit_manipulation.h"
@@ -0,0 +1,202 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Profiler
+ *  File        : profile.c
+ *  Description : Source file for the CPU cycle counter (TIMER1 free running
+ *                without prescaler, extended by its overflow interrupt) and
+ *                the profiling regions keeping count/min/max/total cycles
+ *                in RAM
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "profile.h"
+#include "timer.h"
+#include "diag_link.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/* Payload: id, count (2), min (4), max (4), total (4) */
+#define PROFILE_REGION_FRAME_SIZE               15
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+/* TIMER1 normal mode on the CPU clock, one overflow every 65536 cycles (8.2 ms at 8 MHz) */
+static const TIMER_ConfigType g_PROFILE_clockConfiguration =
+    TIMER_CONFIG(TIMER_TIMER1, TIMER_NO_PRESCALING, TIMER_OVERFLOW_MODE, 0, 0);
+
+/* Upper 16 bits of the cycle count */
+static volatile uint16 g_overflows = 0;
+static boolean g_clock_running = FALSE;
+
+#if (PROFILE_ENABLE)
+static PROFILE_StatsType g_stats[PROFILE_REGIONS];
+static uint32 g_begin_cycles[PROFILE_REGIONS];
+
+/* Cycles a begin/end pair adds to every measure */
+static uint16 g_overhead_cycles = 0;
+#endif
+
+/*------------------------------------------------------------------------------
+ *  Private Functions
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] PROFILE_overflow
+ * [Description]   TIMER1 overflow callback, extends the counter.
+ *----------------------------------------------------------------------------*/
+static void PROFILE_overflow(void *context)
+{
+    (void)context;
+
+    g_overflows++;
+}
+
+#if (PROFILE_ENABLE)
+static uint8 PROFILE_put16(uint8 *buffer, uint8 offset, uint16 value)
+{
+    buffer[offset++] = (uint8)value;
+    buffer[offset++] = (uint8)(value >> 8);
+
+    return offset;
+}
+
+static uint8 PROFILE_put32(uint8 *buffer, uint8 offset, uint32 value)
+{
+    offset = PROFILE_put16(buffer, offset, (uint16)value);
+    return PROFILE_put16(buffer, offset, (uint16)(value >> 16));
+}
+#endif
+
+/*------------------------------------------------------------------------------
+ *  Functions Definitions
+ *----------------------------------------------------------------------------*/
+
+void PROFILE_init(void)
+{
+    if (!g_clock_running)
+    {
+        g_overflows = 0;
+        TIMER_setCallBack(PROFILE_overflow, NULL, TIMER_CALLBACK_PERIODIC, 1, TIMER_TIMER1);
+        TIMER_init(&g_PROFILE_clockConfiguration);
+        g_clock_running = TRUE;
+    }
+
+#if (PROFILE_ENABLE)
+    {
+        uint32 start = PROFILE_getCycles();
+
+        g_overhead_cycles = (uint16)(PROFILE_getCycles() - start);
+    }
+
+    PROFILE_reset();
+#endif
+}
+
+uint32 PROFILE_getCycles(void)
+{
+    uint16 high;
+    uint16 count;
+    uint8 sreg;
+
+    sreg = SREG;
+    cli();
+    high = g_overflows;
+    count = TCNT1;
+
+    /* The counter wrapped but the overflow interrupt is still pending */
+    if ((TIFR & (1 << TOV1)) && (count < 0x8000))
+    {
+        high++;
+    }
+    SREG = sreg;
+
+    return ((uint32)high << 16) | count;
+}
+
+#if (PROFILE_ENABLE)
+
+void PROFILE_begin(PROFILE_RegionType id)
+{
+    if (id < PROFILE_REGIONS)
+    {
+        g_begin_cycles[id] = PROFILE_getCycles();
+    }
+}
+
+void PROFILE_end(PROFILE_RegionType id)
+{
+    uint32 cycles = PROFILE_getCycles();
+    PROFILE_StatsType *stats;
+
+    if (id >= PROFILE_REGIONS)
+    {
+        return;
+    }
+
+    stats = &g_stats[id];
+    cycles -= g_begin_cycles[id];
+    cycles = (cycles > g_overhead_cycles) ? (cycles - g_overhead_cycles) : 0;
+
+    if (stats->count != 0xFFFF)
+    {
+        stats->count++;
+    }
+    if (cycles < stats->min_cycles)
+    {
+        stats->min_cycles = cycles;
+    }
+    if (cycles > stats->max_cycles)
+    {
+        stats->max_cycles = cycles;
+    }
+    stats->total_cycles = ((stats->total_cycles + cycles) < stats->total_cycles) ?
+                          0xFFFFFFFF : (stats->total_cycles + cycles);
+}
+
+void PROFILE_reset(void)
+{
+    uint8 id;
+
+    for (id = 0; id < PROFILE_REGIONS; id++)
+    {
+        g_stats[id].count = 0;
+        g_stats[id].min_cycles = 0xFFFFFFFF;
+        g_stats[id].max_cycles = 0;
+        g_stats[id].total_cycles = 0;
+    }
+}
+
+boolean PROFILE_exportFrame(uint8 frame, void (*a_send)(uint8))
+{
+    uint8 payload[PROFILE_REGION_FRAME_SIZE];
+    uint8 offset;
+
+    if (frame < PROFILE_REGIONS)
+    {
+        payload[0] = frame;
+        offset = PROFILE_put16(payload, 1, g_stats[frame].count);
+        offset = PROFILE_put32(payload, offset, g_stats[frame].min_cycles);
+        offset = PROFILE_put32(payload, offset, g_stats[frame].max_cycles);
+        offset = PROFILE_put32(payload, offset, g_stats[frame].total_cycles);
+
+        DIAG_sendFrame(a_send, DIAG_FRAME_PROFILE_REGION, payload, offset);
+        return TRUE;
+    }
+
+    payload[0] = (uint8)(F_CPU / 1000000UL);
+    offset = PROFILE_put16(payload, 1, g_overhead_cycles);
+    DIAG_sendFrame(a_send, DIAG_FRAME_PROFILE_END, payload, offset);
+
+    return FALSE;
+}
+
+#endif /* PROFILE_ENABLE */
@@ -0,0 +1,153 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Scheduler
+ *  File        : scheduler.c
+ *  Description : Source file for the run-to-completion cooperative scheduler
+ *                dispatching the queued events to the application tasks
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "scheduler.h"
+#if (SCHEDULER_TASK_MONITOR)
+#include "task_monitor.h"
+#endif
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+/*------------------------------------------------------------------------------
+ *  Data Types Declarations
+ *----------------------------------------------------------------------------*/
+
+typedef struct
+{
+    void (*handler)(const EVENT_Type *);
+    uint8 event_mask;
+} SCHEDULER_TaskType;
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+static SCHEDULER_TaskType g_tasks[SCHEDULER_MAX_TASKS];
+static uint8 g_task_count = 0;
+
+static void (*g_SCHEDULER_idleHookPtr)(void) = NULL;
+
+/*------------------------------------------------------------------------------
+ *  Private Functions
+ *----------------------------------------------------------------------------*/
+
+#if (SCHEDULER_IDLE_SLEEP)
+/*------------------------------------------------------------------------------
+ * [Function Name] SCHEDULER_sleep
+ * [Description]   Sleeps until the next interrupt if the queue is empty. The
+ *                 queue is checked with interrupts disabled, and the
+ *                 instruction following sei() always executes before a
+ *                 pending interrupt, so an event posted after the check
+ *                 wakes the CPU from sleep_cpu() instead of waiting in the
+ *                 queue until some later interrupt.
+ *----------------------------------------------------------------------------*/
+static void SCHEDULER_sleep(void)
+{
+    cli();
+    if (EVENT_QUEUE_isEmpty())
+    {
+        sleep_enable();
+        sei();
+        sleep_cpu();
+        sleep_disable();
+    }
+    sei();
+}
+#endif
+
+/*------------------------------------------------------------------------------
+ *  Functions Definitions
+ *----------------------------------------------------------------------------*/
+
+void SCHEDULER_init(void)
+{
+    g_task_count = 0;
+    g_SCHEDULER_idleHookPtr = NULL;
+    EVENT_QUEUE_init();
+
+#if (SCHEDULER_IDLE_SLEEP)
+    /* Idle keeps the timers, the UART and the TWI running */
+    set_sleep_mode(SLEEP_MODE_IDLE);
+#endif
+}
+
+SCHEDULER_TaskIdType SCHEDULER_addTask(void (*a_handler)(const EVENT_Type *), uint8 a_event_mask)
+{
+    if (g_task_count >= SCHEDULER_MAX_TASKS)
+    {
+        return SCHEDULER_INVALID_TASK;
+    }
+
+    g_tasks[g_task_count].handler = a_handler;
+    g_tasks[g_task_count].event_mask = a_event_mask;
+
+    return g_task_count++;
+}
+
+void SCHEDULER_setIdleHook(void (*a_ptr)(void))
+{
+    g_SCHEDULER_idleHookPtr = a_ptr;
+}
+
+void SCHEDULER_runOnce(void)
+{
+    EVENT_Type event;
+    uint8 task_idx;
+
+#if (SCHEDULER_TASK_MONITOR)
+    MONITOR_service();
+#endif
+
+    if (EVENT_QUEUE_get(&event))
+    {
+        /* Every subscribed task sees the event, in registration order */
+        for (task_idx = 0; task_idx < g_task_count; task_idx++)
+        {
+            if (g_tasks[task_idx].event_mask & SCHEDULER_EVENT_MASK(event.id))
+            {
+#if (SCHEDULER_TASK_MONITOR)
+                MONITOR_begin(task_idx);
+                g_tasks[task_idx].handler(&event);
+                MONITOR_end(task_idx);
+#else
+                g_tasks[task_idx].handler(&event);
+#endif
+            }
+        }
+    }
+    else
+    {
+        if (g_SCHEDULER_idleHookPtr != NULL)
+        {
+#if (SCHEDULER_TASK_MONITOR)
+            MONITOR_begin(MONITOR_IDLE_TASK);
+            g_SCHEDULER_idleHookPtr();
+            MONITOR_end(MONITOR_IDLE_TASK);
+#else
+            g_SCHEDULER_idleHookPtr();
+#endif
+        }
+
+#if (SCHEDULER_IDLE_SLEEP)
+        SCHEDULER_sleep();
+#endif
+    }
+}
+
+void SCHEDULER_run(void)
+{
+    for (;;)
+    {
+        SCHEDULER_runOnce();
+    }
+}
@@ -0,0 +1,96 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Scheduler
+ *  File        : scheduler.h
+ *  Description : Header file for the run-to-completion cooperative scheduler
+ *                dispatching the queued events to the application tasks
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "stdtypes.h"
+#include "event_queue.h"
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/* Maximum number of tasks */
+#define SCHEDULER_MAX_TASKS                     4
+
+/*
+ * Enter SLEEP_MODE_IDLE while no event is queued. Every enabled interrupt
+ * (UART receive, timer tick, external interrupts) wakes the CPU again.
+ */
+#ifndef SCHEDULER_IDLE_SLEEP
+#define SCHEDULER_IDLE_SLEEP                    1
+#endif
+
+/*
+ * Time every task run and the idle hook with the task monitor, which also
+ * feeds the watchdog from the main loop.
+ */
+#ifndef SCHEDULER_TASK_MONITOR
+#define SCHEDULER_TASK_MONITOR                  1
+#endif
+
+/* Subscription mask bit of an event id */
+#define SCHEDULER_EVENT_MASK(id)                ((uint8)(1 << (id)))
+
+/* Returned by SCHEDULER_addTask when the task table is full */
+#define SCHEDULER_INVALID_TASK                  0xFF
+
+/*------------------------------------------------------------------------------
+ *  Data Types Declarations
+ *----------------------------------------------------------------------------*/
+
+/* Task id, also the task monitor id of the task */
+typedef uint8 SCHEDULER_TaskIdType;
+
+/*------------------------------------------------------------------------------
+ *  Function Declarations
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] SCHEDULER_init
+ * [Description]   Removes all tasks and empties the event queue.
+ *----------------------------------------------------------------------------*/
+void SCHEDULER_init(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] SCHEDULER_addTask
+ * [Description]   Registers a task handler called with every event whose
+ *                 SCHEDULER_EVENT_MASK bit is set in a_event_mask. Handlers
+ *                 run to completion and must not busy wait. Returns the task
+ *                 id (pass it to MONITOR_setLimits) or SCHEDULER_INVALID_TASK
+ *                 when the task table is full.
+ *----------------------------------------------------------------------------*/
+SCHEDULER_TaskIdType SCHEDULER_addTask(void (*a_handler)(const EVENT_Type *), uint8 a_event_mask);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] SCHEDULER_setIdleHook
+ * [Description]   Registers background work run whenever no event is queued.
+ *----------------------------------------------------------------------------*/
+void SCHEDULER_setIdleHook(void (*a_ptr)(void));
+
+/*------------------------------------------------------------------------------
+ * [Function Name] SCHEDULER_runOnce
+ * [Description]   Services the task monitor, then dispatches the oldest
+ *                 event to its tasks. When the queue
+ *                 is empty it runs the idle hook, then sleeps until the next
+ *                 interrupt unless an event was posted meanwhile.
+ *----------------------------------------------------------------------------*/
+void SCHEDULER_runOnce(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] SCHEDULER_run
+ * [Description]   Main loop, never returns.
+ *----------------------------------------------------------------------------*/
+void SCHEDULER_run(void) __attribute__((noreturn));
+
+#endif /* SCHEDULER_H_ */
@@ -0,0 +1,231 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Task Monitor
+ *  File        : task_monitor.c
+ *  Description : Source file for the supervision of the scheduler tasks:
+ *                execution time and deadline miss accounting, hardware
+ *                watchdog fed only while every task is healthy, and the
+ *                task that was running kept across a watchdog reset
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "task_monitor.h"
+#include "sw_timer.h"
+#include "event_queue.h"
+#include "diag_link.h"
+#include <avr/io.h>
+#include <avr/wdt.h>
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/*
+ * Nominal 1 s (0.9 to 1.1 s with the supply voltage): more than twice the
+ * longest legitimate task run, a user removal (356 ms of bus time). The audit
+ * export takes about 1 s for a full ring and the TWI statistics 287 ms, so
+ * they are sent one frame per pass.
+ */
+#define MONITOR_WATCHDOG_TIMEOUT                WDTO_1S
+
+/* Marks the crash record as written by a previous run, RAM is random at power up */
+#define MONITOR_CRASH_MAGIC                     0xA5C3
+
+/* Payload: task, runs (2), misses (2), wcet_us (4), budget_us (4), period_ms (2) */
+#define MONITOR_STATS_FRAME_SIZE                15
+
+/*------------------------------------------------------------------------------
+ *  Data Types Declarations
+ *----------------------------------------------------------------------------*/
+
+typedef struct
+{
+    uint16 magic;
+    uint8 task;             /* Running task, MONITOR_NO_TASK between runs */
+} MONITOR_CrashRecordType;
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+/* Not cleared by the start up code, survives the watchdog reset */
+static volatile MONITOR_CrashRecordType g_crash __attribute__((section(".noinit")));
+
+static MONITOR_TaskStatsType g_stats[MONITOR_TASKS];
+static uint32 g_last_checkin_ms[MONITOR_TASKS];
+
+static uint32 g_begin_us = 0;
+
+/* Latched by MONITOR_init */
+static boolean g_watchdog_reset = FALSE;
+static uint8 g_reset_task = MONITOR_NO_TASK;
+
+/*------------------------------------------------------------------------------
+ *  Private Functions
+ *----------------------------------------------------------------------------*/
+
+static uint8 MONITOR_put16(uint8 *buffer, uint8 offset, uint16 value)
+{
+    buffer[offset++] = (uint8)value;
+    buffer[offset++] = (uint8)(value >> 8);
+
+    return offset;
+}
+
+static uint8 MONITOR_put32(uint8 *buffer, uint8 offset, uint32 value)
+{
+    offset = MONITOR_put16(buffer, offset, (uint16)value);
+    return MONITOR_put16(buffer, offset, (uint16)(value >> 16));
+}
+
+/*------------------------------------------------------------------------------
+ *  Functions Definitions
+ *----------------------------------------------------------------------------*/
+
+void MONITOR_init(void)
+{
+    uint8 task;
+
+    g_watchdog_reset = ((MCUCSR & (1 << WDRF)) && (g_crash.magic == MONITOR_CRASH_MAGIC)) ? TRUE : FALSE;
+    g_reset_task = g_watchdog_reset ? g_crash.task : MONITOR_NO_TASK;
+
+    /* The flag stays set until cleared, the next reset must not see it */
+    MCUCSR &= (uint8)~(1 << WDRF);
+
+    g_crash.magic = MONITOR_CRASH_MAGIC;
+    g_crash.task = MONITOR_NO_TASK;
+
+    for (task = 0; task < MONITOR_TASKS; task++)
+    {
+        g_stats[task].runs = 0;
+        g_stats[task].misses = 0;
+        g_stats[task].wcet_us = 0;
+        g_stats[task].budget_us = 0;
+        g_stats[task].period_ms = 0;
+        g_last_checkin_ms[task] = 0;
+    }
+
+    wdt_enable(MONITOR_WATCHDOG_TIMEOUT);
+}
+
+void MONITOR_setLimits(uint8 task, uint32 budget_us, uint16 period_ms)
+{
+    if (task >= MONITOR_TASKS)
+    {
+        return;
+    }
+
+    g_stats[task].budget_us = budget_us;
+    g_stats[task].period_ms = period_ms;
+    g_last_checkin_ms[task] = SW_TIMER_millis();
+}
+
+void MONITOR_begin(uint8 task)
+{
+    g_crash.task = task;
+    g_begin_us = SW_TIMER_micros();
+}
+
+void MONITOR_end(uint8 task)
+{
+    MONITOR_TaskStatsType *stats;
+    uint32 elapsed = SW_TIMER_micros() - g_begin_us;
+
+    g_crash.task = MONITOR_NO_TASK;
+
+    if (task >= MONITOR_TASKS)
+    {
+        return;
+    }
+
+    stats = &g_stats[task];
+
+    if (stats->runs != 0xFFFF)
+    {
+        stats->runs++;
+    }
+    if (elapsed > stats->wcet_us)
+    {
+        stats->wcet_us = elapsed;
+    }
+    if ((stats->budget_us != 0) && (elapsed > stats->budget_us) && (stats->misses != 0xFFFF))
+    {
+        stats->misses++;
+    }
+
+    g_last_checkin_ms[task] = SW_TIMER_millis();
+}
+
+void MONITOR_service(void)
+{
+    uint32 now = SW_TIMER_millis();
+    uint8 task;
+
+    for (task = 0; task < MONITOR_TASKS; task++)
+    {
+        if ((g_stats[task].period_ms != 0) &&
+            ((now - g_last_checkin_ms[task]) > g_stats[task].period_ms))
+        {
+            /* Starved or stuck: let the watchdog reset the controller */
+            return;
+        }
+    }
+
+    wdt_reset();
+}
+
+boolean MONITOR_wasWatchdogReset(uint8 *task)
+{
+    *task = g_reset_task;
+
+    return g_watchdog_reset;
+}
+
+boolean MONITOR_getStats(uint8 task, MONITOR_TaskStatsType *stats)
+{
+    if (task >= MONITOR_TASKS)
+    {
+        return FALSE;
+    }
+
+    *stats = g_stats[task];
+
+    return TRUE;
+}
+
+boolean MONITOR_exportFrame(uint8 frame, void (*a_send)(uint8))
+{
+    uint8 payload[MONITOR_STATS_FRAME_SIZE];
+    uint8 offset;
+
+    if (frame < MONITOR_TASKS)
+    {
+        payload[0] = frame;
+        offset = MONITOR_put16(payload, 1, g_stats[frame].runs);
+        offset = MONITOR_put16(payload, offset, g_stats[frame].misses);
+        offset = MONITOR_put32(payload, offset, g_stats[frame].wcet_us);
+        offset = MONITOR_put32(payload, offset, g_stats[frame].budget_us);
+        offset = MONITOR_put16(payload, offset, g_stats[frame].period_ms);
+
+        DIAG_sendFrame(a_send, DIAG_FRAME_TASK_STATS, payload, offset);
+        return TRUE;
+    }
+
+    if (frame == MONITOR_TASKS)
+    {
+        /* Events the interrupts could not queue: the tasks ran too long */
+        offset = MONITOR_put16(payload, 0, EVENT_QUEUE_getDroppedCount());
+        payload[offset++] = EVENT_QUEUE_SIZE;
+        DIAG_sendFrame(a_send, DIAG_FRAME_EVENT_QUEUE, payload, offset);
+        return TRUE;
+    }
+
+    payload[0] = g_watchdog_reset;
+    payload[1] = g_reset_task;
+    DIAG_sendFrame(a_send, DIAG_FRAME_TASK_RESET, payload, 2);
+
+    return FALSE;
+}
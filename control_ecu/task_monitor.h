@@ -0,0 +1,111 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Task Monitor
+ *  File        : task_monitor.h
+ *  Description : Header file for the supervision of the scheduler tasks:
+ *                execution time and deadline miss accounting, hardware
+ *                watchdog fed only while every task is healthy, and the
+ *                task that was running kept across a watchdog reset
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+#ifndef TASK_MONITOR_H_
+#define TASK_MONITOR_H_
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "stdtypes.h"
+#include "scheduler.h"
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/* The scheduler tasks (their registration index) and the idle hook */
+#define MONITOR_TASKS                           (SCHEDULER_MAX_TASKS + 1)
+#define MONITOR_IDLE_TASK                       SCHEDULER_MAX_TASKS
+
+/* No task was running */
+#define MONITOR_NO_TASK                         0xFF
+
+/*------------------------------------------------------------------------------
+ *  Data Types Declarations
+ *----------------------------------------------------------------------------*/
+
+typedef struct
+{
+    uint16 runs;            /* Completed runs (check-ins), saturating */
+    uint16 misses;          /* Runs longer than budget_us, saturating */
+    uint32 wcet_us;         /* Longest run */
+    uint32 budget_us;       /* Deadline of one run, 0 for none */
+    uint16 period_ms;       /* Longest time allowed between check-ins, 0 for event driven */
+} MONITOR_TaskStatsType;
+
+/*------------------------------------------------------------------------------
+ *  Function Declarations
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] MONITOR_init
+ * [Description]   Latches the cause of the last reset and the task running
+ *                 then, clears the statistics and enables the watchdog.
+ *                 Called first thing in main, the rest of the start up must
+ *                 finish within the watchdog timeout.
+ *----------------------------------------------------------------------------*/
+void MONITOR_init(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] MONITOR_setLimits
+ * [Description]   Sets the deadline of one run of 'task' and the longest
+ *                 time allowed between two of its check-ins. Needs the
+ *                 software timers running.
+ *----------------------------------------------------------------------------*/
+void MONITOR_setLimits(uint8 task, uint32 budget_us, uint16 period_ms);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] MONITOR_begin
+ * [Description]   A run of 'task' starts.
+ *----------------------------------------------------------------------------*/
+void MONITOR_begin(uint8 task);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] MONITOR_end
+ * [Description]   Check-in: the run of 'task' is over, its execution time is
+ *                 accounted.
+ *----------------------------------------------------------------------------*/
+void MONITOR_end(uint8 task);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] MONITOR_service
+ * [Description]   Feeds the watchdog unless a periodic task missed its
+ *                 check-in. Called from the main loop between task runs, a
+ *                 task stuck in a loop stops the feeding as well.
+ *----------------------------------------------------------------------------*/
+void MONITOR_service(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] MONITOR_wasWatchdogReset
+ * [Description]   TRUE when the last reset came from the watchdog, *task
+ *                 then holds the task that was running (MONITOR_NO_TASK if
+ *                 the main loop was between tasks).
+ *----------------------------------------------------------------------------*/
+boolean MONITOR_wasWatchdogReset(uint8 *task);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] MONITOR_getStats
+ * [Description]   Copies the statistics of 'task', FALSE for an invalid id.
+ *----------------------------------------------------------------------------*/
+boolean MONITOR_getStats(uint8 task, MONITOR_TaskStatsType *stats);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] MONITOR_exportFrame
+ * [Description]   Sends frame 'frame' of the statistics through a_send: one
+ *                 DIAG_FRAME_TASK_STATS frame per task, a
+ *                 DIAG_FRAME_EVENT_QUEUE frame ([dropped u16] [queue size])
+ *                 then a DIAG_FRAME_TASK_RESET frame. Returns FALSE once the
+ *                 last frame has been sent.
+ *----------------------------------------------------------------------------*/
+boolean MONITOR_exportFrame(uint8 frame, void (*a_send)(uint8));
+
+#endif /* TASK_MONITOR_H_ */
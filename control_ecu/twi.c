@@ -12,6 +12,7 @@
  
 #include "twi.h"
 #include "bit_manipulation.h"
+#include "twi_trace.h"
 #include <avr/io.h>
 
 void TWI_init(const TWI_ConfigType * Config_Ptr)
@@ -68,6 +69,20 @@ void TWI_writeByte(uint8 data)
     TWCR = (1 << TWINT) | (1 << TWEN);
     /* Wait for TWINT flag set in TWCR Register(data is send successfully) */
     while(IS_BIT_CLEAR(TWCR,TWINT));
+
+#if (TWI_TRACE_ENABLE)
+    /* Count the address and data bytes the slave did not acknowledge */
+    switch (TWSR & 0xF8)
+    {
+        case TWI_MT_SLA_W_NACK:
+        case TWI_MT_DATA_NACK:
+        case TWI_MT_SLA_R_NACK:
+            TWI_TRACE_NACK();
+            break;
+        default:
+            break;
+    }
+#endif
 }
 
 uint8 TWI_readByteWithACK(void)
@@ -0,0 +1,198 @@
+/*------------------------------------------------------------------------------
+ *  Module      : TWI Trace
+ *  File        : twi_trace.c
+ *  Description : Source file for the timing instrumentation of the external
+ *                EEPROM transactions (phase times, NACK/retry counters and a
+ *                latency histogram kept in RAM)
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "twi_trace.h"
+
+#if (TWI_TRACE_ENABLE)
+
+#include "diag_link.h"
+#include "external_eeprom.h"
+#include "profile.h"
+#include <avr/io.h>
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+#define TWI_TRACE_OPERATION_FRAME_SIZE          (15 + (2 * TWI_TRACE_BUCKETS))
+
+/* CPU cycles per tick */
+#define TWI_TRACE_TICK_CYCLES                   ((F_CPU / 1000000UL) * TWI_TRACE_TICK_US)
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+static TWI_TraceStatsType g_stats;
+
+/* Operation being measured */
+static TWI_TraceOpType g_current_op = TWI_TRACE_OPS;
+static uint16 g_begin_tick = 0;
+static uint16 g_addressed_tick = 0;
+
+/*------------------------------------------------------------------------------
+ *  Private Functions
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] TWI_TRACE_now
+ * [Description]   Current time in ticks, from the profiler cycle counter.
+ *----------------------------------------------------------------------------*/
+static uint16 TWI_TRACE_now(void)
+{
+    return (uint16)(PROFILE_getCycles() / TWI_TRACE_TICK_CYCLES);
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] TWI_TRACE_bucket
+ * [Description]   Histogram bucket of a duration (floor(log2), saturated).
+ *----------------------------------------------------------------------------*/
+static uint8 TWI_TRACE_bucket(uint16 ticks)
+{
+    uint8 bucket = 0;
+
+    while ((ticks > 1) && (bucket < (TWI_TRACE_BUCKETS - 1)))
+    {
+        ticks >>= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] TWI_TRACE_put16 / TWI_TRACE_put32
+ * [Description]   Store a little endian field, returns the next offset.
+ *----------------------------------------------------------------------------*/
+static uint8 TWI_TRACE_put16(uint8 *buffer, uint8 offset, uint16 value)
+{
+    buffer[offset] = (uint8)value;
+    buffer[offset + 1] = (uint8)(value >> 8);
+    return (uint8)(offset + 2);
+}
+
+static uint8 TWI_TRACE_put32(uint8 *buffer, uint8 offset, uint32 value)
+{
+    offset = TWI_TRACE_put16(buffer, offset, (uint16)value);
+    return TWI_TRACE_put16(buffer, offset, (uint16)(value >> 16));
+}
+
+/*------------------------------------------------------------------------------
+ *  Functions Definitions
+ *----------------------------------------------------------------------------*/
+
+void TWI_TRACE_init(void)
+{
+    /* TIMER1 is shared with the profiler, started once by whichever comes first */
+    PROFILE_init();
+
+    TWI_TRACE_reset();
+}
+
+void TWI_TRACE_begin(TWI_TraceOpType op)
+{
+    g_current_op = op;
+    g_begin_tick = TWI_TRACE_now();
+    g_addressed_tick = g_begin_tick;
+}
+
+void TWI_TRACE_addressed(void)
+{
+    g_addressed_tick = TWI_TRACE_now();
+}
+
+void TWI_TRACE_end(uint8 result)
+{
+    TWI_TraceOpStatsType *op_stats;
+    uint16 end_tick = TWI_TRACE_now();
+    uint16 total;
+
+    if (g_current_op >= TWI_TRACE_OPS)
+    {
+        return;
+    }
+
+    op_stats = &g_stats.op[g_current_op];
+    total = (uint16)(end_tick - g_begin_tick);
+
+    op_stats->count++;
+    if (result != SUCCESS)
+    {
+        op_stats->errors++;
+    }
+    if (total > op_stats->max_ticks)
+    {
+        op_stats->max_ticks = total;
+    }
+    op_stats->address_ticks += (uint16)(g_addressed_tick - g_begin_tick);
+    op_stats->transfer_ticks += (uint16)(end_tick - g_addressed_tick);
+    op_stats->histogram[TWI_TRACE_bucket(total)]++;
+
+    g_current_op = TWI_TRACE_OPS;
+}
+
+void TWI_TRACE_nack(void)
+{
+    g_stats.nacks++;
+}
+
+void TWI_TRACE_retry(void)
+{
+    g_stats.poll_retries++;
+}
+
+void TWI_TRACE_reset(void)
+{
+    uint16 byte_idx;
+    uint8 *bytes = (uint8 *)&g_stats;
+
+    for (byte_idx = 0; byte_idx < sizeof(g_stats); byte_idx++)
+    {
+        bytes[byte_idx] = 0;
+    }
+}
+
+boolean TWI_TRACE_exportFrame(uint8 frame, void (*a_send)(uint8))
+{
+    uint8 payload[TWI_TRACE_OPERATION_FRAME_SIZE];
+    uint8 bucket;
+    uint8 offset;
+
+    if (frame < TWI_TRACE_OPS)
+    {
+        const TWI_TraceOpStatsType *op_stats = &g_stats.op[frame];
+
+        payload[0] = frame;
+        offset = TWI_TRACE_put16(payload, 1, op_stats->count);
+        offset = TWI_TRACE_put16(payload, offset, op_stats->errors);
+        offset = TWI_TRACE_put16(payload, offset, op_stats->max_ticks);
+        offset = TWI_TRACE_put32(payload, offset, op_stats->address_ticks);
+        offset = TWI_TRACE_put32(payload, offset, op_stats->transfer_ticks);
+        for (bucket = 0; bucket < TWI_TRACE_BUCKETS; bucket++)
+        {
+            offset = TWI_TRACE_put16(payload, offset, op_stats->histogram[bucket]);
+        }
+
+        DIAG_sendFrame(a_send, DIAG_FRAME_TWI_OPERATION, payload, offset);
+        return TRUE;
+    }
+
+    offset = TWI_TRACE_put16(payload, 0, g_stats.nacks);
+    offset = TWI_TRACE_put16(payload, offset, g_stats.poll_retries);
+    payload[offset++] = TWI_TRACE_TICK_US;
+    DIAG_sendFrame(a_send, DIAG_FRAME_TWI_BUS, payload, offset);
+
+    return FALSE;
+}
+
+#endif /* TWI_TRACE_ENABLE */
@@ -0,0 +1,142 @@
+/*------------------------------------------------------------------------------
+ *  Module      : TWI Trace
+ *  File        : twi_trace.h
+ *  Description : Header file for the timing instrumentation of the external
+ *                EEPROM transactions (phase times, NACK/retry counters and a
+ *                latency histogram kept in RAM)
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+#ifndef TWI_TRACE_H_
+#define TWI_TRACE_H_
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "stdtypes.h"
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/* Set to 0 (e.g. -DTWI_TRACE_ENABLE=0) to compile the instrumentation out */
+#ifndef TWI_TRACE_ENABLE
+#define TWI_TRACE_ENABLE                        1
+#endif
+
+/*
+ * Time base: the profiler cycle counter (TIMER1) divided down to 8 us
+ * ticks, kept in 16 bits they wrap after 524 ms (longer operations are
+ * measured modulo the wrap).
+ */
+#define TWI_TRACE_TICK_US                       8
+
+/*
+ * Histogram bucket n counts operations of [2^n, 2^(n+1)) ticks, bucket 0
+ * also counts the shorter ones and the last bucket the longer ones
+ * (>= 16.4 ms, i.e. ones that waited for a write cycle).
+ */
+#define TWI_TRACE_BUCKETS                       12
+
+/*------------------------------------------------------------------------------
+ *  Data Types Declarations
+ *----------------------------------------------------------------------------*/
+
+typedef enum
+{
+    TWI_TRACE_OP_WRITE_BYTE,
+    TWI_TRACE_OP_READ_BYTE,
+    TWI_TRACE_OP_WRITE_PAGE,
+    TWI_TRACE_OP_READ_BLOCK,
+    TWI_TRACE_OP_WAIT_READY,
+    TWI_TRACE_OP_READY_POLL,
+    TWI_TRACE_OPS
+} TWI_TraceOpType;
+
+typedef struct
+{
+    uint16 count;
+    uint16 errors;
+    uint16 max_ticks;
+    uint32 address_ticks;   /* START until the memory address is acknowledged (ack polling included) */
+    uint32 transfer_ticks;  /* Data bytes until STOP */
+    uint16 histogram[TWI_TRACE_BUCKETS];
+} TWI_TraceOpStatsType;
+
+typedef struct
+{
+    uint16 nacks;           /* NACKs received for an address or data byte */
+    uint16 poll_retries;    /* START + SLA+W repeated while the memory was busy */
+    TWI_TraceOpStatsType op[TWI_TRACE_OPS];
+} TWI_TraceStatsType;
+
+/*------------------------------------------------------------------------------
+ *  Instrumentation Hooks
+ *----------------------------------------------------------------------------*/
+
+#if (TWI_TRACE_ENABLE)
+#define TWI_TRACE_BEGIN(op)                     TWI_TRACE_begin(op)
+#define TWI_TRACE_ADDRESSED()                   TWI_TRACE_addressed()
+#define TWI_TRACE_END(result)                   TWI_TRACE_end(result)
+#define TWI_TRACE_NACK()                        TWI_TRACE_nack()
+#define TWI_TRACE_RETRY()                       TWI_TRACE_retry()
+#else
+#define TWI_TRACE_BEGIN(op)                     ((void)0)
+#define TWI_TRACE_ADDRESSED()                   ((void)0)
+#define TWI_TRACE_END(result)                   ((void)0)
+#define TWI_TRACE_NACK()                        ((void)0)
+#define TWI_TRACE_RETRY()                       ((void)0)
+#endif
+
+#if (TWI_TRACE_ENABLE)
+
+/*------------------------------------------------------------------------------
+ *  Function Declarations
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] TWI_TRACE_init
+ * [Description]   Starts the profiler cycle counter if not running yet and
+ *                 clears the statistics.
+ *----------------------------------------------------------------------------*/
+void TWI_TRACE_init(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] TWI_TRACE_begin / TWI_TRACE_addressed / TWI_TRACE_end
+ * [Description]   Timestamp the start of an operation, the end of its
+ *                 addressing phase and its completion (SUCCESS or ERROR).
+ *                 Use them through the TWI_TRACE_xxx() macros.
+ *----------------------------------------------------------------------------*/
+void TWI_TRACE_begin(TWI_TraceOpType op);
+void TWI_TRACE_addressed(void);
+void TWI_TRACE_end(uint8 result);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] TWI_TRACE_nack / TWI_TRACE_retry
+ * [Description]   Count a NACK and an acknowledge polling retry.
+ *----------------------------------------------------------------------------*/
+void TWI_TRACE_nack(void);
+void TWI_TRACE_retry(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] TWI_TRACE_reset
+ * [Description]   Clears the statistics.
+ *----------------------------------------------------------------------------*/
+void TWI_TRACE_reset(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] TWI_TRACE_exportFrame
+ * [Description]   Sends frame 'frame' of the statistics over the diagnostics
+ *                 link: one DIAG_FRAME_TWI_OPERATION frame per operation type
+ *                 ([op] [count] [errors] [max_ticks] [address_ticks u32]
+ *                 [transfer_ticks u32] [histogram u16 x TWI_TRACE_BUCKETS])
+ *                 then one DIAG_FRAME_TWI_BUS frame ([nacks] [poll_retries]
+ *                 [tick_us]). Returns FALSE once the last frame has been
+ *                 sent.
+ *----------------------------------------------------------------------------*/
+boolean TWI_TRACE_exportFrame(uint8 frame, void (*a_send)(uint8));
+
+#endif /* TWI_TRACE_ENABLE */
+
+#endif /* TWI_TRACE_H_ */
@@ -13,6 +13,14 @@
 #include "uart.h"
 #include "avr/io.h" /* To use the UART Registers */
 #include "bit_manipulation.h" /* To use the macros like SET_BIT */
+#include <avr/interrupt.h>
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* Function called with every byte received while the Rx interrupt is enabled */
+static void (*volatile g_UART_receiveCallBackPtr)(uint8) = NULL;
 
 /*******************************************************************************
  *                      Functions Definitions                                  *
@@ -198,3 +206,41 @@ void UART_flush(void)
         dummy = UDR;  // Read and discard data
     }
 }
+
+/*
+ * Description :
+ * Returns TRUE if a received byte is waiting in the Rx buffer (never blocks)
+ */
+uint8 UART_isDataAvailable(void)
+{
+    return IS_BIT_SET(UCSRA,RXC) ? TRUE : FALSE;
+}
+
+void UART_setReceiveCallBack(void (*a_ptr)(uint8))
+{
+    g_UART_receiveCallBackPtr = a_ptr;
+
+    if (a_ptr != NULL)
+    {
+        SET_BIT(UCSRB,RXCIE);
+    }
+    else
+    {
+        CLEAR_BIT(UCSRB,RXCIE);
+    }
+}
+
+/*******************************************************************************
+ *                       Interrupt Service Routines                            *
+ *******************************************************************************/
+
+ISR(USART_RXC_vect)
+{
+    /* Reading UDR clears the RXC flag and the interrupt request */
+    uint8 data = UDR;
+
+    if (g_UART_receiveCallBackPtr != NULL)
+    {
+        g_UART_receiveCallBackPtr(data);
+    }
+}
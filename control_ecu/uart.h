@@ -92,4 +92,18 @@ void UART_receiveString(uint8 *Str); // Receive until #
  */
 void UART_flush(void);
 
+/*
+ * Description :
+ * Returns TRUE if a received byte is waiting in the Rx buffer (never blocks)
+ */
+uint8 UART_isDataAvailable(void);
+
+/*
+ * Description :
+ * Register a function called from the receive complete interrupt with every
+ * received byte and enable that interrupt (NULL disables it again).
+ * UART_recieveByte() must not be used while a callback is registered.
+ */
+void UART_setReceiveCallBack(void (*a_ptr)(uint8));
+
 #endif /* UART_H_ */
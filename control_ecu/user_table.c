@@ -0,0 +1,234 @@
+/*------------------------------------------------------------------------------
+ *  Module      : User Table
+ *  File        : user_table.c
+ *  Description : Source file for the multi-user credential table stored in
+ *                the external EEPROM with an open-addressing hash index
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "user_table.h"
+#include "external_eeprom.h"
+#include "eeprom_queue.h"
+#include "crc.h"
+
+/*------------------------------------------------------------------------------
+ *  Private Functions
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] USER_TABLE_hash
+ * [Description]   Home bucket of a credential.
+ *----------------------------------------------------------------------------*/
+static uint8 USER_TABLE_hash(const uint8 *credential)
+{
+    return (uint8)(CRC16_compute(credential, CREDENTIAL_PASSWORD_SIZE) & (USER_TABLE_BUCKETS - 1));
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] USER_TABLE_bucketAddress
+ * [Description]   EEPROM address of a bucket.
+ *----------------------------------------------------------------------------*/
+static uint16 USER_TABLE_bucketAddress(uint8 bucket)
+{
+    return (uint16)(USER_TABLE_BASE_ADDRESS + ((uint16)bucket * USER_TABLE_BUCKET_SIZE));
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] USER_TABLE_getId
+ * [Description]   User id field of a bucket image.
+ *----------------------------------------------------------------------------*/
+static uint16 USER_TABLE_getId(const uint8 *bucket)
+{
+    return (uint16)bucket[USER_TABLE_ID_OFFSET] | ((uint16)bucket[USER_TABLE_ID_OFFSET + 1] << 8);
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] USER_TABLE_credentialMatches
+ * [Description]   Compares the credential field of a bucket image.
+ *----------------------------------------------------------------------------*/
+static boolean USER_TABLE_credentialMatches(const uint8 *bucket, const uint8 *credential)
+{
+    uint8 loop_idx;
+
+    for (loop_idx = 0; loop_idx < CREDENTIAL_PASSWORD_SIZE; loop_idx++)
+    {
+        if (bucket[USER_TABLE_CREDENTIAL_OFFSET + loop_idx] != credential[loop_idx])
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] USER_TABLE_findId
+ * [Description]   Walks the whole table for a user id, a page per read. Sets
+ *                 'address' to its bucket or USER_TABLE_NO_ADDRESS, returns
+ *                 ERROR only if the EEPROM could not be read.
+ *----------------------------------------------------------------------------*/
+static uint8 USER_TABLE_findId(uint16 user_id, uint16 *address)
+{
+    uint8 page[EEPROM_PAGE_SIZE];
+    uint16 page_address;
+    uint8 offset;
+
+    *address = USER_TABLE_NO_ADDRESS;
+
+    for (page_address = USER_TABLE_BASE_ADDRESS;
+         page_address < (USER_TABLE_BASE_ADDRESS + ((uint16)USER_TABLE_BUCKETS * USER_TABLE_BUCKET_SIZE));
+         page_address += EEPROM_PAGE_SIZE)
+    {
+        if (EEPROM_QUEUE_read(page_address, page, EEPROM_PAGE_SIZE) == ERROR)
+        {
+            return ERROR;
+        }
+
+        for (offset = 0; offset < EEPROM_PAGE_SIZE; offset += USER_TABLE_BUCKET_SIZE)
+        {
+            if (USER_TABLE_getId(&page[offset]) == user_id)
+            {
+                *address = page_address + offset;
+                return SUCCESS;
+            }
+        }
+    }
+
+    return SUCCESS;
+}
+
+/*------------------------------------------------------------------------------
+ *  Functions Definitions
+ *----------------------------------------------------------------------------*/
+
+uint8 USER_TABLE_verify(const uint8 *credential, uint16 *user_id, uint8 *flags)
+{
+    uint8 bucket[USER_TABLE_BUCKET_SIZE];
+    uint8 index = USER_TABLE_hash(credential);
+    uint8 probe;
+    uint16 id;
+
+    for (probe = 0; probe < USER_TABLE_MAX_PROBES; probe++)
+    {
+        if (EEPROM_QUEUE_read(USER_TABLE_bucketAddress(index), bucket, USER_TABLE_BUCKET_SIZE) == ERROR)
+        {
+            return ERROR;
+        }
+
+        id = USER_TABLE_getId(bucket);
+
+        if (id == USER_TABLE_EMPTY_ID)
+        {
+            return ERROR; /* End of the probe chain */
+        }
+
+        if ((id != USER_TABLE_DELETED_ID) && USER_TABLE_credentialMatches(bucket, credential))
+        {
+            if (!(bucket[USER_TABLE_FLAGS_OFFSET] & USER_FLAG_ENABLED))
+            {
+                return ERROR;
+            }
+
+            if (user_id != NULL)
+            {
+                *user_id = id;
+            }
+            if (flags != NULL)
+            {
+                *flags = bucket[USER_TABLE_FLAGS_OFFSET];
+            }
+            return SUCCESS;
+        }
+
+        index = (uint8)((index + 1) & (USER_TABLE_BUCKETS - 1));
+    }
+
+    return ERROR;
+}
+
+uint8 USER_TABLE_enroll(uint16 user_id, const uint8 *credential, uint8 flags)
+{
+    uint8 bucket[USER_TABLE_BUCKET_SIZE];
+    uint8 index = USER_TABLE_hash(credential);
+    uint8 free_index = 0;
+    boolean free_found = FALSE;
+    uint8 probe;
+    uint8 loop_idx;
+    uint16 id;
+    uint16 address;
+
+    if ((user_id == USER_TABLE_EMPTY_ID) || (user_id == USER_TABLE_DELETED_ID))
+    {
+        return ERROR;
+    }
+
+    /* An id may only appear once too, remove would leave the second one behind */
+    if ((USER_TABLE_findId(user_id, &address) == ERROR) || (address != USER_TABLE_NO_ADDRESS))
+    {
+        return ERROR;
+    }
+
+    /* Walk the whole probe window: a credential may only appear once */
+    for (probe = 0; probe < USER_TABLE_MAX_PROBES; probe++)
+    {
+        if (EEPROM_QUEUE_read(USER_TABLE_bucketAddress(index), bucket, USER_TABLE_BUCKET_SIZE) == ERROR)
+        {
+            return ERROR;
+        }
+
+        id = USER_TABLE_getId(bucket);
+
+        if ((id == USER_TABLE_EMPTY_ID) || (id == USER_TABLE_DELETED_ID))
+        {
+            if (!free_found)
+            {
+                free_index = index;
+                free_found = TRUE;
+            }
+
+            if (id == USER_TABLE_EMPTY_ID)
+            {
+                break; /* Nothing further down this chain */
+            }
+        }
+        else if (USER_TABLE_credentialMatches(bucket, credential))
+        {
+            return ERROR;
+        }
+
+        index = (uint8)((index + 1) & (USER_TABLE_BUCKETS - 1));
+    }
+
+    if (!free_found)
+    {
+        return ERROR; /* Probe window full */
+    }
+
+    bucket[USER_TABLE_ID_OFFSET] = (uint8)user_id;
+    bucket[USER_TABLE_ID_OFFSET + 1] = (uint8)(user_id >> 8);
+    bucket[USER_TABLE_FLAGS_OFFSET] = flags;
+    for (loop_idx = 0; loop_idx < CREDENTIAL_PASSWORD_SIZE; loop_idx++)
+    {
+        bucket[USER_TABLE_CREDENTIAL_OFFSET + loop_idx] = credential[loop_idx];
+    }
+
+    return EEPROM_writePage(USER_TABLE_bucketAddress(free_index), bucket, USER_TABLE_BUCKET_SIZE);
+}
+
+uint8 USER_TABLE_remove(uint16 user_id)
+{
+    uint8 tombstone[2] = {(uint8)USER_TABLE_DELETED_ID, (uint8)(USER_TABLE_DELETED_ID >> 8)};
+    uint16 address;
+
+    if ((USER_TABLE_findId(user_id, &address) == ERROR) || (address == USER_TABLE_NO_ADDRESS))
+    {
+        return ERROR;
+    }
+
+    /* Only the id field is rewritten */
+    return EEPROM_writePage(address, tombstone, sizeof(tombstone));
+}
@@ -0,0 +1,87 @@
+/*------------------------------------------------------------------------------
+ *  Module      : User Table
+ *  File        : user_table.h
+ *  Description : Header file for the multi-user credential table stored in
+ *                the external EEPROM with an open-addressing hash index
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+#ifndef USER_TABLE_H_
+#define USER_TABLE_H_
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "stdtypes.h"
+#include "credential_store.h"
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/*
+ * The table occupies the upper half of the 24C16 (0x0400 - 0x07FF).
+ * USER_TABLE_BUCKETS must be a power of two (at most 256), each bucket is 8 bytes so two
+ * buckets share one EEPROM page and a bucket never crosses a page.
+ */
+#define USER_TABLE_BASE_ADDRESS                 0x0400
+#define USER_TABLE_BUCKETS                      128
+#define USER_TABLE_BUCKET_SIZE                  8
+
+/*
+ * Upper bound of buckets visited by a lookup (linear probing). Enrollment
+ * refuses a credential whose probe window is full, so a verification never
+ * reads more than USER_TABLE_MAX_PROBES buckets whatever the user count.
+ */
+#define USER_TABLE_MAX_PROBES                   8
+
+/*------------------------------------------------------------------------------
+ * Bucket layout:
+ *   [0..1] user id (little endian), USER_TABLE_EMPTY_ID or USER_TABLE_DELETED_ID
+ *   [2]    flags
+ *   [3..7] credential digits
+ *----------------------------------------------------------------------------*/
+#define USER_TABLE_ID_OFFSET                    0
+#define USER_TABLE_FLAGS_OFFSET                 2
+#define USER_TABLE_CREDENTIAL_OFFSET            3
+
+/* Reserved user ids, an erased EEPROM reads as an empty table */
+#define USER_TABLE_EMPTY_ID                     0xFFFF
+#define USER_TABLE_DELETED_ID                   0xFFFE
+
+/* No bucket holds the user id */
+#define USER_TABLE_NO_ADDRESS                   0xFFFF
+
+/* User flags */
+#define USER_FLAG_ENABLED                       0x01
+#define USER_FLAG_ADMIN                         0x02
+
+/*------------------------------------------------------------------------------
+ *  Function Declarations
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] USER_TABLE_verify
+ * [Description]   Looks the credential up. Returns SUCCESS and the user id and
+ *                 flags (pointers may be NULL) if an enabled user owns it.
+ *----------------------------------------------------------------------------*/
+uint8 USER_TABLE_verify(const uint8 *credential, uint16 *user_id, uint8 *flags);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] USER_TABLE_enroll
+ * [Description]   Adds a user. Fails if the user id or the credential is
+ *                 already used or if its probe window has no free bucket.
+ *                 The id check walks the whole table like USER_TABLE_remove.
+ *----------------------------------------------------------------------------*/
+uint8 USER_TABLE_enroll(uint16 user_id, const uint8 *credential, uint8 flags);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] USER_TABLE_remove
+ * [Description]   Deletes a user by id (leaves a tombstone so the probe chains
+ *                 of other users stay intact). This walks the whole table,
+ *                 it is an administration operation and not on the door path.
+ *----------------------------------------------------------------------------*/
+uint8 USER_TABLE_remove(uint16 user_id);
+
+#endif /* USER_TABLE_H_ */
@@ -0,0 +1,64 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Coroutine
+ *  File        : coroutine.h
+ *  Description : Stackless coroutines (protothreads) letting the HMI flows
+ *                be written as sequential code that returns at every wait
+ *                and resumes there on the next call
+ *  Author      : Hassan Darwish
+ *
+ *  A coroutine is a function returning COROUTINE_WAITING or COROUTINE_DONE
+ *  whose body sits between COROUTINE_BEGIN and COROUTINE_END. Its only state
+ *  is the resume point, locals do not survive a wait: keep the values needed
+ *  after a wait in globals. The resume point is a case label of a switch on
+ *  the line number, so a wait must not be placed inside a switch statement
+ *  of the coroutine body, nor two waits on the same line.
+ *----------------------------------------------------------------------------*/
+
+#ifndef COROUTINE_H_
+#define COROUTINE_H_
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "stdtypes.h"
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/* Coroutine return values */
+#define COROUTINE_WAITING                       0
+#define COROUTINE_DONE                          1
+
+/* Restart the coroutine from its beginning on the next call */
+#define COROUTINE_INIT(co)                      ((co)->line = 0)
+
+#define COROUTINE_BEGIN(co)                     switch ((co)->line) { case 0:
+
+#define COROUTINE_END(co)                       } (co)->line = 0; return COROUTINE_DONE
+
+/* Return now, resume after this statement on the next call */
+#define COROUTINE_YIELD(co)                                                     \
+    do { (co)->line = __LINE__; return COROUTINE_WAITING; case __LINE__:; } while (0)
+
+/* Return until the condition is true, it is evaluated again on every call */
+#define COROUTINE_WAIT_UNTIL(co, condition)                                     \
+    do { (co)->line = __LINE__; case __LINE__:                                  \
+         if (!(condition)) { return COROUTINE_WAITING; } } while (0)
+
+/* Run a child coroutine from its beginning until it is done */
+#define COROUTINE_SPAWN(co, child, call)                                        \
+    do { COROUTINE_INIT(child);                                                 \
+         COROUTINE_WAIT_UNTIL(co, (call) == COROUTINE_DONE); } while (0)
+
+/*------------------------------------------------------------------------------
+ *  Data Types Declarations
+ *----------------------------------------------------------------------------*/
+
+typedef struct
+{
+    uint16 line;            /* Resume point, 0 before the first call */
+} COROUTINE_Type;
+
+#endif /* COROUTINE_H_ */
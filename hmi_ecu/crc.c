@@ -0,0 +1,88 @@
+/*------------------------------------------------------------------------------
+ *  Module      : CRC Utility
+ *  File        : crc.c
+ *  Description : Source file for the CRC-16/CCITT checksum used to protect
+ *                records stored in the external EEPROM
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "crc.h"
+
+/*------------------------------------------------------------------------------
+ *  Functions Definitions
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] CRC16_update
+ * [Description]   Bitwise implementation, no lookup table to keep flash and
+ *                 RAM usage low (records are only a few bytes long).
+ *----------------------------------------------------------------------------*/
+uint16 CRC16_update(uint16 crc, uint8 data)
+{
+    uint8 bit_idx;
+
+    crc ^= ((uint16)data << 8);
+
+    for (bit_idx = 0; bit_idx < 8; bit_idx++)
+    {
+        if (crc & 0x8000)
+        {
+            crc = (uint16)((crc << 1) ^ 0x1021);
+        }
+        else
+        {
+            crc = (uint16)(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] CRC16_compute
+ * [Description]   Computes the CRC-16 of a whole buffer.
+ *----------------------------------------------------------------------------*/
+uint16 CRC16_compute(const uint8 *data, uint16 length)
+{
+    uint16 crc = CRC16_INITIAL_VALUE;
+
+    while (length--)
+    {
+        crc = CRC16_update(crc, *data++);
+    }
+
+    return crc;
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] CRC8_compute
+ * [Description]   Bitwise as well, detects every error burst of up to 8 bits.
+ *----------------------------------------------------------------------------*/
+uint8 CRC8_compute(const uint8 *data, uint16 length)
+{
+    uint8 crc = CRC8_INITIAL_VALUE;
+    uint8 bit_idx;
+
+    while (length--)
+    {
+        crc ^= *data++;
+
+        for (bit_idx = 0; bit_idx < 8; bit_idx++)
+        {
+            if (crc & 0x80)
+            {
+                crc = (uint8)((crc << 1) ^ 0x07);
+            }
+            else
+            {
+                crc = (uint8)(crc << 1);
+            }
+        }
+    }
+
+    return crc;
+}
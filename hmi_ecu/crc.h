@@ -0,0 +1,50 @@
+/*------------------------------------------------------------------------------
+ *  Module      : CRC Utility
+ *  File        : crc.h
+ *  Description : Header file for the CRC-16/CCITT checksum used to protect
+ *                records stored in the external EEPROM
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+#ifndef CRC_H_
+#define CRC_H_
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "stdtypes.h"
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/* Initial value of the CRC-16/CCITT-FALSE variant (polynomial 0x1021) */
+#define CRC16_INITIAL_VALUE                     0xFFFF
+
+/* Initial value of the CRC-8 (polynomial 0x07), the check byte of short records */
+#define CRC8_INITIAL_VALUE                      0xFF
+
+/*------------------------------------------------------------------------------
+ *  Function Declarations
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] CRC16_update
+ * [Description]   Feeds one byte into a running CRC-16 and returns the new CRC.
+ *----------------------------------------------------------------------------*/
+uint16 CRC16_update(uint16 crc, uint8 data);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] CRC16_compute
+ * [Description]   Computes the CRC-16 of a whole buffer.
+ *----------------------------------------------------------------------------*/
+uint16 CRC16_compute(const uint8 *data, uint16 length);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] CRC8_compute
+ * [Description]   Computes the CRC-8 of a whole buffer.
+ *----------------------------------------------------------------------------*/
+uint8 CRC8_compute(const uint8 *data, uint16 length);
+
+#endif /* CRC_H_ */
@@ -0,0 +1,40 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Diagnostics Link
+ *  File        : diag_link.c
+ *  Description : Source file for the framing of the diagnostics replies sent
+ *                over the ECU UART
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "diag_link.h"
+#include "crc.h"
+
+/*------------------------------------------------------------------------------
+ *  Functions Definitions
+ *----------------------------------------------------------------------------*/
+
+void DIAG_sendFrame(void (*a_send)(uint8), uint8 type, const uint8 *payload, uint8 length)
+{
+    uint16 crc = CRC16_INITIAL_VALUE;
+    uint8 byte_idx;
+
+    a_send(DIAG_FRAME_SOF);
+
+    a_send(type);
+    crc = CRC16_update(crc, type);
+    a_send(length);
+    crc = CRC16_update(crc, length);
+
+    for (byte_idx = 0; byte_idx < length; byte_idx++)
+    {
+        a_send(payload[byte_idx]);
+        crc = CRC16_update(crc, payload[byte_idx]);
+    }
+
+    a_send((uint8)crc);
+    a_send((uint8)(crc >> 8));
+}
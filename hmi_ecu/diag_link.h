@@ -0,0 +1,53 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Diagnostics Link
+ *  File        : diag_link.h
+ *  Description : Header file for the framing of the diagnostics replies sent
+ *                over the ECU UART
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+#ifndef DIAG_LINK_H_
+#define DIAG_LINK_H_
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "stdtypes.h"
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * Frame format:
+ *   [0x7E] [type] [length] [payload: length bytes] [CRC-16 low] [CRC-16 high]
+ * The CRC (CRC-16/CCITT-FALSE) covers type, length and payload. Multi-byte
+ * payload fields are little endian.
+ *----------------------------------------------------------------------------*/
+#define DIAG_FRAME_SOF                          0x7E
+
+/* Frame types */
+#define DIAG_FRAME_AUDIT_DATA                   0x01
+#define DIAG_FRAME_AUDIT_END                    0x02
+#define DIAG_FRAME_TWI_OPERATION                0x03
+#define DIAG_FRAME_TWI_BUS                      0x04
+#define DIAG_FRAME_DOOR_TRANSITION              0x05
+#define DIAG_FRAME_DOOR_STATE                   0x06
+#define DIAG_FRAME_TASK_STATS                   0x07
+#define DIAG_FRAME_TASK_RESET                   0x08
+#define DIAG_FRAME_PROFILE_REGION               0x09
+#define DIAG_FRAME_PROFILE_END                  0x0A
+#define DIAG_FRAME_EVENT_QUEUE                  0x0B
+
+/*------------------------------------------------------------------------------
+ *  Function Declarations
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] DIAG_sendFrame
+ * [Description]   Sends one frame through a_send (e.g. UART_sendByte).
+ *----------------------------------------------------------------------------*/
+void DIAG_sendFrame(void (*a_send)(uint8), uint8 type, const uint8 *payload, uint8 length);
+
+#endif /* DIAG_LINK_H_ */
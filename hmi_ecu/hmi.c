@@ -17,24 +17,66 @@
 /* UART configuration structure */
 UART_ConfigType UART_configurations = {UART_8_BIT_DATA, UART_NO_PARITY, UART_1_STOP_BIT, 9600};
 
-/* TIMER configuration structure - currently incomplete */
-TIMER_ConfigType TIMER_configuration = {0, 0, TIMER_TIMER2, TIMER_PRESCALER_64, TIMER_OVERFLOW_MODE};
-
 /* Flags to manage password entry states */
 volatile boolean g_password_phase_one = TRUE;
 volatile boolean g_password_reenter = FALSE;
 volatile boolean g_password_phase_two = FALSE;
-volatile uint16 overflow_counter = 0;
-volatile boolean g_open_door_flag = 0;
+
+/* Coroutines of the HMI flows */
+COROUTINE_Type g_main_co;           /* Password setup and menu */
+COROUTINE_Type g_operation_co;      /* Selected operation and its attempts */
+COROUTINE_Type g_flow_co;           /* Password entry, door or lockdown */
+
+/* Password being typed */
+uint8 g_user_password[KEYPAD_PASSWORD_SIZE];
+uint8 g_digit_count = 0;
+
+/* Selected operation, attempts made on it and the last verdict */
+uint8 g_key_response = 0;
+uint8 g_attempts = 1;
+uint8 g_response = 0;
+
+/* Key presses typed before this time belong to an earlier screen */
+uint32 g_keys_valid_from = 0;
+
+/* Countdown shown while waiting */
+uint32 g_state_deadline = 0;
+uint8 g_countdown_shown = 0;
+
+/* Bytes waiting to be transmitted to the control ECU */
+uint8 g_tx_buffer[LINK_TX_BUFFER_SIZE];
+uint8 g_tx_head = 0;
+uint8 g_tx_count = 0;
+uint32 g_tx_deadline = 0;
+
+/* Byte received from the control ECU, waiting for a flow to take it */
+uint8 g_rx_byte = 0;
+boolean g_rx_pending = FALSE;
 
 /*------------------------------------------------------------------------------
  *  Functions
  *----------------------------------------------------------------------------*/
 
 /* Function prototypes */
-void getPasswordSend(void);
-uint8 awaitPasswordResponse(void);
-void openDoorCallBack(void);
+boolean deadlineReached(uint32 now, uint32 deadline);
+void linkTask(uint32 now);
+uint8 mainFlow(COROUTINE_Type *co);
+uint8 operationFlow(COROUTINE_Type *co);
+uint8 passwordFlow(COROUTINE_Type *co);
+uint8 doorFlow(COROUTINE_Type *co);
+uint8 lockDownFlow(COROUTINE_Type *co);
+uint8 takeKey(void);
+void discardStaleKeys(void);
+boolean receiveByte(uint8 *data);
+void flushLink(void);
+boolean responseReceived(void);
+boolean clearReceived(void);
+void queueByte(uint8 data);
+void showPasswordPrompt(void);
+void sendPassword(void);
+void startCountdown(uint32 duration);
+void showCountdown(uint8 row, uint8 col);
+void showMenu(void);
 void deInitAll(void);
 
 /*------------------------------------------------------------------------------
@@ -45,188 +87,329 @@ int main(void)
     /* Enable global interrupts */
     SET_BIT(SREG, 7);
 
-    /* Initialize modules */
+    /* Initialize modules, the cycle counter only with the profiling regions */
+#if (PROFILE_ENABLE)
+    PROFILE_init();
+#endif
     LCD_init();
     UART_init(&UART_configurations);
+    SW_TIMER_init();
+    KEYPAD_init();
 
     /* Display initial message */
     LCD_displayString("Door Lock System");
     _delay_ms(50);
     LCD_clearScreen();
 
-    /* Infinite loop */
+    COROUTINE_INIT(&g_main_co);
+
+    /* Infinite loop: every step returns at once when it has to wait */
     for (;;)
     {
-        /* Password entry phase */
-        while (g_password_phase_one)
+        uint32 now = SW_TIMER_millis();
+
+        linkTask(now);
+        mainFlow(&g_main_co);
+    }
+}
+
+/*------------------------------------------------------------------------------
+ *  Tasks
+ *----------------------------------------------------------------------------*/
+
+/*
+ * Take the received byte (diagnostics requests are answered here), then
+ * transmit the queued bytes, one per LINK_BYTE_GAP_MS so UART_sendByte never waits
+ */
+void linkTask(uint32 now)
+{
+    if (!g_rx_pending && UART_isDataAvailable())
+    {
+        g_rx_byte = UART_recieveByte();
+#if (PROFILE_ENABLE)
+        if (g_rx_byte == PROFILE_DUMP_REQUEST)
+        {
+            PROFILE_export(UART_sendByte);
+        }
+        else
+#endif
         {
-            getPasswordSend();
-
-            /* Re-enter password if required */
-            if (g_password_reenter == TRUE)
-            {
-                getPasswordSend();
-            }
-
-            /* Handle response once */
-            uint8 password_response = awaitPasswordResponse();
-            if (password_response == RECIEVE_FALSE)
-            {
-                g_password_phase_one = TRUE;
-                g_password_reenter = FALSE;
-            }
-            else if (password_response == RECIEVE_TRUE)
-            {
-                g_password_phase_one = FALSE;
-                g_password_phase_two = TRUE;
-            }
+            g_rx_pending = TRUE;
         }
+    }
+
+    if (g_tx_count == 0 || !deadlineReached(now, g_tx_deadline))
+    {
+        return;
+    }
 
-        /* Variables for operation state */
-        boolean in_operation_flag = 0;
-        uint8 attempts_on_open_door = 1;
-        uint8 attempts_on_change_password = 1;
-        uint8 key_response = 0;
+    UART_sendByte(g_tx_buffer[g_tx_head]);
+    g_tx_head = (g_tx_head + 1) % LINK_TX_BUFFER_SIZE;
+    g_tx_count--;
+    g_tx_deadline = now + LINK_BYTE_GAP_MS;
+}
+
+/*------------------------------------------------------------------------------
+ *  Flows (coroutines)
+ *----------------------------------------------------------------------------*/
+
+/* Password setup, then the menu until the password is changed */
+uint8 mainFlow(COROUTINE_Type *co)
+{
+    COROUTINE_BEGIN(co);
+
+    for (;;)
+    {
+        /* Password entry phase: entered twice, until both entries match */
+        do
+        {
+            /* Typed while the previous verdict was pending */
+            discardStaleKeys();
+            g_password_reenter = FALSE;
+            COROUTINE_SPAWN(co, &g_flow_co, passwordFlow(&g_flow_co));
+            COROUTINE_SPAWN(co, &g_flow_co, passwordFlow(&g_flow_co));
+            COROUTINE_WAIT_UNTIL(co, responseReceived());
+        } while (g_response != RECIEVE_TRUE);
+
+        g_password_phase_one = FALSE;
+        g_password_phase_two = TRUE;
 
         /* Password verification and door operation phase */
         while (g_password_phase_two)
         {
-            while (in_operation_flag == 0)
-            {
-                LCD_clearScreen();
-                /* Display options once password is correct */
-                LCD_displayString("+ : Open Door");
-                LCD_displayStringRowColumn(1, 0, "- : Change Pass");
-
-                while (key_response != '+' && key_response != '-')
-                {
-                    _delay_ms(500);
-                    key_response = KEYPAD_getPressedKey();
-                }
-                in_operation_flag = 1;
-            }
-
-            /* Handle selected option */
-            if (key_response == '+')
-            {
-                /* Door opening sequence */
-                UART_flush();
-                UART_sendByte(START_PHASE_TWO_DOOR);
-                _delay_ms(10);
-                LCD_clearScreen();
-                g_password_reenter = START_PHASE_TWO;
-                getPasswordSend();
-
-                if (awaitPasswordResponse() == RECIEVE_TRUE)
-                {
-                    UART_sendByte(START_MOTOR);
-                    LCD_clearScreen();
-                    LCD_displayString("Opening Door");
-                    LCD_displayStringRowColumn(1, 0, "Please Wait...");
-
-                    TIMER_init(&TIMER_configuration);
-                    TIMER_setCallBack(openDoorCallBack, TIMER_TIMER2);
-
-                    /* Wait for door to open */
-                    while (g_open_door_flag == 0);
-
-                    LCD_clearScreen();
-                    LCD_displayString("Wait for people");
-                    LCD_displayStringRowColumn(1, 0, "to enter...");
-
-                    while (UART_recieveByte() != CLEAR);
-                    LCD_clearScreen();
-
-                    TIMER_deInit(TIMER_TIMER2);
-                    g_open_door_flag = 0;
-                    _delay_ms(50);
-
-                    TIMER_init(&TIMER_configuration);
-                    TIMER_setCallBack(openDoorCallBack, TIMER_TIMER2);
-
-                    LCD_displayString("Door Closing");
-                    LCD_displayStringRowColumn(1, 0, "Please Wait...");
-
-                    /* Wait for door to close */
-                    while (g_open_door_flag == 0);
-
-                    LCD_clearScreen();
-                    TIMER_deInit(TIMER_TIMER2);
-
-                    attempts_on_open_door = 1;
-                    in_operation_flag = 0;
-                    break; // Exit loop if password is correct
-                }
-                else if (attempts_on_open_door < MAXIMUM_PASSWORD_ATTEMPTS)
-                {
-                    attempts_on_open_door++;
-                    UART_sendByte(PASSWORD_INCORRECT);
-                    in_operation_flag = 1;
-                }
-                else
-                {
-                    /* Max attempts reached */
-                    LCD_clearScreen();
-                    LCD_displayString("MAX ATTEMPTS");
-                    LCD_displayStringRowColumn(1, 0, "REACHED");
-
-                    UART_sendByte(SYSTEM_LOCK_SEQUENCE);
-                    while (UART_recieveByte() != CLEAR);
-                    attempts_on_open_door = 0;
-                    break;
-                }
-            }
-            else if (key_response == '-')
-            {
-                /* Password change sequence */
-                UART_sendByte(START_PHASE_TWO_CHANGE);
-                g_password_reenter = START_PHASE_TWO;
-                getPasswordSend();
-                g_password_phase_one = TRUE;
-
-                /* Handle re-entry of password to change it */
-                if (awaitPasswordResponse() == RECIEVE_TRUE)
-                {
-                    UART_sendByte(RESET_PASSWORD);
-                    g_password_phase_one = TRUE;
-                    g_password_reenter = FALSE;
-                    g_password_phase_two = FALSE;
-                    attempts_on_change_password = 1;
-                    in_operation_flag = 0;
-                    break;
-                }
-                else if (attempts_on_change_password < MAXIMUM_PASSWORD_ATTEMPTS)
-                {
-                    attempts_on_change_password++;
-                    UART_sendByte(PASSWORD_INCORRECT);
-                    in_operation_flag = 1;
-                }
-                else
-                {
-                    /* Max attempts reached */
-                    LCD_clearScreen();
-                    LCD_displayString("MAX ATTEMPTS");
-                    LCD_displayStringRowColumn(1, 0, "REACHED");
-
-                    UART_sendByte(SYSTEM_LOCK_SEQUENCE);
-                    while (UART_recieveByte() != CLEAR);
-                    attempts_on_change_password = 0;
-                    break;
-                }
-            }
+            showMenu();
+            COROUTINE_WAIT_UNTIL(co, (g_key_response = takeKey()) == '+' || g_key_response == '-');
+            COROUTINE_SPAWN(co, &g_operation_co, operationFlow(&g_operation_co));
+        }
+    }
+
+    COROUTINE_END(co);
+}
+
+/* Verify the password for the selected option, then open the door or reset the password */
+uint8 operationFlow(COROUTINE_Type *co)
+{
+    COROUTINE_BEGIN(co);
+
+    for (g_attempts = 1; ; g_attempts++)
+    {
+        flushLink();
+        queueByte((g_key_response == '+') ? START_PHASE_TWO_DOOR : START_PHASE_TWO_CHANGE);
+        g_password_reenter = START_PHASE_TWO;
+        COROUTINE_SPAWN(co, &g_flow_co, passwordFlow(&g_flow_co));
+        COROUTINE_WAIT_UNTIL(co, responseReceived());
+
+        if (g_response == RECIEVE_TRUE || g_attempts >= MAXIMUM_PASSWORD_ATTEMPTS)
+        {
+            break;
+        }
+        queueByte(PASSWORD_INCORRECT);
+        discardStaleKeys();
+    }
+
+    if (g_response != RECIEVE_TRUE)
+    {
+        COROUTINE_SPAWN(co, &g_flow_co, lockDownFlow(&g_flow_co));
+    }
+    else if (g_key_response == '+')
+    {
+        COROUTINE_SPAWN(co, &g_flow_co, doorFlow(&g_flow_co));
+    }
+    else
+    {
+        /* Password matches, set a new one */
+        queueByte(RESET_PASSWORD);
+        deInitAll();
+    }
+
+    COROUTINE_END(co);
+}
+
+/* Prompt for the password, mask the digits and send it once Enter is pressed */
+uint8 passwordFlow(COROUTINE_Type *co)
+{
+    uint8 key;
+
+    COROUTINE_BEGIN(co);
+
+    showPasswordPrompt();
+
+    /* Gather and mask password input from user */
+    for (g_digit_count = 0; g_digit_count < KEYPAD_PASSWORD_SIZE; )
+    {
+        COROUTINE_WAIT_UNTIL(co, (key = takeKey()) != KEYPAD_NO_KEY);
+
+        /* Check if the input is a valid number */
+        if (key >= KEYPAD_MINIMUM_NUMBER && key <= KEYPAD_MAXIMUM_NUMBER)
+        {
+            g_user_password[g_digit_count++] = key;
+            LCD_displayCharacter('*');
         }
     }
+
+    /* Wait for the user to press the Enter button */
+    COROUTINE_WAIT_UNTIL(co, takeKey() == KEYPAD_ENTER_BUTTON);
+
+    sendPassword();
+
+    COROUTINE_END(co);
+}
+
+/* Door sequence with the remaining motor time on the second row */
+uint8 doorFlow(COROUTINE_Type *co)
+{
+    COROUTINE_BEGIN(co);
+
+    queueByte(START_MOTOR);
+    LCD_clearScreen();
+    LCD_displayString("Opening Door");
+    LCD_displayStringRowColumn(1, 0, "Please Wait");
+
+    /* Wait for door to open */
+    startCountdown(DOOR_MOTOR_TIME_MS);
+    while (!deadlineReached(SW_TIMER_millis(), g_state_deadline))
+    {
+        showCountdown(1, 12);
+        COROUTINE_YIELD(co);
+    }
+
+    LCD_clearScreen();
+    LCD_displayString("Wait for people");
+    LCD_displayStringRowColumn(1, 0, "to enter...");
+
+    COROUTINE_WAIT_UNTIL(co, clearReceived());
+
+    LCD_clearScreen();
+    LCD_displayString("Door Closing");
+    LCD_displayStringRowColumn(1, 0, "Please Wait");
+
+    /* Wait for door to close */
+    startCountdown(DOOR_MOTOR_TIME_MS);
+    while (!deadlineReached(SW_TIMER_millis(), g_state_deadline))
+    {
+        showCountdown(1, 12);
+        COROUTINE_YIELD(co);
+    }
+
+    COROUTINE_END(co);
+}
+
+/* Lockdown until the control ECU clears it, with the expected remaining time */
+uint8 lockDownFlow(COROUTINE_Type *co)
+{
+    COROUTINE_BEGIN(co);
+
+    /* Max attempts reached */
+    LCD_clearScreen();
+    LCD_displayString("MAX ATTEMPTS");
+    LCD_displayStringRowColumn(1, 0, "REACHED");
+
+    queueByte(SYSTEM_LOCK_SEQUENCE);
+
+    startCountdown(LOCK_DOWN_TIME_MS);
+    while (!clearReceived())
+    {
+        showCountdown(1, 12);
+        COROUTINE_YIELD(co);
+    }
+
+    COROUTINE_END(co);
 }
 
 /*------------------------------------------------------------------------------
  *  Helper Functions
  *----------------------------------------------------------------------------*/
 
-/* Function to prompt the user to enter or re-enter password and send it over UART */
-void getPasswordSend(void)
+/* TRUE once now reached the deadline, also across the millisecond counter wrap */
+boolean deadlineReached(uint32 now, uint32 deadline)
+{
+    return ((int32)(now - deadline) >= 0) ? TRUE : FALSE;
+}
+
+/*
+ * Consume the next key press, KEYPAD_NO_KEY if there is none. Presses wait in
+ * the keypad queue while the flows update the LCD, so keys typed ahead of a
+ * prompt are kept unless a stale input discard came after them.
+ */
+uint8 takeKey(void)
+{
+    KEYPAD_EventType event;
+
+    while (KEYPAD_getEvent(&event))
+    {
+        if (event.kind == KEYPAD_EVENT_PRESS && deadlineReached(event.time_ms, g_keys_valid_from))
+        {
+            return event.key;
+        }
+    }
+    return KEYPAD_NO_KEY;
+}
+
+/*
+ * Drop the presses typed so far. Called when a screen follows a wait the user
+ * could not type into (control ECU verdict, door, lockdown), not when it
+ * follows the user's own key (menu choice, Enter), so typing ahead works.
+ */
+void discardStaleKeys(void)
+{
+    g_keys_valid_from = SW_TIMER_millis();
+}
+
+/* Take the byte from the control ECU if one arrived */
+boolean receiveByte(uint8 *data)
+{
+    if (!g_rx_pending)
+    {
+        return FALSE;
+    }
+
+    *data = g_rx_byte;
+    g_rx_pending = FALSE;
+    return TRUE;
+}
+
+/* Drop the bytes received from the control ECU */
+void flushLink(void)
+{
+    UART_flush();
+    g_rx_pending = FALSE;
+}
+
+/* TRUE once the verdict on the sent password arrived (stored in g_response) */
+boolean responseReceived(void)
+{
+    uint8 data;
+
+    if (receiveByte(&data) && (data == RECIEVE_TRUE || data == RECIEVE_FALSE))
+    {
+        g_response = data;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/* TRUE once the control ECU sent CLEAR */
+boolean clearReceived(void)
+{
+    uint8 data;
+
+    return (receiveByte(&data) && data == CLEAR) ? TRUE : FALSE;
+}
+
+/* Queue a byte for the control ECU */
+void queueByte(uint8 data)
+{
+    if (g_tx_count < LINK_TX_BUFFER_SIZE)
+    {
+        g_tx_buffer[(g_tx_head + g_tx_count) % LINK_TX_BUFFER_SIZE] = data;
+        g_tx_count++;
+    }
+}
+
+/* Function to prompt the user to enter or re-enter password */
+void showPasswordPrompt(void)
 {
     LCD_clearScreen();
-    uint8 user_password[KEYPAD_PASSWORD_SIZE];
 
     /* Display appropriate message based on password entry phase */
     if (g_password_reenter == FALSE)
@@ -245,79 +428,65 @@ void getPasswordSend(void)
         LCD_displayString("Plz enter old");
         LCD_displayStringRowColumn(1, 0, "pass:");
     }
+}
 
-    /* Gather and mask password input from user */
-    for (uint8 key_input_idx = 0; key_input_idx < KEYPAD_PASSWORD_SIZE; key_input_idx++)
-    {
-        user_password[key_input_idx] = KEYPAD_getPressedKey();
-
-        /* Check if the input is a valid number */
-        if (user_password[key_input_idx] >= KEYPAD_MINIMUM_NUMBER &&
-            user_password[key_input_idx] <= KEYPAD_MAXIMUM_NUMBER)
-        {
-            LCD_displayCharacter('*');
-        }
-        else
-        {
-            key_input_idx--; /* Invalid input, repeat the same index */
-        }
-
-        _delay_ms(500);
-    }
-
-    /* Wait for the user to press the Enter button */
-    while (KEYPAD_getPressedKey() != KEYPAD_ENTER_BUTTON);
-
+/* Function to send the typed password over UART */
+void sendPassword(void)
+{
     /* Send start password signal */
-    UART_sendByte(SEND_START_PASSWORD);
+    queueByte(SEND_START_PASSWORD);
 
     /* Transmit the password over UART */
     for (uint8 loop_idx = 0; loop_idx < KEYPAD_PASSWORD_SIZE; loop_idx++)
     {
-        _delay_ms(50);
-        UART_sendByte(user_password[loop_idx]);
+        queueByte(g_user_password[loop_idx]);
     }
 
     LCD_clearScreen();
-    return;
 }
 
-/* Function to await response indicating password validity */
-uint8 awaitPasswordResponse(void)
+/* Arm the countdown shown by showCountdown() */
+void startCountdown(uint32 duration)
 {
-    uint8 response_byte = 0;
-
-    /* Wait until a valid response (true or false) is received */
-    while (response_byte != RECIEVE_TRUE && response_byte != RECIEVE_FALSE)
-    {
-        response_byte = UART_recieveByte();
-    }
-
-    return response_byte;
+    g_state_deadline = SW_TIMER_millis() + duration;
+    g_countdown_shown = 0xFF;
 }
 
-/* Callback function to manage door timing */
-void openDoorCallBack(void)
+/* Display the whole seconds left, the LCD is only written when they change */
+void showCountdown(uint8 row, uint8 col)
 {
-    overflow_counter++;
-    if (overflow_counter == TARGET_OVERFLOWS)
+    uint32 now = SW_TIMER_millis();
+    uint8 seconds = 0;
+
+    if (!deadlineReached(now, g_state_deadline))
     {
-        g_open_door_flag = 1; /* Set flag when target time is reached */
-        overflow_counter = 0; /* Reset tick counter */
+        seconds = (uint8)((g_state_deadline - now + 999) / 1000);
     }
-    else
+
+    if (seconds != g_countdown_shown)
     {
-        g_open_door_flag = 0;
+        g_countdown_shown = seconds;
+        LCD_moveCursor(row, col);
+        LCD_integerToString(seconds);
+        LCD_displayString("s ");
     }
 }
 
+/* Function to display the options once the password is set */
+void showMenu(void)
+{
+    /* Keys typed while the menu is drawn are meant for it */
+    discardStaleKeys();
+    LCD_clearScreen();
+    LCD_displayString("+ : Open Door");
+    LCD_displayStringRowColumn(1, 0, "- : Change Pass");
+}
+
 /* Deinitialize all global variables */
 void deInitAll(void)
 {
     g_password_phase_one = TRUE;
     g_password_reenter = FALSE;
     g_password_phase_two = FALSE;
-    overflow_counter = 0;
-    g_open_door_flag = 0;
-    UART_flush();
+    flushLink();
 }
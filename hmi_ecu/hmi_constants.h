@@ -22,6 +22,11 @@
 #define RECIEVE_TRUE                        0x5B
 #define RECIEVE_FALSE                       0x5C
 #define SEND_START_PASSWORD                 0x5A
+#define LINK_TX_BUFFER_SIZE                 16
+#define LINK_BYTE_GAP_MS                    2
+
+/* Diagnostics request (host adapter in place of the control ECU) */
+#define PROFILE_DUMP_REQUEST                0x6C
 
 /* Password Verification */
 #define MAXIMUM_PASSWORD_ATTEMPTS           3
@@ -34,12 +39,12 @@
 /* Motor and Door Control */
 #define START_MOTOR                         0x3A
 #define START_PHASE_TWO                     0x4C
-#define TARGET_OVERFLOWS                    7324
+#define DOOR_MOTOR_TIME_MS                  15000
 #define CLEAR                               0x3B
 
 /* System Lockdown */
 #define SYSTEM_LOCK_SEQUENCE                0x3C
-#define LOCK_DOWN_TIME                      29296
+#define LOCK_DOWN_TIME_MS                   60000
 #define RESET_PASSWORD                      0x4C
 
 #endif /* HMI_CONSTANTS_H_ */
@@ -11,8 +11,52 @@
  *******************************************************************************/
 #include "keypad.h"
 #include "gpio.h"
+#include "sw_timer.h"
+#include "profile.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
 #include <util/delay.h>
 
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define KEYPAD_EVENT_INDEX_MASK          (KEYPAD_EVENT_QUEUE_SIZE - 1)
+
+/* The scan drives a row and reads all the columns with one register access */
+#if (KEYPAD_ROW_PORT_ID != KEYPAD_COL_PORT_ID)
+#error "The keypad rows and columns must be on the same port"
+#endif
+
+#if (KEYPAD_ROW_PORT_ID == GPIO_PORTA)
+#define KEYPAD_DDR                       DDRA
+#define KEYPAD_PORT                      PORTA
+#define KEYPAD_PIN                       PINA
+#elif (KEYPAD_ROW_PORT_ID == GPIO_PORTB)
+#define KEYPAD_DDR                       DDRB
+#define KEYPAD_PORT                      PORTB
+#define KEYPAD_PIN                       PINB
+#elif (KEYPAD_ROW_PORT_ID == GPIO_PORTC)
+#define KEYPAD_DDR                       DDRC
+#define KEYPAD_PORT                      PORTC
+#define KEYPAD_PIN                       PINC
+#else
+#define KEYPAD_DDR                       DDRD
+#define KEYPAD_PORT                      PORTD
+#define KEYPAD_PIN                       PIND
+#endif
+
+#define KEYPAD_ROW_MASK                  (uint8)(((1 << KEYPAD_NUM_ROWS) - 1) << KEYPAD_FIRST_ROW_PIN_ID)
+#define KEYPAD_COL_MASK                  (uint8)(((1 << KEYPAD_NUM_COLS) - 1) << KEYPAD_FIRST_COL_PIN_ID)
+
+/* One bit per button in a uint16 */
+#if (KEYPAD_BUTTONS > 16)
+#error "The keypad bitmap holds 16 buttons"
+#endif
+
+/* Columns pressed in a row of a bitmap */
+#define KEYPAD_ROW_KEYS(bitmap, row)     (uint8)(((bitmap) >> ((row) * KEYPAD_NUM_COLS)) & ((1 << KEYPAD_NUM_COLS) - 1))
+
 /*******************************************************************************
  *                      Functions Prototypes(Private)                          *
  *******************************************************************************/
@@ -31,53 +75,239 @@ static uint8 KEYPAD_4x3_adjustKeyNumber(uint8 button_number);
 static uint8 KEYPAD_4x4_adjustKeyNumber(uint8 button_number);
 #endif
 
+#if (KEYPAD_NUM_COLS == 3)
+#define KEYPAD_adjustKeyNumber(button_number)    KEYPAD_4x3_adjustKeyNumber(button_number)
+#elif (KEYPAD_NUM_COLS == 4)
+#define KEYPAD_adjustKeyNumber(button_number)    KEYPAD_4x4_adjustKeyNumber(button_number)
+#endif
+
+/*
+ * Description :
+ * Scan the matrix once, returns the bitmap of all the pressed buttons (bit n
+ * for button number n+1, ghost keys included). Direct register access, the
+ * keypad pins are not touched through the GPIO driver
+ */
+static uint16 KEYPAD_scanMatrix(void);
+
+/*
+ * Description :
+ * Buttons of a scan that cannot be trusted: the corners of every rectangle
+ * of pressed buttons, one of them may be a ghost
+ */
+static uint16 KEYPAD_ghostMask(uint16 bitmap);
+
+/*
+ * Description :
+ * Background scan, called every KEYPAD_SCAN_PERIOD_MS from the system tick
+ */
+static void KEYPAD_scanTick(void *context);
+
+/*
+ * Description :
+ * Queue a key event, dropped when the queue is full
+ */
+static void KEYPAD_pushEvent(uint8 button, KEYPAD_EventKindType kind, uint32 time_ms);
+
+/*******************************************************************************
+ *                      Global Variables                                       *
+ *******************************************************************************/
+
+/* Debounced state of the buttons, bit n for button number n+1 */
+static uint16 g_stable = 0;
+
+/* Buttons whose scans differ from g_stable and for how many scans in a row */
+static uint16 g_bouncing = 0;
+static uint8 g_debounce_count[KEYPAD_BUTTONS];
+
+/*
+ * Key events, single producer (the scan tick) / single consumer (the main
+ * loop) like the control ECU event queue: g_event_tail is only written by
+ * the scan and g_event_head only by the reader, both free running bytes.
+ */
+static volatile KEYPAD_EventType g_events[KEYPAD_EVENT_QUEUE_SIZE];
+static volatile uint8 g_event_head = 0;
+static volatile uint8 g_event_tail = 0;
+
 /*******************************************************************************
  *                      Functions Definitions                                  *
  *******************************************************************************/
 
-uint8 KEYPAD_getPressedKey(void)
+void KEYPAD_init(void)
 {
-	uint8 col,row;
-	GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID, GPIO_PIN_INPUT);
-	GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+1, GPIO_PIN_INPUT);
-	GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+2, GPIO_PIN_INPUT);
-	GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+3, GPIO_PIN_INPUT);
-
-	GPIO_setupPinDirection(KEYPAD_COL_PORT_ID, KEYPAD_FIRST_COL_PIN_ID, GPIO_PIN_INPUT);
-	GPIO_setupPinDirection(KEYPAD_COL_PORT_ID, KEYPAD_FIRST_COL_PIN_ID+1, GPIO_PIN_INPUT);
-	GPIO_setupPinDirection(KEYPAD_COL_PORT_ID, KEYPAD_FIRST_COL_PIN_ID+2, GPIO_PIN_INPUT);
-#if(KEYPAD_NUM_COLS == 4)
-	GPIO_setupPinDirection(KEYPAD_COL_PORT_ID, KEYPAD_FIRST_COL_PIN_ID+3, GPIO_PIN_INPUT);
-#endif
-	while(1)
+	uint8 button;
+	uint8 sreg = SREG;
+
+	cli();
+	g_stable = 0;
+	g_bouncing = 0;
+	for(button=0 ; button<KEYPAD_BUTTONS ; button++)
+	{
+		g_debounce_count[button] = 0;
+	}
+	g_event_head = 0;
+	g_event_tail = 0;
+	SREG = sreg;
+
+	SW_TIMER_start(KEYPAD_SCAN_PERIOD_MS, SW_TIMER_PERIODIC, KEYPAD_scanTick, NULL);
+}
+
+boolean KEYPAD_getEvent(KEYPAD_EventType *event)
+{
+	uint8 head = g_event_head;
+
+	if(head == g_event_tail)
 	{
-		for(row=0 ; row<KEYPAD_NUM_ROWS ; row++) /* loop for rows */
+		return FALSE;
+	}
+
+	event->key = g_events[head & KEYPAD_EVENT_INDEX_MASK].key;
+	event->kind = g_events[head & KEYPAD_EVENT_INDEX_MASK].kind;
+	event->time_ms = g_events[head & KEYPAD_EVENT_INDEX_MASK].time_ms;
+
+	/* Releases the slot */
+	g_event_head = (uint8)(head + 1);
+
+	return TRUE;
+}
+
+static void KEYPAD_pushEvent(uint8 button, KEYPAD_EventKindType kind, uint32 time_ms)
+{
+	uint8 tail = g_event_tail;
+
+	if((uint8)(tail - g_event_head) >= KEYPAD_EVENT_QUEUE_SIZE)
+	{
+		return;
+	}
+
+	g_events[tail & KEYPAD_EVENT_INDEX_MASK].key = KEYPAD_adjustKeyNumber(button+1);
+	g_events[tail & KEYPAD_EVENT_INDEX_MASK].kind = kind;
+	g_events[tail & KEYPAD_EVENT_INDEX_MASK].time_ms = time_ms;
+
+	/* Publishes the event */
+	g_event_tail = (uint8)(tail + 1);
+}
+
+static void KEYPAD_scanTick(void *context)
+{
+	uint16 bitmap;
+	uint16 changed;
+	uint16 mask;
+	uint8 button;
+
+	(void)context;
+
+	PROFILE_BEGIN(PROFILE_KEYPAD_SCAN);
+	bitmap = KEYPAD_scanMatrix();
+	PROFILE_END(PROFILE_KEYPAD_SCAN);
+
+	/*
+	 * Without diodes three pressed corners of a rectangle make the fourth
+	 * read pressed, the corners keep their state until the pattern clears
+	 */
+	changed = (bitmap ^ g_stable) & (uint16)~KEYPAD_ghostMask(bitmap);
+
+	if((changed | g_bouncing) == 0)
+	{
+		return;
+	}
+
+	/*
+	 * Per button: a change is accepted after KEYPAD_DEBOUNCE_SCANS scans in
+	 * a row see it, any scan back at the stable level restarts the count.
+	 * The events come out in the order the changes started, the ones
+	 * starting on the same scan in button order.
+	 */
+	for(button=0, mask=1 ; button<KEYPAD_BUTTONS ; button++, mask<<=1)
+	{
+		if(!(changed & mask))
+		{
+			g_debounce_count[button] = 0;
+			continue;
+		}
+
+		if(++g_debounce_count[button] < KEYPAD_DEBOUNCE_SCANS)
 		{
-			/* 
-			 * Each time setup the direction for all keypad port as input pins,
-			 * except this row will be output pin
-			 */
-			GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID,KEYPAD_FIRST_ROW_PIN_ID+row,GPIO_PIN_OUTPUT);
+			continue;
+		}
 
-			/* Set/Clear the row output pin */
-			GPIO_writePin(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+row, KEYPAD_BUTTON_PRESSED);
+		g_debounce_count[button] = 0;
+		changed &= (uint16)~mask;
+		g_stable ^= mask;
 
-			for(col=0 ; col<KEYPAD_NUM_COLS ; col++) /* loop for columns */
+		/* Stamped with the first scan that saw the new level */
+		KEYPAD_pushEvent(button, (g_stable & mask) ? KEYPAD_EVENT_PRESS : KEYPAD_EVENT_RELEASE,
+				SW_TIMER_millis() - ((KEYPAD_DEBOUNCE_SCANS - 1) * KEYPAD_SCAN_PERIOD_MS));
+	}
+
+	g_bouncing = changed;
+}
+
+static uint16 KEYPAD_scanMatrix(void)
+{
+	uint16 bitmap = 0;
+	uint8 row;
+	uint8 columns;
+
+	/* All keypad pins inputs, a row set as output drives the pressed level */
+	KEYPAD_DDR &= (uint8)~(KEYPAD_ROW_MASK | KEYPAD_COL_MASK);
+#if (KEYPAD_BUTTON_PRESSED == LOGIC_LOW)
+	KEYPAD_PORT &= (uint8)~KEYPAD_ROW_MASK;
+#else
+	KEYPAD_PORT |= KEYPAD_ROW_MASK;
+#endif
+
+	for(row=0 ; row<KEYPAD_NUM_ROWS ; row++) /* loop for rows */
+	{
+		/* Only this row drives, the other rows float */
+		KEYPAD_DDR = (KEYPAD_DDR & (uint8)~KEYPAD_ROW_MASK) | (uint8)(1 << (KEYPAD_FIRST_ROW_PIN_ID+row));
+
+		/* Let the columns settle and pass the input synchronizer */
+		_delay_us(1);
+
+		/* All the columns of the row in one read */
+#if (KEYPAD_BUTTON_PRESSED == LOGIC_LOW)
+		columns = (uint8)(~KEYPAD_PIN & KEYPAD_COL_MASK) >> KEYPAD_FIRST_COL_PIN_ID;
+#else
+		columns = (uint8)(KEYPAD_PIN & KEYPAD_COL_MASK) >> KEYPAD_FIRST_COL_PIN_ID;
+#endif
+		bitmap |= (uint16)columns << (row*KEYPAD_NUM_COLS);
+	}
+
+	KEYPAD_DDR &= (uint8)~KEYPAD_ROW_MASK;
+	return bitmap;
+}
+
+static uint16 KEYPAD_ghostMask(uint16 bitmap)
+{
+	uint16 ghosts = 0;
+	uint16 fewer = bitmap;
+	uint8 first_row,second_row;
+	uint8 common;
+
+	/* A rectangle needs four pressed buttons */
+	fewer &= (uint16)(fewer - 1);
+	fewer &= (uint16)(fewer - 1);
+	fewer &= (uint16)(fewer - 1);
+	if(fewer == 0)
+	{
+		return 0;
+	}
+
+	for(first_row=0 ; first_row<(KEYPAD_NUM_ROWS-1) ; first_row++)
+	{
+		for(second_row=first_row+1 ; second_row<KEYPAD_NUM_ROWS ; second_row++)
+		{
+			common = KEYPAD_ROW_KEYS(bitmap, first_row) & KEYPAD_ROW_KEYS(bitmap, second_row);
+
+			/* Two rows sharing two pressed columns */
+			if(common & (uint8)(common - 1))
 			{
-				/* Check if the switch is pressed in this column */
-				if(GPIO_readPin(KEYPAD_COL_PORT_ID,KEYPAD_FIRST_COL_PIN_ID+col) == KEYPAD_BUTTON_PRESSED)
-				{
-					#if (KEYPAD_NUM_COLS == 3)
-						return KEYPAD_4x3_adjustKeyNumber((row*KEYPAD_NUM_COLS)+col+1);
-					#elif (KEYPAD_NUM_COLS == 4)
-						return KEYPAD_4x4_adjustKeyNumber((row*KEYPAD_NUM_COLS)+col+1);
-					#endif
-				}
+				ghosts |= ((uint16)common << (first_row*KEYPAD_NUM_COLS)) |
+						((uint16)common << (second_row*KEYPAD_NUM_COLS));
 			}
-			GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID,KEYPAD_FIRST_ROW_PIN_ID+row,GPIO_PIN_INPUT);
-			_delay_ms(10); /* Add small delay to fix CPU load issue in proteus */
 		}
-	}	
+	}
+	return ghosts;
 }
 
 #if (KEYPAD_NUM_COLS == 3)
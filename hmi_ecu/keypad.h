@@ -34,14 +34,57 @@
 #define KEYPAD_BUTTON_PRESSED            LOGIC_LOW
 #define KEYPAD_BUTTON_RELEASED           LOGIC_HIGH
 
+/* Key value meaning "no key", never carried by an event */
+#define KEYPAD_NO_KEY                    0xFF
+
+#define KEYPAD_BUTTONS                   (KEYPAD_NUM_ROWS * KEYPAD_NUM_COLS)
+
+/*
+ * Background scan: one matrix scan every KEYPAD_SCAN_PERIOD_MS, a button
+ * changes state once KEYPAD_DEBOUNCE_SCANS scans in a row agree (8 ms of
+ * stable contact, longer than the bounce of a membrane keypad)
+ */
+#define KEYPAD_SCAN_PERIOD_MS            2
+#define KEYPAD_DEBOUNCE_SCANS            4
+
+/*
+ * Events waiting for KEYPAD_getEvent, a power of two. Holds the keys typed
+ * ahead while the HMI draws a screen: a prompt takes about 120 ms, 13
+ * events (presses and releases) at 52 keys/s
+ */
+#define KEYPAD_EVENT_QUEUE_SIZE          16
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef enum
+{
+	KEYPAD_EVENT_PRESS, KEYPAD_EVENT_RELEASE
+}KEYPAD_EventKindType;
+
+typedef struct
+{
+	uint8 key;                  /* Button after the keypad layout mapping */
+	KEYPAD_EventKindType kind;
+	uint32 time_ms;             /* SW_TIMER_millis of the first scan that saw the change */
+}KEYPAD_EventType;
+
 /*******************************************************************************
  *                      Functions Prototypes                                   *
  *******************************************************************************/
 
 /*
  * Description :
- * Get the Keypad pressed button
+ * Start the background scan on a periodic software timer, SW_TIMER_init
+ * must have been called
+ */
+void KEYPAD_init(void);
+
+/*
+ * Description :
+ * Take the oldest key press or release, FALSE if there is none (never blocks)
  */
-uint8 KEYPAD_getPressedKey(void);
+boolean KEYPAD_getEvent(KEYPAD_EventType *event);
 
 #endif /* KEYPAD_H_ */
@@ -14,6 +14,7 @@
 #include "bit_manipulation.h" /* For GET_BIT Macro */
 #include "lcd.h"
 #include "gpio.h"
+#include "profile.h"
 
 /*******************************************************************************
  *                      Functions Definitions                                  *
@@ -106,6 +107,7 @@ void LCD_sendCommand(uint8 command)
  */
 void LCD_displayCharacter(uint8 data)
 {
+	PROFILE_BEGIN(PROFILE_LCD_DISPLAY_CHARACTER);
 	GPIO_writePin(LCD_RS_PORT_ID,LCD_RS_PIN_ID,LOGIC_HIGH); /* Data Mode RS=1 */
 	_delay_ms(1); /* delay for processing Tas = 50ns */
 	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E=1 */
@@ -138,6 +140,7 @@ void LCD_displayCharacter(uint8 data)
 	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
 	_delay_ms(1); /* delay for processing Th = 13ns */
 #endif
+	PROFILE_END(PROFILE_LCD_DISPLAY_CHARACTER);
 }
 
 /*
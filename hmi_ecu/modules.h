@@ -21,6 +21,13 @@
 #include "keypad.h"
 #include "lcd.h"
 
+/* Services */
+#include "sw_timer.h"
+#include "coroutine.h"
+#include "crc.h"
+#include "diag_link.h"
+#include "profile.h"
+
 /* Utility */
 #include "bit_manipulation.h"
 #include "stdtypes.h"
@@ -0,0 +1,113 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Profiler
+ *  File        : profile.h
+ *  Description : Header file for the CPU cycle counter (TIMER1 free running
+ *                without prescaler, extended by its overflow interrupt) and
+ *                the profiling regions keeping count/min/max/total cycles
+ *                in RAM
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "stdtypes.h"
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/*
+ * Set to 0 (e.g. -DPROFILE_ENABLE=0) to compile the regions out. The cycle
+ * counter (TIMER1 and its overflow interrupt) then only runs if the TWI
+ * trace starts it.
+ */
+#ifndef PROFILE_ENABLE
+#define PROFILE_ENABLE                          1
+#endif
+
+/*------------------------------------------------------------------------------
+ *  Data Types Declarations
+ *----------------------------------------------------------------------------*/
+
+/* Regions of both ECUs, each one only uses its own */
+typedef enum
+{
+    PROFILE_EEPROM_READ_BLOCK,      /* Control ECU: EEPROM_readBlock */
+    PROFILE_IS_PASSWORD_CORRECT,    /* Control ECU: isPasswordCorrect */
+    PROFILE_LCD_DISPLAY_CHARACTER,  /* HMI ECU: LCD_displayCharacter */
+    PROFILE_KEYPAD_SCAN,            /* HMI ECU: one keypad matrix scan */
+    PROFILE_REGIONS
+} PROFILE_RegionType;
+
+typedef struct
+{
+    uint16 count;           /* Completed runs, saturating */
+    uint32 min_cycles;      /* 0xFFFFFFFF until the first run */
+    uint32 max_cycles;
+    uint32 total_cycles;    /* Saturating */
+} PROFILE_StatsType;
+
+/*------------------------------------------------------------------------------
+ *  Instrumentation Hooks
+ *----------------------------------------------------------------------------*/
+
+#if (PROFILE_ENABLE)
+#define PROFILE_BEGIN(id)                       PROFILE_begin(id)
+#define PROFILE_END(id)                         PROFILE_end(id)
+#else
+#define PROFILE_BEGIN(id)                       ((void)0)
+#define PROFILE_END(id)                         ((void)0)
+#endif
+
+/*------------------------------------------------------------------------------
+ *  Function Declarations
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] PROFILE_init
+ * [Description]   Starts the cycle counter on TIMER1 (once, later calls keep
+ *                 it running) and clears the regions.
+ *----------------------------------------------------------------------------*/
+void PROFILE_init(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] PROFILE_getCycles
+ * [Description]   CPU cycles since PROFILE_init, wraps after 2^32 cycles
+ *                 (537 s at 8 MHz). Callable from interrupt context.
+ *----------------------------------------------------------------------------*/
+uint32 PROFILE_getCycles(void);
+
+#if (PROFILE_ENABLE)
+
+/*------------------------------------------------------------------------------
+ * [Function Name] PROFILE_begin / PROFILE_end
+ * [Description]   Start and account one run of a region, the cost of the
+ *                 two calls is taken off. Regions may nest but not recurse.
+ *                 Use them through the PROFILE_BEGIN/END() macros.
+ *----------------------------------------------------------------------------*/
+void PROFILE_begin(PROFILE_RegionType id);
+void PROFILE_end(PROFILE_RegionType id);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] PROFILE_reset
+ * [Description]   Clears the statistics of all regions.
+ *----------------------------------------------------------------------------*/
+void PROFILE_reset(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] PROFILE_export
+ * [Description]   Sends one DIAG_FRAME_PROFILE_REGION frame per region
+ *                 ([id] [count] [min u32] [max u32] [total u32]) then one
+ *                 DIAG_FRAME_PROFILE_END frame ([cycles_per_us]
+ *                 [overhead_cycles]) through a_send.
+ *----------------------------------------------------------------------------*/
+void PROFILE_export(void (*a_send)(uint8));
+
+#endif /* PROFILE_ENABLE */
+
+#endif /* PROFILE_H_ */
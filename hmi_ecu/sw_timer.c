@@ -0,0 +1,315 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Software Timer Service
+ *  File        : sw_timer.c
+ *  Description : Source file for the 1 ms system tick (TIMER2 in CTC mode),
+ *                the uptime counter and the software timers multiplexed on
+ *                the tick (one-shot and periodic, any number running at the
+ *                same time up to SW_TIMER_MAX_TIMERS)
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "sw_timer.h"
+#include "timer.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/*
+ * Tick: TIMER2 in CTC mode with prescaler 64, the compare value giving one
+ * interrupt per millisecond is computed from F_CPU (124 at 8 MHz).
+ */
+#define SW_TIMER_TICK_PRESCALER                 64
+#define SW_TIMER_TICK_COMPARE_VALUE             ((F_CPU / SW_TIMER_TICK_PRESCALER / 1000UL) - 1)
+
+/* Duration of one TIMER2 count in microseconds (8 at 8 MHz) */
+#define SW_TIMER_COUNT_US                       ((SW_TIMER_TICK_PRESCALER * 1000000UL) / F_CPU)
+
+#if ((F_CPU / SW_TIMER_TICK_PRESCALER / 1000UL) > 256)
+#error "F_CPU too high for a 1 ms TIMER2 tick with prescaler 64"
+#endif
+
+#if ((F_CPU % (SW_TIMER_TICK_PRESCALER * 1000UL)) != 0)
+#warning "F_CPU is not a multiple of 64 kHz, the 1 ms tick will drift"
+#endif
+
+/*------------------------------------------------------------------------------
+ *  Data Types Declarations
+ *----------------------------------------------------------------------------*/
+
+/*
+ * Running timers form a list sorted by expiry time (delta list): each node
+ * keeps the ticks remaining after its predecessor expires, so a tick only
+ * decrements the head and pops the nodes that reached zero. Starting or
+ * stopping a timer walks the list (at most SW_TIMER_MAX_TIMERS nodes).
+ */
+typedef struct
+{
+    uint32 delta;                   /* Ticks after the previous node expires */
+    uint32 period;                  /* Reload value of a periodic timer */
+    void (*callback)(void *);
+    void *context;
+    SW_TIMER_ModeType mode;
+    SW_TIMER_IdType next;           /* Next node, SW_TIMER_INVALID_ID at the tail */
+    boolean running;
+} SW_TIMER_NodeType;
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+/* TIMER2 compare match interrupt every millisecond is the tick */
+static const TIMER_ConfigType g_SW_TIMER_tickConfiguration =
+    TIMER_CONFIG(TIMER_TIMER2, TIMER_PRESCALER_64, TIMER_COMPARE_MODE, 0, SW_TIMER_TICK_COMPARE_VALUE);
+
+/* Milliseconds since SW_TIMER_init */
+static volatile uint32 g_uptime_ms = 0;
+
+static volatile SW_TIMER_NodeType g_timers[SW_TIMER_MAX_TIMERS];
+
+/* Timer expiring first */
+static volatile SW_TIMER_IdType g_head = SW_TIMER_INVALID_ID;
+
+/*------------------------------------------------------------------------------
+ *  Private Functions
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] SW_TIMER_insert
+ * [Description]   Links a node at its place in the delta list. Timers with
+ *                 the same expiry keep their start order. Interrupts must be
+ *                 disabled.
+ *----------------------------------------------------------------------------*/
+static void SW_TIMER_insert(SW_TIMER_IdType id, uint32 ticks)
+{
+    SW_TIMER_IdType previous = SW_TIMER_INVALID_ID;
+    SW_TIMER_IdType current = g_head;
+
+    while ((current != SW_TIMER_INVALID_ID) && (ticks >= g_timers[current].delta))
+    {
+        ticks -= g_timers[current].delta;
+        previous = current;
+        current = g_timers[current].next;
+    }
+
+    g_timers[id].delta = ticks;
+    g_timers[id].next = current;
+
+    /* The following node now expires relative to the new one */
+    if (current != SW_TIMER_INVALID_ID)
+    {
+        g_timers[current].delta -= ticks;
+    }
+
+    if (previous == SW_TIMER_INVALID_ID)
+    {
+        g_head = id;
+    }
+    else
+    {
+        g_timers[previous].next = id;
+    }
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] SW_TIMER_unlink
+ * [Description]   Removes a running node from the delta list. Interrupts must
+ *                 be disabled.
+ *----------------------------------------------------------------------------*/
+static void SW_TIMER_unlink(SW_TIMER_IdType id)
+{
+    SW_TIMER_IdType previous = SW_TIMER_INVALID_ID;
+    SW_TIMER_IdType current = g_head;
+
+    while ((current != SW_TIMER_INVALID_ID) && (current != id))
+    {
+        previous = current;
+        current = g_timers[current].next;
+    }
+
+    if (current == SW_TIMER_INVALID_ID)
+    {
+        return;
+    }
+
+    /* Hand the remaining ticks over to the following node */
+    if (g_timers[id].next != SW_TIMER_INVALID_ID)
+    {
+        g_timers[g_timers[id].next].delta += g_timers[id].delta;
+    }
+
+    if (previous == SW_TIMER_INVALID_ID)
+    {
+        g_head = g_timers[id].next;
+    }
+    else
+    {
+        g_timers[previous].next = g_timers[id].next;
+    }
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] SW_TIMER_tick
+ * [Description]   TIMER2 callback: counts the uptime, advances the head timer
+ *                 and expires every timer reaching zero.
+ *----------------------------------------------------------------------------*/
+static void SW_TIMER_tick(void *context)
+{
+    (void)context;
+
+    g_uptime_ms++;
+
+    if (g_head == SW_TIMER_INVALID_ID)
+    {
+        return;
+    }
+
+    if (g_timers[g_head].delta > 0)
+    {
+        g_timers[g_head].delta--;
+    }
+
+    while ((g_head != SW_TIMER_INVALID_ID) && (g_timers[g_head].delta == 0))
+    {
+        SW_TIMER_IdType expired = g_head;
+        void (*callback)(void *) = g_timers[expired].callback;
+        void *callback_context = g_timers[expired].context;
+
+        g_head = g_timers[expired].next;
+
+        if (g_timers[expired].mode == SW_TIMER_PERIODIC)
+        {
+            SW_TIMER_insert(expired, g_timers[expired].period);
+        }
+        else
+        {
+            g_timers[expired].running = FALSE;
+        }
+
+        if (callback != NULL)
+        {
+            callback(callback_context);
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------
+ *  Functions Definitions
+ *----------------------------------------------------------------------------*/
+
+void SW_TIMER_init(void)
+{
+    SW_TIMER_IdType id;
+
+    TIMER_deInit(TIMER_TIMER2);
+
+    for (id = 0; id < SW_TIMER_MAX_TIMERS; id++)
+    {
+        g_timers[id].running = FALSE;
+    }
+    g_head = SW_TIMER_INVALID_ID;
+    g_uptime_ms = 0;
+
+    TIMER_setCallBack(SW_TIMER_tick, NULL, TIMER_CALLBACK_PERIODIC, 1, TIMER_TIMER2);
+    TIMER_init(&g_SW_TIMER_tickConfiguration);
+}
+
+uint32 SW_TIMER_millis(void)
+{
+    uint32 uptime;
+    uint8 sreg;
+
+    /* Four byte read, the tick must not update it halfway */
+    sreg = SREG;
+    cli();
+    uptime = g_uptime_ms;
+    SREG = sreg;
+
+    return uptime;
+}
+
+uint32 SW_TIMER_micros(void)
+{
+    uint32 uptime;
+    uint8 count;
+    uint8 sreg;
+
+    sreg = SREG;
+    cli();
+    uptime = g_uptime_ms;
+    count = TCNT2;
+
+    /* The counter already restarted but the tick interrupt is still pending */
+    if ((TIFR & (1 << OCF2)) && (count < SW_TIMER_TICK_COMPARE_VALUE))
+    {
+        uptime++;
+    }
+    SREG = sreg;
+
+    return (uptime * 1000UL) + ((uint32)count * SW_TIMER_COUNT_US);
+}
+
+SW_TIMER_IdType SW_TIMER_start(uint32 milliseconds, SW_TIMER_ModeType mode,
+                               void (*a_callback)(void *), void *a_context)
+{
+    SW_TIMER_IdType id;
+    uint8 sreg;
+
+    if (milliseconds == 0)
+    {
+        milliseconds = 1;
+    }
+
+    sreg = SREG;
+    cli();
+
+    for (id = 0; id < SW_TIMER_MAX_TIMERS; id++)
+    {
+        if (!g_timers[id].running)
+        {
+            g_timers[id].period = milliseconds;
+            g_timers[id].callback = a_callback;
+            g_timers[id].context = a_context;
+            g_timers[id].mode = mode;
+            g_timers[id].running = TRUE;
+            SW_TIMER_insert(id, milliseconds);
+            break;
+        }
+    }
+
+    SREG = sreg;
+
+    return (id < SW_TIMER_MAX_TIMERS) ? id : SW_TIMER_INVALID_ID;
+}
+
+void SW_TIMER_stop(SW_TIMER_IdType id)
+{
+    uint8 sreg;
+
+    if (id >= SW_TIMER_MAX_TIMERS)
+    {
+        return;
+    }
+
+    sreg = SREG;
+    cli();
+
+    if (g_timers[id].running)
+    {
+        SW_TIMER_unlink(id);
+        g_timers[id].running = FALSE;
+    }
+
+    SREG = sreg;
+}
+
+boolean SW_TIMER_isRunning(SW_TIMER_IdType id)
+{
+    return (id < SW_TIMER_MAX_TIMERS) ? g_timers[id].running : FALSE;
+}
@@ -0,0 +1,92 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Software Timer Service
+ *  File        : sw_timer.h
+ *  Description : Header file for the 1 ms system tick (TIMER2 in CTC mode),
+ *                the uptime counter and the software timers multiplexed on
+ *                the tick (one-shot and periodic, any number running at the
+ *                same time up to SW_TIMER_MAX_TIMERS)
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+#ifndef SW_TIMER_H_
+#define SW_TIMER_H_
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "stdtypes.h"
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/* Timers that can run at the same time */
+#ifndef SW_TIMER_MAX_TIMERS
+#define SW_TIMER_MAX_TIMERS                     8
+#endif
+
+/* Returned by SW_TIMER_start when all timers are in use */
+#define SW_TIMER_INVALID_ID                     0xFF
+
+/*------------------------------------------------------------------------------
+ *  Data Types Declarations
+ *----------------------------------------------------------------------------*/
+
+typedef uint8 SW_TIMER_IdType;
+
+typedef enum
+{
+    SW_TIMER_ONE_SHOT,      /* Expires once then frees its slot */
+    SW_TIMER_PERIODIC       /* Restarts with the same period at every expiry */
+} SW_TIMER_ModeType;
+
+/*------------------------------------------------------------------------------
+ *  Function Declarations
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] SW_TIMER_init
+ * [Description]   Stops all timers, clears the uptime and starts the 1 ms
+ *                 TIMER2 tick.
+ *----------------------------------------------------------------------------*/
+void SW_TIMER_init(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] SW_TIMER_millis
+ * [Description]   Milliseconds since SW_TIMER_init (wraps after 49.7 days),
+ *                 read atomically.
+ *----------------------------------------------------------------------------*/
+uint32 SW_TIMER_millis(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] SW_TIMER_micros
+ * [Description]   Microseconds since SW_TIMER_init with the resolution of one
+ *                 TIMER2 count (8 us at 8 MHz), wraps after 71.6 minutes.
+ *                 Callable from interrupt context.
+ *----------------------------------------------------------------------------*/
+uint32 SW_TIMER_micros(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] SW_TIMER_start
+ * [Description]   Starts a timer expiring after 'milliseconds' (0 counts as
+ *                 1). The callback (may be NULL) receives a_context, runs in
+ *                 the tick interrupt and must stay short. Returns the timer
+ *                 id or SW_TIMER_INVALID_ID.
+ *----------------------------------------------------------------------------*/
+SW_TIMER_IdType SW_TIMER_start(uint32 milliseconds, SW_TIMER_ModeType mode,
+                               void (*a_callback)(void *), void *a_context);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] SW_TIMER_stop
+ * [Description]   Stops a running timer, its callback is not called.
+ *----------------------------------------------------------------------------*/
+void SW_TIMER_stop(SW_TIMER_IdType id);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] SW_TIMER_isRunning
+ * [Description]   TRUE until a one-shot timer expires or any timer is stopped.
+ *----------------------------------------------------------------------------*/
+boolean SW_TIMER_isRunning(SW_TIMER_IdType id);
+
+#endif /* SW_TIMER_H_ */
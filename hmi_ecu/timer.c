@@ -20,9 +20,82 @@
  *  Functions
  *----------------------------------------------------------------------------*/
 
-static void (*g_TIMER0_CallBackPtr)(void) = NULL;
-static void (*g_TIMER1_CallBackPtr)(void) = NULL;
-static void (*g_TIMER2_CallBackPtr)(void) = NULL;
+/* Clock select value (CSn2:0) of a TIMER_ClockType the timer does not have */
+#define TIMER_INVALID_CLOCK     0xFF
+
+/* Register bits of one timer, indexed by TIMER_ID_Type */
+typedef struct
+{
+    uint8 normal_bits;              // Control register bits of the overflow mode
+    uint8 ctc_bits;                 // Control register bits of the compare (CTC) mode
+    uint8 overflow_interrupt;       // TIMSK overflow interrupt enable
+    uint8 compare_interrupt;        // TIMSK compare match interrupt enable
+    uint8 clock_select[8];          // CSn2:0 per TIMER_ClockType
+} TIMER_DescriptorType;
+
+static const TIMER_DescriptorType g_TIMER_descriptors[3] =
+{
+    /* TIMER0: TCCR0, FOC0 set as in non-PWM modes */
+    { (1 << FOC0), (1 << FOC0) | (1 << WGM01), (1 << TOIE0), (1 << OCIE0),
+      { 0, 1, 2, TIMER_INVALID_CLOCK, 3, TIMER_INVALID_CLOCK, 4, 5 } },
+
+    /* TIMER1: TCCR1B (mode 4, CTC with OCR1A top) */
+    { 0, (1 << WGM12), (1 << TOIE1), (1 << OCIE1A),
+      { 0, 1, 2, TIMER_INVALID_CLOCK, 3, TIMER_INVALID_CLOCK, 4, 5 } },
+
+    /* TIMER2: TCCR2, the asynchronous timer has the 32 and 128 prescalers */
+    { 0, (1 << WGM21), (1 << TOIE2), (1 << OCIE2),
+      { 0, 1, 2, 3, 4, 5, 6, 7 } }
+};
+
+/* Registered callback and its interrupt counter, per timer */
+typedef struct
+{
+    void (*callback)(void *);
+    void *context;
+    uint16 reload;                  // Interrupts per call
+    uint16 remaining;               // Interrupts left before the next call
+    TIMER_CallBackModeType mode;
+} TIMER_CallBackType;
+
+static volatile TIMER_CallBackType g_TIMER_CallBacks[3];
+
+/*
+ *  Function: TIMER_disableInterrupts
+ *  Description: Disables the overflow and compare match interrupts of a timer.
+ */
+static void TIMER_disableInterrupts(TIMER_ID_Type TIMER_type)
+{
+    switch (TIMER_type)
+    {
+        case TIMER_TIMER0: TIMSK &= ~((1 << TOIE0) | (1 << OCIE0)); break;
+        case TIMER_TIMER1: TIMSK &= ~((1 << TOIE1) | (1 << OCIE1A)); break;
+        case TIMER_TIMER2: TIMSK &= ~((1 << TOIE2) | (1 << OCIE2)); break;
+    }
+}
+
+/*
+ *  Function: TIMER_dispatch
+ *  Description: Common ISR body: counts the interrupt and calls the callback
+ *               when its count is reached.
+ */
+static void TIMER_dispatch(TIMER_ID_Type TIMER_type)
+{
+    volatile TIMER_CallBackType *entry = &g_TIMER_CallBacks[TIMER_type];
+
+    if ((entry->callback == NULL) || (--entry->remaining != 0))
+    {
+        return;
+    }
+
+    entry->remaining = entry->reload;
+    if (entry->mode == TIMER_CALLBACK_ONE_SHOT)
+    {
+        TIMER_disableInterrupts(TIMER_type);
+    }
+
+    entry->callback(entry->context);  // Execute callback
+}
 
 /**
  * Function: TIMER_init
@@ -33,224 +106,53 @@ static void (*g_TIMER2_CallBackPtr)(void) = NULL;
  */
 void TIMER_init(const TIMER_ConfigType * Config_Ptr)
 {
-    // Set initial TIMER value
+    const TIMER_DescriptorType *timer = &g_TIMER_descriptors[Config_Ptr->TIMER_ID];
+    uint8 clock_select = timer->clock_select[Config_Ptr->TIMER_clock];
+    uint8 control;
+    uint8 interrupt;
+
+    // The prescaler does not exist on this timer (see TIMER_CONFIG)
+    if (clock_select == TIMER_INVALID_CLOCK)
+    {
+        return;
+    }
+
+    // Control register value: waveform mode and clock select, written once
+    if (Config_Ptr->TIMER_mode == TIMER_COMPARE_MODE)
+    {
+        control = timer->ctc_bits | clock_select;
+        interrupt = timer->compare_interrupt;
+    }
+    else
+    {
+        control = timer->normal_bits | clock_select;
+        interrupt = timer->overflow_interrupt;
+    }
+
     switch (Config_Ptr->TIMER_ID)
     {
         case TIMER_TIMER0:
-            // Set the initial count value for TIMER0
             TCNT0 = Config_Ptr->TIMER_InitialValue;
-
-            // Configure the mode for TIMER0
-            switch (Config_Ptr->TIMER_mode)
-            {
-                case TIMER_OVERFLOW_MODE:
-                    SET_BIT(TIMSK, TOIE0);  // Enable overflow interrupt for TIMER0
-                    SET_BIT(TCCR0, FOC0);   // Force Output Compare for non-PWM mode
-                    CLEAR_BIT(TCCR0, WGM00); // Normal Mode
-                    CLEAR_BIT(TCCR0, WGM01);
-
-                    break;
-
-                case TIMER_COMPARE_MODE:
-                    OCR0 = Config_Ptr->TIMER_compare_MatchValue; // Compare match value
-                    SET_BIT(TIMSK, OCIE0);  // Enable compare match interrupt for TIMER0
-                    SET_BIT(TCCR0, FOC0);   // Force Output Compare for non-PWM mode
-                    CLEAR_BIT(TCCR0, WGM00); // CTC Mode
-                    SET_BIT(TCCR0, WGM01);
-
-                    break;
-            }
-
-            // Configure prescaler for TIMER0
-            switch (Config_Ptr->TIMER_clock)
-            {
-                case TIMER_NO_CLOCK_SOURCE:
-                    CLEAR_BIT(TCCR0, CS00);
-                    CLEAR_BIT(TCCR0, CS01);
-                    CLEAR_BIT(TCCR0, CS02);
-
-                    break;
-                case TIMER_NO_PRESCALING:
-                    SET_BIT(TCCR0, CS00);
-                    CLEAR_BIT(TCCR0, CS01);
-                    CLEAR_BIT(TCCR0, CS02);
-
-                    break;
-                case TIMER_PRESCALER_8:
-                    CLEAR_BIT(TCCR0, CS00);
-                    SET_BIT(TCCR0, CS01);
-                    CLEAR_BIT(TCCR0, CS02);
-
-                    break;
-                case TIMER_PRESCALER_64:
-                    SET_BIT(TCCR0, CS00);
-                    SET_BIT(TCCR0, CS01);
-                    CLEAR_BIT(TCCR0, CS02);
-
-                    break;
-                case TIMER_PRESCALER_256:
-                    CLEAR_BIT(TCCR0, CS00);
-                    CLEAR_BIT(TCCR0, CS01);
-                    SET_BIT(TCCR0, CS02);
-
-                    break;
-                case TIMER_PRESCALER_1024:
-                    SET_BIT(TCCR0, CS00);
-                    CLEAR_BIT(TCCR0, CS01);
-                    SET_BIT(TCCR0, CS02);
-
-                    break;
-            }
-
+            OCR0 = Config_Ptr->TIMER_compare_MatchValue;
+            TCCR0 = control;
             break;
 
         case TIMER_TIMER1:
-            // Set the initial count value for TIMER1
             TCNT1 = Config_Ptr->TIMER_InitialValue;
-
-            // Configure the mode for TIMER1
-            switch (Config_Ptr->TIMER_mode)
-            {
-                case TIMER_OVERFLOW_MODE:
-                    SET_BIT(TIMSK, TOIE1);  // Enable overflow interrupt for TIMER1
-                    CLEAR_BIT(TCCR1A, WGM10); // Normal Mode
-                    CLEAR_BIT(TCCR1A, WGM11);
-                    CLEAR_BIT(TCCR1B, WGM12);
-                    CLEAR_BIT(TCCR1B, WGM13);
-
-                    break;
-
-                case TIMER_COMPARE_MODE:
-                    OCR1A = Config_Ptr->TIMER_compare_MatchValue; // Compare match value
-                    SET_BIT(TIMSK, OCIE1A); // Enable compare match interrupt for TIMER1
-                    CLEAR_BIT(TCCR1A, WGM10); // CTC Mode
-                    CLEAR_BIT(TCCR1A, WGM11);
-                    SET_BIT(TCCR1B, WGM12);
-                    CLEAR_BIT(TCCR1B, WGM13);
-
-                    break;
-            }
-
-            // Configure prescaler for TIMER1
-            switch (Config_Ptr->TIMER_clock)
-            {
-                case TIMER_NO_CLOCK_SOURCE:
-                    CLEAR_BIT(TCCR1B, CS10);
-                    CLEAR_BIT(TCCR1B, CS11);
-                    CLEAR_BIT(TCCR1B, CS12);
-
-                    break;
-                case TIMER_NO_PRESCALING:
-                    SET_BIT(TCCR1B, CS10);
-                    CLEAR_BIT(TCCR1B, CS11);
-                    CLEAR_BIT(TCCR1B, CS12);
-
-                    break;
-                case TIMER_PRESCALER_8:
-                    CLEAR_BIT(TCCR1B, CS10);
-                    SET_BIT(TCCR1B, CS11);
-                    CLEAR_BIT(TCCR1B, CS12);
-
-                    break;
-                case TIMER_PRESCALER_64:
-                    SET_BIT(TCCR1B, CS10);
-                    SET_BIT(TCCR1B, CS11);
-                    CLEAR_BIT(TCCR1B, CS12);
-
-                    break;
-                case TIMER_PRESCALER_256:
-                    CLEAR_BIT(TCCR1B, CS10);
-                    CLEAR_BIT(TCCR1B, CS11);
-                    SET_BIT(TCCR1B, CS12);
-
-                    break;
-                case TIMER_PRESCALER_1024:
-                    SET_BIT(TCCR1B, CS10);
-                    CLEAR_BIT(TCCR1B, CS11);
-                    SET_BIT(TCCR1B, CS12);
-
-                    break;
-            }
-
+            OCR1A = Config_Ptr->TIMER_compare_MatchValue;
+            TCCR1A = 0;         // WGM11:10 = 0 in normal and CTC mode, no output compare pins
+            TCCR1B = control;
             break;
 
         case TIMER_TIMER2:
-            // Set the initial count value for TIMER2
             TCNT2 = Config_Ptr->TIMER_InitialValue;
-
-            // Configure the mode for TIMER2
-            switch (Config_Ptr->TIMER_mode)
-            {
-                case TIMER_OVERFLOW_MODE:
-                    SET_BIT(TIMSK, TOIE2);  // Enable overflow interrupt for TIMER2
-                    CLEAR_BIT(TCCR2, WGM20); // Normal Mode
-                    CLEAR_BIT(TCCR2, WGM21);
-
-                    break;
-
-                case TIMER_COMPARE_MODE:
-                    OCR2 = Config_Ptr->TIMER_compare_MatchValue; // Compare match value
-                    SET_BIT(TIMSK, OCIE2);  // Enable compare match interrupt for TIMER2
-                    CLEAR_BIT(TCCR2, WGM20); // CTC Mode
-                    SET_BIT(TCCR2, WGM21);
-
-                    break;
-            }
-
-            // Configure prescaler for TIMER2
-            switch (Config_Ptr->TIMER_clock)
-            {
-                case TIMER_NO_CLOCK_SOURCE:
-                    CLEAR_BIT(TCCR2, CS20);
-                    CLEAR_BIT(TCCR2, CS21);
-                    CLEAR_BIT(TCCR2, CS22);
-
-                    break;
-                case TIMER_NO_PRESCALING:
-                    SET_BIT(TCCR2, CS20);
-                    CLEAR_BIT(TCCR2, CS21);
-                    CLEAR_BIT(TCCR2, CS22);
-
-                    break;
-                case TIMER_PRESCALER_8:
-                    CLEAR_BIT(TCCR2, CS20);
-                    SET_BIT(TCCR2, CS21);
-                    CLEAR_BIT(TCCR2, CS22);
-
-                    break;
-                case TIMER_PRESCALER_32:
-                    SET_BIT(TCCR2, CS20);
-                    SET_BIT(TCCR2, CS21);
-                    CLEAR_BIT(TCCR2, CS22);
-
-                    break;
-                case TIMER_PRESCALER_64:
-                    CLEAR_BIT(TCCR2, CS20);
-                    CLEAR_BIT(TCCR2, CS21);
-                    SET_BIT(TCCR2, CS22);
-
-                    break;
-                case TIMER_PRESCALER_128:
-                    SET_BIT(TCCR2, CS20);
-                    CLEAR_BIT(TCCR2, CS21);
-                    SET_BIT(TCCR2, CS22);
-
-                    break;
-                case TIMER_PRESCALER_256:
-                    CLEAR_BIT(TCCR2, CS20);
-                    SET_BIT(TCCR2, CS21);
-                    SET_BIT(TCCR2, CS22);
-
-                    break;
-                case TIMER_PRESCALER_1024:
-                    SET_BIT(TCCR2, CS20);
-                    SET_BIT(TCCR2, CS21);
-                    SET_BIT(TCCR2, CS22);
-
-                    break;
-            }
+            OCR2 = Config_Ptr->TIMER_compare_MatchValue;
+            TCCR2 = control;
             break;
     }
+
+    // TIMSK is shared by the three timers: one read-modify-write of this timer's bits
+    TIMSK = (TIMSK & ~(timer->overflow_interrupt | timer->compare_interrupt)) | interrupt;
 }
 
 /*  Callback Function Registration
@@ -259,13 +161,25 @@ void TIMER_init(const TIMER_ConfigType * Config_Ptr)
  *               This callback will be called within the corresponding ISR.
  */
 
-void TIMER_setCallBack(void (*a_ptr)(void), TIMER_ID_Type a_TIMER_ID)
+void TIMER_setCallBack(void (*a_ptr)(void *), void *a_context, TIMER_CallBackModeType a_mode,
+                       uint16 a_ticks, TIMER_ID_Type a_TIMER_ID)
 {
-    switch (a_TIMER_ID) {
-        case TIMER_TIMER0: g_TIMER0_CallBackPtr = a_ptr; break;  // Register callback for TIMER0
-        case TIMER_TIMER1: g_TIMER1_CallBackPtr = a_ptr; break;  // Register callback for TIMER1
-        case TIMER_TIMER2: g_TIMER2_CallBackPtr = a_ptr; break;  // Register callback for TIMER2
+    volatile TIMER_CallBackType *entry = &g_TIMER_CallBacks[a_TIMER_ID];
+    uint8 sreg = SREG;
+
+    if (a_ticks == 0)
+    {
+        a_ticks = 1;
     }
+
+    // The ISR must not see a half registered callback
+    cli();
+    entry->callback = a_ptr;
+    entry->context = a_context;
+    entry->mode = a_mode;
+    entry->reload = a_ticks;
+    entry->remaining = a_ticks;
+    SREG = sreg;
 }
 
 /*
@@ -284,7 +198,7 @@ void TIMER_deInit(TIMER_ID_Type TIMER_type)
             OCR0 = 0;            // Reset compare register
             CLEAR_BIT(TIMSK,TOIE0);  // Disable overflow interrupt
             CLEAR_BIT(TIMSK,OCIE0);  // Disable compare match interrupt
-            g_TIMER0_CallBackPtr = NULL;  // Clear callback pointer
+            g_TIMER_CallBacks[TIMER_TIMER0].callback = NULL;  // Clear callback pointer
 
             break;
 
@@ -294,7 +208,7 @@ void TIMER_deInit(TIMER_ID_Type TIMER_type)
             TCNT1 = 0;
             CLEAR_BIT(TIMSK,TOIE1);  // Disable overflow interrupt
             CLEAR_BIT(TIMSK,OCIE1A); // Disable compare match interrupt
-            g_TIMER1_CallBackPtr = NULL; // Clear callback pointer
+            g_TIMER_CallBacks[TIMER_TIMER1].callback = NULL; // Clear callback pointer
 
             break;
 
@@ -304,7 +218,7 @@ void TIMER_deInit(TIMER_ID_Type TIMER_type)
             OCR2 = 0;
             CLEAR_BIT(TIMSK,TOIE2);  // Disable overflow interrupt
             CLEAR_BIT(TIMSK,OCIE2);  // Disable compare match interrupt
-            g_TIMER2_CallBackPtr = NULL; // Clear callback pointer
+            g_TIMER_CallBacks[TIMER_TIMER2].callback = NULL; // Clear callback pointer
 
             break;
     }
@@ -316,49 +230,31 @@ void TIMER_deInit(TIMER_ID_Type TIMER_type)
 
 ISR(TIMER0_OVF_vect)   // ISR for Timer0 overflow
 {
-    if (g_TIMER0_CallBackPtr)
-    {
-        g_TIMER0_CallBackPtr();  // Execute callback if set
-    }
+    TIMER_dispatch(TIMER_TIMER0);
 }
 
 ISR(TIMER0_COMP_vect)  // ISR for Timer0 compare match
 {
-    if (g_TIMER0_CallBackPtr)
-    {
-        g_TIMER0_CallBackPtr();  // Execute callback if set
-    }
+    TIMER_dispatch(TIMER_TIMER0);
 }
 
 ISR(TIMER1_OVF_vect)   // ISR for Timer1 overflow
 {
-    if (g_TIMER1_CallBackPtr)
-    {
-        g_TIMER1_CallBackPtr();  // Execute callback if set
-    }
+    TIMER_dispatch(TIMER_TIMER1);
 }
 
 ISR(TIMER1_COMPA_vect) // ISR for Timer1 compare match
 {
-    if (g_TIMER1_CallBackPtr)
-    {
-        g_TIMER1_CallBackPtr();  // Execute callback if set
-    }
+    TIMER_dispatch(TIMER_TIMER1);
 }
 
 ISR(TIMER2_OVF_vect)   // ISR for Timer2 overflow
 {
-    if (g_TIMER2_CallBackPtr)
-    {
-        g_TIMER2_CallBackPtr();  // Execute callback if set
-    }
+    TIMER_dispatch(TIMER_TIMER2);
 }
 
 ISR(TIMER2_COMP_vect)  // ISR for Timer2 compare match
 {
-    if (g_TIMER2_CallBackPtr)
-    {
-        g_TIMER2_CallBackPtr();  // Execute callback if set
-    }
+    TIMER_dispatch(TIMER_TIMER2);
 }
 
@@ -52,6 +52,16 @@ typedef enum
     TIMER_COMPARE_MODE      // Timer compare match mode
 } TIMER_ModeType;
 
+/**
+ * Enum: TIMER_CallBackModeType
+ * Description: How the driver calls a registered callback.
+ */
+typedef enum
+{
+    TIMER_CALLBACK_PERIODIC,    // Called every N interrupts
+    TIMER_CALLBACK_ONE_SHOT     // Called once after N interrupts, then the timer interrupt is disabled
+} TIMER_CallBackModeType;
+
 /**
  * Struct: TIMER_ConfigType
  * Description: Configuration structure for timer initialization.
@@ -71,6 +81,25 @@ typedef struct
     TIMER_ModeType TIMER_mode;          // Mode selection (Overflow or Compare)
 } TIMER_ConfigType;
 
+/**
+ * Macro: TIMER_CONFIG
+ * Description: Builds a TIMER_ConfigType initializer and rejects at compile
+ *              time the combinations the hardware does not support:
+ *              TIMER_PRESCALER_32/128 outside TIMER2 and a compare value above
+ *              255 on the 8-bit timers. The arguments must be constants.
+ *              Example: TIMER_CONFIG(TIMER_TIMER2, TIMER_PRESCALER_64, TIMER_COMPARE_MODE, 0, 124)
+ */
+#define TIMER_CLOCK_IS_VALID(id, clock) \
+    (((id) == TIMER_TIMER2) || (((clock) != TIMER_PRESCALER_32) && ((clock) != TIMER_PRESCALER_128)))
+
+#define TIMER_COMPARE_IS_VALID(id, compare) \
+    (((id) == TIMER_TIMER1) || ((compare) <= 0xFF))
+
+#define TIMER_CONFIG(id, clock, mode, initial, compare) \
+    { (initial), \
+      (compare) + (0 * sizeof(char[(TIMER_CLOCK_IS_VALID(id, clock) && TIMER_COMPARE_IS_VALID(id, compare)) ? 1 : -1])), \
+      (id), (clock), (mode) }
+
 /*------------------------------------------------------------------------------
  *  Function Declarations
  *----------------------------------------------------------------------------*/
@@ -87,11 +116,17 @@ void TIMER_init(const TIMER_ConfigType * Config_Ptr);
 /**
  * Function: TIMER_setCallBack
  * Description: Registers a callback function to be executed in the timer's ISR.
+ *              The driver counts the interrupts, the callback only runs every
+ *              a_ticks interrupts (periodic) or once after a_ticks (one-shot).
  * Parameters:
- *   - a_ptr: Pointer to the callback function.
+ *   - a_ptr: Pointer to the callback function, it receives a_context.
+ *   - a_context: Caller data passed back to the callback (may be NULL).
+ *   - a_mode: TIMER_CALLBACK_PERIODIC or TIMER_CALLBACK_ONE_SHOT.
+ *   - a_ticks: Interrupts per call (0 counts as 1).
  *   - a_TIMER_ID: Timer identifier to assign the callback.
  */
-void TIMER_setCallBack(void (*a_ptr)(void), TIMER_ID_Type a_TIMER_ID);
+void TIMER_setCallBack(void (*a_ptr)(void *), void *a_context, TIMER_CallBackModeType a_mode,
+                       uint16 a_ticks, TIMER_ID_Type a_TIMER_ID);
 
 /**
  * Function: TIMER_deInit
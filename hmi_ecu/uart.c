@@ -193,3 +193,8 @@ void UART_flush(void)
         dummy = UDR;  // Read and discard data
     }
 }
+
+uint8 UART_isDataAvailable(void)
+{
+    return IS_BIT_SET(UCSRA,RXC) ? TRUE : FALSE;
+}
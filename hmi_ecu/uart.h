@@ -87,4 +87,10 @@ void UART_sendString(const uint8 *Str);
 void UART_receiveString(uint8 *Str); // Receive until #
 void UART_flush(void);
 
+/*
+ * Description :
+ * Returns TRUE if a received byte is waiting in the Rx buffer (never blocks)
+ */
+uint8 UART_isDataAvailable(void);
+
 #endif /* UART_H_ */
@@ -0,0 +1,31 @@
+/*------------------------------------------------------------------------------
+ *  Module      : AVR Register Model (host builds)
+ *  File        : interrupt.h
+ *  Description : Host stand-in for <avr/interrupt.h>: an ISR is a plain
+ *                function the host program calls to deliver the interrupt,
+ *                sei() and cli() set and clear the I bit of SREG
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+#ifndef AVR_INTERRUPT_H_
+#define AVR_INTERRUPT_H_
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include <avr/io.h>
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/* Global interrupt enable bit of SREG */
+#define AVR_MODEL_SREG_I                        7
+
+#define ISR(vector)                             void vector(void); void vector(void)
+
+#define sei()                                   (SREG |= (uint8_t)(1 << AVR_MODEL_SREG_I))
+#define cli()                                   (SREG &= (uint8_t)~(1 << AVR_MODEL_SREG_I))
+
+#endif /* AVR_INTERRUPT_H_ */
@@ -0,0 +1,201 @@
+/*------------------------------------------------------------------------------
+ *  Module      : AVR Register Model (host builds)
+ *  File        : io.h
+ *  Description : Host stand-in for <avr/io.h>: the ATmega32 I/O registers
+ *                used by both ECUs as variables (avr_model.c) and their bit
+ *                numbers, so the ECU sources compile unchanged on a Linux
+ *                host
+ *  Author      : Hassan Darwish
+ *
+ *  Found first on the include path of the host programs (-I host). The input
+ *  pin registers are read through avr_model.c, a program connects what
+ *  drives the pins with AVR_MODEL_setPinReader(). EECR and EEDR go through
+ *  the on-chip EEPROM model of avr_model.c.
+ *----------------------------------------------------------------------------*/
+
+#ifndef AVR_IO_H_
+#define AVR_IO_H_
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*------------------------------------------------------------------------------
+ *  Registers
+ *----------------------------------------------------------------------------*/
+
+extern volatile uint8_t SREG;
+extern volatile uint8_t DDRA;
+extern volatile uint8_t DDRB;
+extern volatile uint8_t DDRC;
+extern volatile uint8_t DDRD;
+extern volatile uint8_t PORTA;
+extern volatile uint8_t PORTB;
+extern volatile uint8_t PORTC;
+extern volatile uint8_t PORTD;
+extern volatile uint8_t TCCR0;
+extern volatile uint8_t TCNT0;
+extern volatile uint8_t OCR0;
+extern volatile uint8_t TIMSK;
+extern volatile uint8_t TIFR;
+extern volatile uint8_t TCCR1A;
+extern volatile uint8_t TCCR1B;
+extern volatile uint8_t OCR1AH;
+extern volatile uint8_t OCR1AL;
+extern volatile uint8_t TCCR2;
+extern volatile uint8_t TCNT2;
+extern volatile uint8_t OCR2;
+extern volatile uint8_t ASSR;
+extern volatile uint8_t UCSRA;
+extern volatile uint8_t UCSRB;
+extern volatile uint8_t UCSRC;
+extern volatile uint8_t UBRRL;
+extern volatile uint8_t UBRRH;
+extern volatile uint8_t UDR;
+extern volatile uint8_t TWBR;
+extern volatile uint8_t TWSR;
+extern volatile uint8_t TWAR;
+extern volatile uint8_t TWCR;
+extern volatile uint8_t TWDR;
+extern volatile uint8_t MCUCR;
+extern volatile uint8_t MCUCSR;
+extern volatile uint8_t GICR;
+extern volatile uint8_t WDTCR;
+extern volatile uint8_t SFIOR;
+extern volatile uint16_t TCNT1;
+extern volatile uint16_t OCR1A;
+extern volatile uint16_t OCR1B;
+extern volatile uint16_t ICR1;
+extern volatile uint16_t EEAR;
+
+/* Ports A to D */
+uint8_t AVR_MODEL_readPins(uint8_t port);
+#define PINA                                    AVR_MODEL_readPins(0)
+#define PINB                                    AVR_MODEL_readPins(1)
+#define PINC                                    AVR_MODEL_readPins(2)
+#define PIND                                    AVR_MODEL_readPins(3)
+
+/* On-chip EEPROM, each access lets the model read, program and raise EE_RDY */
+volatile uint8_t *AVR_MODEL_eepromControl(void);
+volatile uint8_t *AVR_MODEL_eepromData(void);
+#define EECR                                    (*AVR_MODEL_eepromControl())
+#define EEDR                                    (*AVR_MODEL_eepromData())
+
+/*------------------------------------------------------------------------------
+ *  Bit Numbers
+ *----------------------------------------------------------------------------*/
+
+/* Timer interrupt mask and flag registers (TIMSK, TIFR) */
+#define OCIE2                                   7
+#define TOIE2                                   6
+#define TICIE1                                  5
+#define OCIE1A                                  4
+#define OCIE1B                                  3
+#define TOIE1                                   2
+#define OCIE0                                   1
+#define TOIE0                                   0
+#define OCF2                                    7
+#define TOV2                                    6
+#define OCF1A                                   4
+#define TOV1                                    2
+#define OCF0                                    1
+#define TOV0                                    0
+
+/* Timer control registers */
+#define FOC0                                    7
+#define WGM00                                   6
+#define COM01                                   5
+#define COM00                                   4
+#define WGM01                                   3
+#define CS02                                    2
+#define CS01                                    1
+#define CS00                                    0
+#define COM20                                   4
+#define COM21                                   5
+#define FOC1A                                   3
+#define FOC1B                                   2
+#define WGM10                                   0
+#define WGM11                                   1
+#define WGM12                                   3
+#define WGM13                                   4
+#define CS12                                    2
+#define CS11                                    1
+#define CS10                                    0
+#define FOC2                                    7
+#define WGM20                                   6
+#define WGM21                                   3
+#define CS22                                    2
+#define CS21                                    1
+#define CS20                                    0
+
+/* USART */
+#define RXC                                     7
+#define TXC                                     6
+#define UDRE                                    5
+#define FE                                      4
+#define DOR                                     3
+#define PE                                      2
+#define U2X                                     1
+#define MPCM                                    0
+#define RXCIE                                   7
+#define TXCIE                                   6
+#define UDRIE                                   5
+#define RXEN                                    4
+#define TXEN                                    3
+#define UCSZ2                                   2
+#define RXB8                                    1
+#define TXB8                                    0
+#define URSEL                                   7
+#define UMSEL                                   6
+#define UPM1                                    5
+#define UPM0                                    4
+#define USBS                                    3
+#define UCSZ1                                   2
+#define UCSZ0                                   1
+#define UCPOL                                   0
+
+/* TWI */
+#define TWINT                                   7
+#define TWEA                                    6
+#define TWSTA                                   5
+#define TWSTO                                   4
+#define TWWC                                    3
+#define TWEN                                    2
+#define TWIE                                    0
+#define TWPS1                                   1
+#define TWPS0                                   0
+
+/* EEPROM */
+#define EERIE                                   3
+#define EEMWE                                   2
+#define EEWE                                    1
+#define EERE                                    0
+
+/* Sleep, reset source and watchdog */
+#define SE                                      7
+#define SM2                                     6
+#define SM1                                     5
+#define SM0                                     4
+#define WDRF                                    3
+#define BORF                                    2
+#define EXTRF                                   1
+#define PORF                                    0
+#define WDTOE                                   4
+#define WDE                                     3
+
+/* Port B pin numbers */
+#define PB7                                     7
+#define PB6                                     6
+#define PB5                                     5
+#define PB4                                     4
+#define PB3                                     3
+#define PB2                                     2
+#define PB1                                     1
+#define PB0                                     0
+
+/* Internal EEPROM */
+#define E2END                                   0x3FF
+
+#endif /* AVR_IO_H_ */
@@ -0,0 +1,42 @@
+/*------------------------------------------------------------------------------
+ *  Module      : AVR Register Model (host builds)
+ *  File        : sleep.h
+ *  Description : Host stand-in for <avr/sleep.h>: the mode and the enable
+ *                bit are kept in MCUCR, sleep_cpu() is handed to the sleep
+ *                hook of avr_model.c, which lets a simulation run the time
+ *                to the next interrupt
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+#ifndef AVR_SLEEP_H_
+#define AVR_SLEEP_H_
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include <avr/io.h>
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/* SM2..0 bits of MCUCR */
+#define SLEEP_MODE_IDLE                         0
+#define SLEEP_MODE_ADC                          (1 << SM0)
+#define SLEEP_MODE_PWR_DOWN                     (1 << SM1)
+#define SLEEP_MODE_PWR_SAVE                     ((1 << SM1) | (1 << SM0))
+#define SLEEP_MODE_STANDBY                      ((1 << SM2) | (1 << SM1))
+
+/*------------------------------------------------------------------------------
+ *  Function Declarations
+ *----------------------------------------------------------------------------*/
+
+void AVR_MODEL_sleepCpu(void);
+
+#define set_sleep_mode(mode)                    (MCUCR = (uint8_t)((MCUCR & ~((1 << SM2) | (1 << SM1) | (1 << SM0))) | (mode)))
+#define sleep_enable()                          (MCUCR |= (uint8_t)(1 << SE))
+#define sleep_disable()                         (MCUCR &= (uint8_t)~(1 << SE))
+#define sleep_cpu()                             AVR_MODEL_sleepCpu()
+
+#endif /* AVR_SLEEP_H_ */
@@ -0,0 +1,43 @@
+/*------------------------------------------------------------------------------
+ *  Module      : AVR Register Model (host builds)
+ *  File        : wdt.h
+ *  Description : Host stand-in for <avr/wdt.h>: the timeout is kept in
+ *                WDTCR, every enable and reset is handed to the watchdog
+ *                hook of avr_model.c
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+#ifndef AVR_WDT_H_
+#define AVR_WDT_H_
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include <avr/io.h>
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/* Timeouts, the WDP2..0 prescaler bits (nominal at 5 V) */
+#define WDTO_15MS                               0
+#define WDTO_30MS                               1
+#define WDTO_60MS                               2
+#define WDTO_120MS                              3
+#define WDTO_250MS                              4
+#define WDTO_500MS                              5
+#define WDTO_1S                                 6
+#define WDTO_2S                                 7
+
+/*------------------------------------------------------------------------------
+ *  Function Declarations
+ *----------------------------------------------------------------------------*/
+
+void AVR_MODEL_resetWatchdog(void);
+
+#define wdt_enable(timeout)                     (WDTCR = (uint8_t)((1 << WDE) | (timeout)), AVR_MODEL_resetWatchdog())
+#define wdt_reset()                             AVR_MODEL_resetWatchdog()
+#define wdt_disable()                           (WDTCR = 0)
+
+#endif /* AVR_WDT_H_ */
@@ -0,0 +1,249 @@
+/*------------------------------------------------------------------------------
+ *  Module      : AVR Register Model (host builds)
+ *  File        : avr_model.c
+ *  Description : Storage of the ATmega32 I/O registers declared by the host
+ *                avr/io.h, the input pin reads, the busy waits, the sleeps
+ *                and the watchdog resets, the on-chip EEPROM (EECR, EEDR,
+ *                EEAR and the EE_RDY interrupt) and the avr-libc functions
+ *                the host C library lacks
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "avr_model.h"
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+#include <util/delay.h>
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+volatile uint8_t SREG, DDRA, DDRB, DDRC, DDRD, PORTA, PORTB, PORTC, PORTD;
+volatile uint8_t TCCR0, TCNT0, OCR0, TIMSK, TIFR, TCCR1A, TCCR1B, OCR1AH, OCR1AL;
+volatile uint8_t TCCR2, TCNT2, OCR2, ASSR;
+volatile uint8_t UCSRA, UCSRB, UCSRC, UBRRL, UBRRH, UDR;
+volatile uint8_t TWBR, TWSR, TWAR, TWCR, TWDR;
+volatile uint8_t MCUCR, MCUCSR, GICR, WDTCR, SFIOR;
+volatile uint16_t TCNT1, OCR1A, OCR1B, ICR1, EEAR;
+
+static uint8_t (*g_pin_readers[AVR_MODEL_PORTS])(void);
+static void (*g_delay_hook)(double) = NULL;
+static void (*g_sleep_hook)(void) = NULL;
+static void (*g_watchdog_hook)(void) = NULL;
+
+/* On-chip EEPROM: the cells, the two registers behind EECR and EEDR and the byte being programmed */
+static uint8_t g_eeprom[E2END + 1] = {[0 ... E2END] = 0xFF};
+static uint8_t g_eecr = 0;
+static uint8_t g_eedr = 0;
+static uint64_t g_time_us = 0;
+static uint64_t g_write_end_us = 0;
+static uint16_t g_write_address = 0;
+static uint8_t g_write_value = 0;
+static uint8_t g_writing = 0;
+static uint32_t g_eeprom_writes = 0;
+
+/* Byte writes left before the power cut, 0xFF when none is planned */
+static uint8_t g_power_cut_bytes = 0xFF;
+static uint8_t g_powered = 1;
+
+/* Defined by the program when it links the internal EEPROM driver */
+void EE_RDY_vect(void) __attribute__((weak));
+
+/*------------------------------------------------------------------------------
+ *  Private Functions
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] AVR_MODEL_updateEeprom
+ * [Description]   Acts on what the code wrote to EECR since the last access:
+ *                 EERE reads the cell at EEAR, EEWE after EEMWE starts a byte
+ *                 write that ends AVR_MODEL_EEPROM_WRITE_US later. EE_RDY is
+ *                 delivered while EERIE is set, no write runs and the global
+ *                 interrupts are enabled, as on the part it fires again
+ *                 until the code clears EERIE.
+ *----------------------------------------------------------------------------*/
+static void AVR_MODEL_updateEeprom(void)
+{
+    if (g_eecr & (1 << EERE))
+    {
+        g_eedr = g_eeprom[EEAR & E2END];
+        g_eecr &= (uint8_t)~(1 << EERE);
+    }
+
+    if ((g_eecr & (1 << EEWE)) && !g_writing)
+    {
+        if (g_eecr & (1 << EEMWE))
+        {
+            g_writing = 1;
+            g_write_address = EEAR & E2END;
+            g_write_value = g_eedr;
+            g_write_end_us = g_time_us + AVR_MODEL_EEPROM_WRITE_US;
+            g_eeprom_writes++;
+        }
+        else
+        {
+            g_eecr &= (uint8_t)~(1 << EEWE); /* EEWE without EEMWE does nothing */
+        }
+        g_eecr &= (uint8_t)~(1 << EEMWE);
+    }
+
+    if (g_writing && (g_time_us >= g_write_end_us))
+    {
+        if (g_powered && (g_power_cut_bytes == 0))
+        {
+            g_eeprom[g_write_address] = (uint8_t)rand(); /* Interrupted cell */
+            g_powered = 0;
+        }
+        else if (g_powered)
+        {
+            g_eeprom[g_write_address] = g_write_value;
+            if (g_power_cut_bytes != 0xFF)
+            {
+                g_power_cut_bytes--;
+            }
+        }
+        g_writing = 0;
+        g_eecr &= (uint8_t)~(1 << EEWE);
+    }
+
+    /* The interrupt runs with I cleared, its own EECR accesses do not nest */
+    if (!g_writing && (g_eecr & (1 << EERIE)) && (SREG & (1 << AVR_MODEL_SREG_I)) && (EE_RDY_vect != NULL))
+    {
+        SREG &= (uint8_t)~(1 << AVR_MODEL_SREG_I);
+        EE_RDY_vect();
+        SREG |= (uint8_t)(1 << AVR_MODEL_SREG_I);
+    }
+}
+
+/*------------------------------------------------------------------------------
+ *  Functions Definitions
+ *----------------------------------------------------------------------------*/
+
+void AVR_MODEL_setPinReader(uint8_t port, uint8_t (*a_reader)(void))
+{
+    if (port < AVR_MODEL_PORTS)
+    {
+        g_pin_readers[port] = a_reader;
+    }
+}
+
+uint8_t AVR_MODEL_readPins(uint8_t port)
+{
+    static volatile uint8_t *const ports[AVR_MODEL_PORTS] = {&PORTA, &PORTB, &PORTC, &PORTD};
+
+    if (port >= AVR_MODEL_PORTS)
+    {
+        return 0xFF;
+    }
+    if (g_pin_readers[port] != NULL)
+    {
+        return g_pin_readers[port]();
+    }
+
+    return *ports[port];
+}
+
+void AVR_MODEL_setDelayHook(void (*a_hook)(double microseconds))
+{
+    g_delay_hook = a_hook;
+}
+
+void AVR_MODEL_delayUs(double microseconds)
+{
+    if (g_delay_hook != NULL)
+    {
+        g_delay_hook(microseconds);
+    }
+}
+
+void AVR_MODEL_setSleepHook(void (*a_hook)(void))
+{
+    g_sleep_hook = a_hook;
+}
+
+void AVR_MODEL_sleepCpu(void)
+{
+    if ((MCUCR & (1 << SE)) && (g_sleep_hook != NULL))
+    {
+        g_sleep_hook();
+    }
+}
+
+void AVR_MODEL_setWatchdogHook(void (*a_hook)(void))
+{
+    g_watchdog_hook = a_hook;
+}
+
+void AVR_MODEL_resetWatchdog(void)
+{
+    if (g_watchdog_hook != NULL)
+    {
+        g_watchdog_hook();
+    }
+}
+
+volatile uint8_t *AVR_MODEL_eepromControl(void)
+{
+    g_time_us += AVR_MODEL_EEPROM_ACCESS_US;
+    AVR_MODEL_updateEeprom();
+    return &g_eecr;
+}
+
+volatile uint8_t *AVR_MODEL_eepromData(void)
+{
+    AVR_MODEL_updateEeprom();
+    return &g_eedr;
+}
+
+uint64_t AVR_MODEL_getTimeUs(void)
+{
+    return g_time_us;
+}
+
+void AVR_MODEL_advanceTime(uint32_t microseconds)
+{
+    g_time_us += microseconds;
+    AVR_MODEL_updateEeprom();
+}
+
+void AVR_MODEL_eraseEeprom(void)
+{
+    uint16_t address;
+
+    for (address = 0; address <= E2END; address++)
+    {
+        g_eeprom[address] = 0xFF;
+    }
+}
+
+uint32_t AVR_MODEL_getEepromWrites(void)
+{
+    return g_eeprom_writes;
+}
+
+void AVR_MODEL_cutEepromPower(uint8_t programmed_bytes)
+{
+    g_power_cut_bytes = programmed_bytes;
+}
+
+void AVR_MODEL_restoreEepromPower(void)
+{
+    g_power_cut_bytes = 0xFF;
+    g_powered = 1;
+}
+
+/* avr-libc's itoa(), used by the LCD drivers */
+char *itoa(int value, char *string, int radix)
+{
+    sprintf(string, (radix == 16) ? "%x" : "%d", value);
+    return string;
+}
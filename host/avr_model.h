@@ -0,0 +1,106 @@
+/*------------------------------------------------------------------------------
+ *  Module      : AVR Register Model (host builds)
+ *  File        : avr_model.h
+ *  Description : Header file for the host side of the AVR register stand-ins
+ *                (avr/io.h, avr/interrupt.h, avr/sleep.h, avr/wdt.h,
+ *                util/delay.h): what drives the input pins, where the busy
+ *                waits, the sleeps and the watchdog resets go, and the
+ *                on-chip EEPROM
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+#ifndef AVR_MODEL_H_
+#define AVR_MODEL_H_
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include <avr/io.h>
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+#define AVR_MODEL_PORT_A                        0
+#define AVR_MODEL_PORT_B                        1
+#define AVR_MODEL_PORT_C                        2
+#define AVR_MODEL_PORT_D                        3
+#define AVR_MODEL_PORTS                         4
+
+/* On-chip EEPROM byte write time (8448 cycles of the 1 MHz calibrated RC) */
+#define AVR_MODEL_EEPROM_WRITE_US               8500
+
+/* Simulated time taken by one access to EECR, about one pass of a poll loop */
+#define AVR_MODEL_EEPROM_ACCESS_US              1
+
+/*------------------------------------------------------------------------------
+ *  Function Declarations
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] AVR_MODEL_setPinReader
+ * [Description]   Registers the function returning the levels of a port's
+ *                 pins each time the ECU code reads PINx. It can look at the
+ *                 DDRx and PORTx registers, e.g. to model a key matrix.
+ *                 Without a reader the pins read as PORTx (pull-ups high,
+ *                 nothing connected).
+ *----------------------------------------------------------------------------*/
+void AVR_MODEL_setPinReader(uint8_t port, uint8_t (*a_reader)(void));
+
+/*------------------------------------------------------------------------------
+ * [Function Name] AVR_MODEL_setDelayHook
+ * [Description]   Registers the function called with the length of every
+ *                 _delay_us() / _delay_ms(), e.g. to advance a simulated
+ *                 clock. Without a hook the delays return at once.
+ *----------------------------------------------------------------------------*/
+void AVR_MODEL_setDelayHook(void (*a_hook)(double microseconds));
+
+/*------------------------------------------------------------------------------
+ * [Function Name] AVR_MODEL_setSleepHook
+ * [Description]   Registers the function called by sleep_cpu() while the
+ *                 sleep enable bit is set, e.g. to run a simulated clock to
+ *                 the next interrupt. It must deliver at least one interrupt
+ *                 before it returns. Without a hook sleep_cpu() returns at
+ *                 once.
+ *----------------------------------------------------------------------------*/
+void AVR_MODEL_setSleepHook(void (*a_hook)(void));
+
+/*------------------------------------------------------------------------------
+ * [Function Name] AVR_MODEL_setWatchdogHook
+ * [Description]   Registers the function called by wdt_enable() and
+ *                 wdt_reset(), the timeout is in the low bits of WDTCR.
+ *----------------------------------------------------------------------------*/
+void AVR_MODEL_setWatchdogHook(void (*a_hook)(void));
+
+/*------------------------------------------------------------------------------
+ * [Function Name] AVR_MODEL_getTimeUs / AVR_MODEL_advanceTime
+ * [Description]   Simulated time of the on-chip EEPROM model. Every EECR
+ *                 access advances it by AVR_MODEL_EEPROM_ACCESS_US, callers
+ *                 advance it to model time spent doing something else.
+ *----------------------------------------------------------------------------*/
+uint64_t AVR_MODEL_getTimeUs(void);
+void AVR_MODEL_advanceTime(uint32_t microseconds);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] AVR_MODEL_eraseEeprom
+ * [Description]   Sets every on-chip EEPROM cell to 0xFF.
+ *----------------------------------------------------------------------------*/
+void AVR_MODEL_eraseEeprom(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] AVR_MODEL_getEepromWrites
+ * [Description]   Byte write cycles started since the program began.
+ *----------------------------------------------------------------------------*/
+uint32_t AVR_MODEL_getEepromWrites(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] AVR_MODEL_cutEepromPower / AVR_MODEL_restoreEepromPower
+ * [Description]   Fault injection: the next 'programmed_bytes' byte writes
+ *                 complete, the one after is left with random content and
+ *                 the later ones are lost until the power is restored.
+ *----------------------------------------------------------------------------*/
+void AVR_MODEL_cutEepromPower(uint8_t programmed_bytes);
+void AVR_MODEL_restoreEepromPower(void);
+
+#endif /* AVR_MODEL_H_ */
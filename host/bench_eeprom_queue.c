@@ -0,0 +1,150 @@
+/*------------------------------------------------------------------------------
+ *  Module      : EEPROM Write-Behind Queue Benchmark
+ *  File        : bench_eeprom_queue.c
+ *  Description : Runs a bursty audit workload on the 24C16 model once with
+ *                the write-behind queue serviced in idle time and once with
+ *                every flush written through at once, and prints the time
+ *                the callers wait, the bus time and the page write cycles
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "twi.h"
+#include "external_eeprom.h"
+#include "eeprom_queue.h"
+#include "audit_log.h"
+#include "control_constants.h"
+#include "eeprom_model.h"
+
+#include <stdio.h>
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+#define BENCH_BURSTS                            20
+#define BENCH_BURST_EVENTS                      8
+
+/* Main loop pass between two events of a burst, shorter than tWR */
+#define BENCH_EVENT_GAP_US                      2000UL
+
+/* Idle passes between bursts, one second in all */
+#define BENCH_IDLE_PASSES                       200
+#define BENCH_IDLE_PASS_US                      5000UL
+
+/*------------------------------------------------------------------------------
+ *  Data Types Declarations
+ *----------------------------------------------------------------------------*/
+
+typedef struct
+{
+    uint32 flushes;
+    uint64 wait_us;             /* Time spent inside the callers' flushes */
+    uint64 max_wait_us;
+    uint64 idle_us;             /* Time spent committing pages in idle passes */
+} BENCH_CostType;
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+static TWI_ConfigType g_twi_configuration = {TWI_ADDRESS, TWI_BITRATE};
+
+/*------------------------------------------------------------------------------
+ *  Private Functions
+ *----------------------------------------------------------------------------*/
+
+/* What the caller of the idle task waits for: the flush, and the commit when written through */
+static void measureFlush(boolean write_through, BENCH_CostType *cost)
+{
+    uint64 start = EEPROM_MODEL_getTimeUs();
+    uint64 wait_us;
+
+    AUDIT_flush();
+    if (write_through)
+    {
+        EEPROM_QUEUE_flush();
+    }
+
+    wait_us = EEPROM_MODEL_getTimeUs() - start;
+    cost->flushes++;
+    cost->wait_us += wait_us;
+    if (wait_us > cost->max_wait_us)
+    {
+        cost->max_wait_us = wait_us;
+    }
+}
+
+/* One pass of the idle task, the queue commits a page if the memory is idle */
+static void idlePass(boolean write_through, BENCH_CostType *cost)
+{
+    uint64 start;
+
+    measureFlush(write_through, cost);
+
+    start = EEPROM_MODEL_getTimeUs();
+    EEPROM_QUEUE_service();
+    cost->idle_us += EEPROM_MODEL_getTimeUs() - start;
+}
+
+static void benchWorkload(boolean write_through)
+{
+    EEPROM_MODEL_StatsType stats;
+    BENCH_CostType cost = {0};
+    uint8 burst_idx;
+    uint8 event_idx;
+    uint16 pass_idx;
+
+    EEPROM_MODEL_erase();
+    EEPROM_MODEL_advanceTime(EEPROM_MODEL_WRITE_CYCLE_US);
+    AUDIT_init();
+    EEPROM_MODEL_resetStats();
+
+    for (burst_idx = 0; burst_idx < BENCH_BURSTS; burst_idx++)
+    {
+        for (event_idx = 0; event_idx < BENCH_BURST_EVENTS; event_idx++)
+        {
+            AUDIT_log(AUDIT_EVENT_ACCESS_DENIED, event_idx);
+            idlePass(write_through, &cost);
+            EEPROM_MODEL_advanceTime(BENCH_EVENT_GAP_US);
+        }
+
+        for (pass_idx = 0; pass_idx < BENCH_IDLE_PASSES; pass_idx++)
+        {
+            idlePass(write_through, &cost);
+            EEPROM_MODEL_advanceTime(BENCH_IDLE_PASS_US);
+        }
+    }
+
+    EEPROM_QUEUE_flush();
+    EEPROM_MODEL_getStats(&stats);
+
+    printf("%s,%u,%lu,%.0f,%llu,%llu,%llu\n", write_through ? "direct" : "write-behind",
+           BENCH_BURSTS * BENCH_BURST_EVENTS, (unsigned long)stats.write_cycles,
+           (double)cost.wait_us / (BENCH_BURSTS * BENCH_BURST_EVENTS),
+           (unsigned long long)cost.max_wait_us, (unsigned long long)cost.idle_us,
+           (unsigned long long)stats.bus_time_us);
+
+    if (AUDIT_getDroppedCount() != 0)
+    {
+        printf("%u events dropped\n", AUDIT_getDroppedCount());
+    }
+}
+
+/*------------------------------------------------------------------------------
+ *  Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+    TWI_init(&g_twi_configuration);
+
+    printf("writes,events,page_writes,avg_wait_per_event_us,max_wait_us,idle_commit_us,bus_time_us\n");
+    benchWorkload(FALSE);
+    benchWorkload(TRUE);
+
+    return 0;
+}
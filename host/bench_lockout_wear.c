@@ -0,0 +1,124 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Lockout Counter Wear Benchmark
+ *  File        : bench_lockout_wear.c
+ *  Description : Drives 100,000 failure/reset cycles through the lockout
+ *                counter on the 24C16 model and prints the highest number of
+ *                writes a single cell took, next to what a counter kept in a
+ *                fixed byte would have taken
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "twi.h"
+#include "external_eeprom.h"
+#include "lockout_counter.h"
+#include "control_constants.h"
+#include "eeprom_model.h"
+
+#include <stdio.h>
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+#define BENCH_CYCLES                            100000UL
+
+/* Cells of the whole 24C16, a write outside the area would show too */
+#define BENCH_MEMORY_SIZE                       2048
+
+/* Write cycles a 24C16 cell is specified for */
+#define BENCH_ENDURANCE                         1000000UL
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+static TWI_ConfigType g_twi_configuration = {TWI_ADDRESS, TWI_BITRATE};
+
+static uint32 g_wear_before[BENCH_MEMORY_SIZE];
+
+/*------------------------------------------------------------------------------
+ *  Private Functions
+ *----------------------------------------------------------------------------*/
+
+/* 'failures' wrong passwords then a good one, 'cycles' times */
+static void benchCycles(uint8 failures)
+{
+    EEPROM_MODEL_StatsType stats;
+    uint32 cycle;
+    uint32 wear;
+    uint32 max_wear = 0;
+    uint16 max_address = 0;
+    uint16 address;
+    uint8 failure_idx;
+    uint32 errors = 0;
+
+    for (address = 0; address < BENCH_MEMORY_SIZE; address++)
+    {
+        g_wear_before[address] = EEPROM_MODEL_getWear(address);
+    }
+
+    EEPROM_MODEL_advanceTime(EEPROM_MODEL_WRITE_CYCLE_US);
+    EEPROM_MODEL_resetStats();
+
+    for (cycle = 0; cycle < BENCH_CYCLES; cycle++)
+    {
+        for (failure_idx = 0; failure_idx < failures; failure_idx++)
+        {
+            errors += (LOCKOUT_recordFailure() == ERROR);
+        }
+        errors += (LOCKOUT_reset() == ERROR);
+    }
+
+    EEPROM_MODEL_getStats(&stats);
+
+    /* Power cycle: the count read back must be the one of the last reset */
+    EEPROM_MODEL_advanceTime(EEPROM_MODEL_WRITE_CYCLE_US);
+    LOCKOUT_init();
+    errors += (LOCKOUT_getFailures() != 0);
+
+    for (address = 0; address < BENCH_MEMORY_SIZE; address++)
+    {
+        wear = EEPROM_MODEL_getWear(address) - g_wear_before[address];
+        if (wear > max_wear)
+        {
+            max_wear = wear;
+            max_address = address;
+        }
+    }
+
+    /* A fixed byte takes every failure and every reset */
+    printf("%u,%lu,%lu,%lu,0x%03X,%lu,%.1f\n", failures, (unsigned long)BENCH_CYCLES,
+           (unsigned long)stats.write_cycles, (unsigned long)max_wear, max_address,
+           (unsigned long)(BENCH_CYCLES * (failures + 1UL)),
+           (double)stats.bus_time_us / BENCH_CYCLES);
+
+    if (errors != 0)
+    {
+        printf("%lu failed counter writes or wrong counts\n", (unsigned long)errors);
+    }
+}
+
+/*------------------------------------------------------------------------------
+ *  Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+    TWI_init(&g_twi_configuration);
+
+    EEPROM_MODEL_erase();
+    EEPROM_MODEL_advanceTime(EEPROM_MODEL_WRITE_CYCLE_US);
+    LOCKOUT_init();
+
+    printf("failures_per_cycle,cycles,write_cycles,max_cell_writes,max_cell,fixed_byte_writes,avg_us_per_cycle\n");
+    benchCycles(1);
+    benchCycles(LOCKOUT_MAX_FAILURES);
+
+    printf("cell endurance: %lu write cycles\n", (unsigned long)BENCH_ENDURANCE);
+
+    return 0;
+}
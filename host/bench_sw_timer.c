@@ -0,0 +1,135 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Software Timer Benchmark
+ *  File        : bench_sw_timer.c
+ *  Description : Runs 1, 8 and 32 periodic software timers on the HMI tick
+ *                and measures the average cost of the tick interrupt and
+ *                the most timers expiring in one tick. The host CPU time is
+ *                measured, not AVR cycles, so only the ratios between the
+ *                rows carry over to the target
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "sw_timer.h"
+
+#include <stdio.h>
+#include <time.h>
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/* Ticks delivered per run, one per simulated millisecond */
+#define BENCH_TICKS                             200000UL
+
+/* Periods spread from 10 ms so that most ticks expire nothing */
+#define BENCH_FIRST_PERIOD_MS                   10
+#define BENCH_PERIOD_STEP_MS                    7
+
+/* Passes over the same ticks, the fastest one is kept */
+#define BENCH_PASSES                            5
+
+#if (SW_TIMER_MAX_TIMERS < 32)
+#error "bench_sw_timer needs a pool of 32 timers, build it with -DSW_TIMER_MAX_TIMERS=32"
+#endif
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+static uint32 g_expiries = 0;
+
+/*------------------------------------------------------------------------------
+ *  Private Functions
+ *----------------------------------------------------------------------------*/
+
+/* The tick interrupt as the AVR would deliver it, see timer.c */
+void TIMER2_COMP_vect(void);
+
+static void countExpiry(void *context)
+{
+    (void)context;
+    g_expiries++;
+}
+
+static uint64 nowNs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64)now.tv_sec * 1000000000ULL) + (uint64)now.tv_nsec;
+}
+
+static void startTimers(uint8 timers)
+{
+    uint8 timer_idx;
+
+    SW_TIMER_init();
+    for (timer_idx = 0; timer_idx < timers; timer_idx++)
+    {
+        SW_TIMER_start(BENCH_FIRST_PERIOD_MS + (BENCH_PERIOD_STEP_MS * timer_idx),
+                       SW_TIMER_PERIODIC, countExpiry, NULL);
+    }
+    g_expiries = 0;
+}
+
+static void benchTimers(uint8 timers)
+{
+    uint64 best_ns = 0;
+    uint64 elapsed;
+    uint32 max_expiries = 0;
+    uint32 before;
+    uint32 tick;
+    uint8 pass_idx;
+
+    /* Untimed pass: the most timers expiring in one tick */
+    startTimers(timers);
+    for (tick = 0; tick < BENCH_TICKS; tick++)
+    {
+        before = g_expiries;
+        TIMER2_COMP_vect();
+        if ((g_expiries - before) > max_expiries)
+        {
+            max_expiries = g_expiries - before;
+        }
+    }
+
+    /* Timed passes over the whole run, a clock read per tick would cost more than a tick */
+    for (pass_idx = 0; pass_idx < BENCH_PASSES; pass_idx++)
+    {
+        startTimers(timers);
+        elapsed = nowNs();
+        for (tick = 0; tick < BENCH_TICKS; tick++)
+        {
+            TIMER2_COMP_vect();
+        }
+        elapsed = nowNs() - elapsed;
+
+        if ((pass_idx == 0) || (elapsed < best_ns))
+        {
+            best_ns = elapsed;
+        }
+    }
+
+    printf("%u,%lu,%lu,%.2f,%lu,%.1f\n", timers, (unsigned long)BENCH_TICKS, (unsigned long)g_expiries,
+           (double)g_expiries / BENCH_TICKS, (unsigned long)max_expiries, (double)best_ns / BENCH_TICKS);
+}
+
+/*------------------------------------------------------------------------------
+ *  Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+    printf("timers,ticks,expiries,avg_expiries_per_tick,max_expiries_per_tick,avg_tick_ns\n");
+    benchTimers(1);
+    benchTimers(8);
+    benchTimers(32);
+
+    printf("pool: %u timers (SW_TIMER_MAX_TIMERS), host CPU time\n", SW_TIMER_MAX_TIMERS);
+
+    return 0;
+}
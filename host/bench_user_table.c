@@ -0,0 +1,206 @@
+/*------------------------------------------------------------------------------
+ *  Module      : User Table Benchmark
+ *  File        : bench_user_table.c
+ *  Description : Enrolls 10, 100 and 500 users with random credentials in the
+ *                user table on the 24C16 model and measures the verification
+ *                cost (bucket reads and bus time) of enrolled and unknown
+ *                credentials
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "twi.h"
+#include "external_eeprom.h"
+#include "user_table.h"
+#include "control_constants.h"
+#include "eeprom_model.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+#define BENCH_MAX_USERS                         500
+
+/* Fixed seed, every run enrolls the same credentials */
+#define BENCH_SEED                              27
+
+/*------------------------------------------------------------------------------
+ *  Data Types Declarations
+ *----------------------------------------------------------------------------*/
+
+typedef struct
+{
+    uint32 count;
+    uint32 reads;
+    uint32 max_reads;
+    uint64 bus_time_us;
+    uint64 max_bus_time_us;
+} BENCH_CostType;
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+static TWI_ConfigType g_twi_configuration = {TWI_ADDRESS, TWI_BITRATE};
+
+static uint8 g_credentials[BENCH_MAX_USERS][CREDENTIAL_PASSWORD_SIZE];
+
+/* Bus time of a removal and of an enrollment, both scan the whole table */
+static uint64 g_remove_us = 0;
+static uint64 g_enroll_us = 0;
+
+/*------------------------------------------------------------------------------
+ *  Private Functions
+ *----------------------------------------------------------------------------*/
+
+/* Random keypad digits, different from every credential drawn before */
+static void drawCredential(uint16 drawn, uint8 *credential)
+{
+    uint8 digit_idx;
+    uint16 other;
+    boolean unique;
+
+    do
+    {
+        for (digit_idx = 0; digit_idx < CREDENTIAL_PASSWORD_SIZE; digit_idx++)
+        {
+            credential[digit_idx] = (uint8)(rand() % 10);
+        }
+
+        unique = TRUE;
+        for (other = 0; (other < drawn) && unique; other++)
+        {
+            unique = (boolean)(memcmp(g_credentials[other], credential, CREDENTIAL_PASSWORD_SIZE) != 0);
+        }
+    } while (!unique);
+}
+
+/* One verification, its bucket reads are the EEPROM transactions it starts */
+static uint8 measureVerify(const uint8 *credential, BENCH_CostType *cost)
+{
+    EEPROM_MODEL_StatsType stats;
+    uint8 result;
+
+    EEPROM_MODEL_advanceTime(EEPROM_MODEL_WRITE_CYCLE_US);
+    EEPROM_MODEL_resetStats();
+    result = USER_TABLE_verify(credential, NULL, NULL);
+    EEPROM_MODEL_getStats(&stats);
+
+    cost->count++;
+    cost->reads += stats.transactions;
+    cost->bus_time_us += stats.bus_time_us;
+    if (stats.transactions > cost->max_reads)
+    {
+        cost->max_reads = stats.transactions;
+    }
+    if (stats.bus_time_us > cost->max_bus_time_us)
+    {
+        cost->max_bus_time_us = stats.bus_time_us;
+    }
+
+    return result;
+}
+
+static void printCost(uint16 users, uint16 enrolled, const char *lookup, const BENCH_CostType *cost)
+{
+    printf("%u,%u,%s,%.2f,%lu,%.0f,%llu\n", users, enrolled, lookup,
+           cost->count ? (double)cost->reads / cost->count : 0.0, (unsigned long)cost->max_reads,
+           cost->count ? (double)cost->bus_time_us / cost->count : 0.0,
+           (unsigned long long)cost->max_bus_time_us);
+}
+
+static void benchUsers(uint16 users)
+{
+    uint8 unknown[CREDENTIAL_PASSWORD_SIZE];
+    BENCH_CostType enrolled_cost = {0};
+    BENCH_CostType unknown_cost = {0};
+    boolean enrolled[BENCH_MAX_USERS];
+    uint16 enrolled_count = 0;
+    uint16 user_idx;
+    uint16 failures = 0;
+    EEPROM_MODEL_StatsType stats;
+
+    EEPROM_MODEL_erase();
+    srand(BENCH_SEED);
+
+    for (user_idx = 0; user_idx < users; user_idx++)
+    {
+        drawCredential(user_idx, g_credentials[user_idx]);
+        enrolled[user_idx] = (boolean)(USER_TABLE_enroll(user_idx + 1, g_credentials[user_idx],
+                                                         USER_FLAG_ENABLED) == SUCCESS);
+        enrolled_count += enrolled[user_idx];
+    }
+
+    for (user_idx = 0; user_idx < users; user_idx++)
+    {
+        if (enrolled[user_idx])
+        {
+            failures += (measureVerify(g_credentials[user_idx], &enrolled_cost) == ERROR);
+        }
+    }
+
+    /* As many credentials nobody holds */
+    for (user_idx = 0; user_idx < users; user_idx++)
+    {
+        drawCredential(users, unknown);
+        failures += (measureVerify(unknown, &unknown_cost) == SUCCESS);
+    }
+
+    printCost(users, enrolled_count, "enrolled", &enrolled_cost);
+    printCost(users, enrolled_count, "unknown", &unknown_cost);
+
+    /* An id already enrolled is refused, a single removal then leaves nothing behind */
+    drawCredential(users, unknown);
+    EEPROM_MODEL_advanceTime(EEPROM_MODEL_WRITE_CYCLE_US);
+    EEPROM_MODEL_resetStats();
+    failures += (USER_TABLE_enroll(1, unknown, USER_FLAG_ENABLED) == SUCCESS);
+    EEPROM_MODEL_getStats(&stats);
+    g_enroll_us = stats.bus_time_us;
+    if (enrolled[0])
+    {
+        EEPROM_MODEL_advanceTime(EEPROM_MODEL_WRITE_CYCLE_US);
+        failures += (USER_TABLE_remove(1) == ERROR);
+        EEPROM_MODEL_advanceTime(EEPROM_MODEL_WRITE_CYCLE_US);
+        failures += (USER_TABLE_verify(g_credentials[0], NULL, NULL) == SUCCESS);
+        failures += (USER_TABLE_verify(unknown, NULL, NULL) == SUCCESS);
+    }
+
+    /* Removal scans the table by id, the worst case is the last page */
+    EEPROM_MODEL_advanceTime(EEPROM_MODEL_WRITE_CYCLE_US);
+    EEPROM_MODEL_resetStats();
+    failures += (USER_TABLE_remove(BENCH_MAX_USERS + 1) == SUCCESS);
+    EEPROM_MODEL_getStats(&stats);
+    g_remove_us = stats.bus_time_us;
+
+    if (failures != 0)
+    {
+        printf("%u wrong verification or enrollment results\n", failures);
+    }
+}
+
+/*------------------------------------------------------------------------------
+ *  Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+    TWI_init(&g_twi_configuration);
+
+    printf("users,enrolled,lookup,avg_bucket_reads,max_bucket_reads,avg_us,max_us\n");
+    benchUsers(10);
+    benchUsers(100);
+    benchUsers(500);
+
+    printf("capacity: %u buckets, a lookup reads at most %u\n", USER_TABLE_BUCKETS, USER_TABLE_MAX_PROBES);
+    printf("remove (full table scan): %llu us\n", (unsigned long long)g_remove_us);
+    printf("enroll of an id already used (full table scan): %llu us\n", (unsigned long long)g_enroll_us);
+
+    return 0;
+}
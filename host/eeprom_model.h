@@ -0,0 +1,134 @@
+/*------------------------------------------------------------------------------
+ *  Module      : 24Cxx EEPROM Model (host builds)
+ *  File        : eeprom_model.h
+ *  Description : Header file for the file-backed 24C16 model that implements
+ *                the TWI driver interface (twi.h) on a Linux host, so the
+ *                Control ECU EEPROM code can run and be measured without the
+ *                Proteus setup
+ *  Author      : Hassan Darwish
+ *
+ *  The model replaces twi.c in the host programs built by host/Makefile
+ *  (make -C host test). It keeps the memory and the per-byte wear
+ *  counters in the file named by the EEPROM_MODEL_FILE environment variable
+ *  (default "eeprom_24c16.bin"), so contents and wear persist between runs.
+ *----------------------------------------------------------------------------*/
+
+#ifndef EEPROM_MODEL_H_
+#define EEPROM_MODEL_H_
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "stdtypes.h"
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/* 24C16 geometry */
+#define EEPROM_MODEL_SIZE                       2048
+#define EEPROM_MODEL_PAGE_SIZE                  16
+
+/* Internal write cycle time (tWR) of the modelled part in microseconds */
+#define EEPROM_MODEL_WRITE_CYCLE_US             5000
+
+/* CPU clock used to turn TWBR into an SCL frequency, as on the target */
+#ifndef F_CPU
+#define F_CPU                                   8000000UL
+#endif
+
+/*------------------------------------------------------------------------------
+ *  Data Types Declarations
+ *----------------------------------------------------------------------------*/
+
+typedef struct
+{
+    uint32 transactions;        /* START conditions that were not repeated starts */
+    uint32 repeated_starts;     /* Repeated START conditions */
+    uint32 bytes;               /* Address and data bytes clocked on the bus */
+    uint32 nacks;               /* Bytes not acknowledged by the memory */
+    uint32 busy_nacks;          /* Device address NACKs caused by a write cycle */
+    uint32 write_cycles;        /* Internal (page) write cycles started */
+    uint32 bytes_programmed;    /* Cells written by those write cycles */
+    uint64 bus_time_us;         /* Time the bus was driven */
+} EEPROM_MODEL_StatsType;
+
+/*------------------------------------------------------------------------------
+ *  Function Declarations
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] EEPROM_MODEL_getStats
+ * [Description]   Copies the counters accumulated since the last reset.
+ *----------------------------------------------------------------------------*/
+void EEPROM_MODEL_getStats(EEPROM_MODEL_StatsType *stats);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] EEPROM_MODEL_resetStats
+ * [Description]   Clears the counters (not the wear counters).
+ *----------------------------------------------------------------------------*/
+void EEPROM_MODEL_resetStats(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] EEPROM_MODEL_getWear
+ * [Description]   Number of times a cell has been programmed since the file
+ *                 was created.
+ *----------------------------------------------------------------------------*/
+uint32 EEPROM_MODEL_getWear(uint16 address);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] EEPROM_MODEL_getTimeUs / EEPROM_MODEL_advanceTime
+ * [Description]   Simulated time. It advances with the bus traffic, callers
+ *                 advance it to model time spent doing something else.
+ *----------------------------------------------------------------------------*/
+uint64 EEPROM_MODEL_getTimeUs(void);
+void EEPROM_MODEL_advanceTime(uint32 microseconds);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] EEPROM_MODEL_setClockHook
+ * [Description]   Registers a function called each time bus activity has
+ *                 advanced the simulated time, e.g. to deliver the interrupts
+ *                 falling due in the middle of a transfer.
+ *----------------------------------------------------------------------------*/
+void EEPROM_MODEL_setClockHook(void (*a_hook)(void));
+
+/*------------------------------------------------------------------------------
+ * [Function Name] EEPROM_MODEL_cutPowerDuringNextWrite
+ * [Description]   Fault injection: the next write cycle only programs the
+ *                 first 'programmed_bytes' latched bytes, the other latched
+ *                 cells are left with random content.
+ *----------------------------------------------------------------------------*/
+void EEPROM_MODEL_cutPowerDuringNextWrite(uint8 programmed_bytes);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] EEPROM_MODEL_setAbsent
+ * [Description]   Fault injection: while absent the memory acknowledges no
+ *                 device address, as with a broken SDA or SCL line, so every
+ *                 transfer fails once the driver gives up polling.
+ *----------------------------------------------------------------------------*/
+void EEPROM_MODEL_setAbsent(boolean absent);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] EEPROM_MODEL_holdBus
+ * [Description]   Fault injection: the next START never completes, as when a
+ *                 glitch leaves the TWI stuck and TWINT never sets, until
+ *                 TWI_init() runs again (after a reset). Meanwhile the
+ *                 simulated time goes on one SCL period at a time through
+ *                 the clock hook, which has to end the hang.
+ *----------------------------------------------------------------------------*/
+void EEPROM_MODEL_holdBus(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] EEPROM_MODEL_erase
+ * [Description]   Sets every cell to 0xFF (wear counters are kept).
+ *----------------------------------------------------------------------------*/
+void EEPROM_MODEL_erase(void);
+
+/*------------------------------------------------------------------------------
+ * [Function Name] EEPROM_MODEL_peek
+ * [Description]   Direct access to the memory array, for checking results.
+ *----------------------------------------------------------------------------*/
+uint8 EEPROM_MODEL_peek(uint16 address);
+
+#endif /* EEPROM_MODEL_H_ */
@@ -0,0 +1,60 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Host Test Support
+ *  File        : host_test.h
+ *  Description : Check macros shared by the host test programs, a failed
+ *                check is reported with its location and the program exits
+ *                with a non-zero status at the end
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+#ifndef HOST_TEST_H_
+#define HOST_TEST_H_
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include <stdio.h>
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+static unsigned int g_host_checks = 0;
+static unsigned int g_host_failures = 0;
+
+/*------------------------------------------------------------------------------
+ *  Check Macros
+ *----------------------------------------------------------------------------*/
+
+#define HOST_CHECK(condition)                                                   \
+    do                                                                          \
+    {                                                                           \
+        g_host_checks++;                                                        \
+        if (!(condition))                                                       \
+        {                                                                       \
+            g_host_failures++;                                                  \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        }                                                                       \
+    } while (0)
+
+#define HOST_CHECK_EQUAL(actual, expected)                                      \
+    do                                                                          \
+    {                                                                           \
+        unsigned long long actual_value = (unsigned long long)(actual);         \
+        unsigned long long expected_value = (unsigned long long)(expected);     \
+        g_host_checks++;                                                        \
+        if (actual_value != expected_value)                                     \
+        {                                                                       \
+            g_host_failures++;                                                  \
+            printf("%s:%d: check failed: %s is %llu, expected %llu\n",          \
+                   __FILE__, __LINE__, #actual, actual_value, expected_value);  \
+        }                                                                       \
+    } while (0)
+
+/* Summary line and exit status of main() */
+#define HOST_RESULT(name)                                                       \
+    (printf("%s: %u checks, %u failed\n", (name), g_host_checks, g_host_failures), \
+     (g_host_failures == 0) ? 0 : 1)
+
+#endif /* HOST_TEST_H_ */
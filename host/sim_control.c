@@ -0,0 +1,1105 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Control ECU Co-simulation
+ *  File        : sim_control.c
+ *  Description : Runs the control ECU firmware, its main() and every module
+ *                unchanged, on a simulated clock against a scripted HMI: a
+ *                door cycle with diagnostic requests while the door moves, a
+ *                full audit export and a lockdown, with 'day' 24 hours of
+ *                traffic, or with 'hang' a TWI hang during a lockdown that
+ *                the watchdog has to recover from. Reports the door
+ *                timeline, the reply times, the longest task runs, the
+ *                longest time between two watchdog resets, the interrupts
+ *                and wake-ups by source and the time spent asleep
+ *  Author      : Hassan Darwish
+ *
+ *  The clock is the one of the 24C16 model. It advances with the bus traffic,
+ *  by SIM_UART_BYTE_US per byte sent (the sender waits each one out), with
+ *  the _delay busy waits and with the sleeps up to the next interrupt. The
+ *  CPU time of the code itself is not modelled. The TIMER2 compare (tick)
+ *  and TIMER1 overflow interrupts and the received bytes are delivered when
+ *  they fall due, in the middle of a bus transfer too.
+ *
+ *  Each run of the firmware is a child process, so it starts from reset. A
+ *  watchdog timeout ends the run: the .noinit RAM and the time are handed
+ *  to the next run, which starts with WDRF set. The EEPROM file is shared.
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "control_constants.h"
+#include "uart.h"
+#include "gpio.h"
+#include "pir_sensor.h"
+#include "audit_log.h"
+#include "door_fsm.h"
+#include "user_table.h"
+#include "crc.h"
+#include "task_monitor.h"
+#include "diag_link.h"
+#include "eeprom_model.h"
+#include "avr_model.h"
+
+#include <avr/interrupt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/* One byte on the HMI link: 10 bits at 9600 baud */
+#define SIM_UART_BYTE_US                        1042
+
+/* Length of the scenarios, from the start of main() */
+#define SIM_DOOR_RUN_MS                         110000UL
+#define SIM_DAY_RUN_MS                          86400000UL
+#define SIM_HANG_RUN_MS                         120000UL
+
+#define SIM_SCRIPT_SIZE                         1024
+#define SIM_REQUESTS                            32
+#define SIM_NO_REQUEST                          0xFF
+
+#define SIM_NEVER                               0xFFFFFFFFFFFFFFFFULL
+
+/* Exit status of a run ended by the watchdog */
+#define SIM_EXIT_WATCHDOG_RESET                 3
+
+/* .noinit RAM carried over a watchdog reset */
+#define SIM_NOINIT_SIZE                         64
+
+/* Nominal watchdog timeouts of WDTO_15MS to WDTO_2S at 5 V, microseconds */
+#define SIM_WATCHDOG_TIMEOUTS_US                {16300, 32500, 65000, 130000, 260000, 520000, 1000000, 2100000}
+
+/*
+ * CPU cycles per wake-up (interrupt entry and exit, the ISR, one scheduler
+ * pass with the idle hook, back to sleep). Not measured here, the sleep
+ * time is given for each of these assumptions.
+ */
+#define SIM_WAKE_CYCLES                         {200, 300, 600}
+#define SIM_WAKE_ASSUMPTIONS                    3
+
+/*------------------------------------------------------------------------------
+ *  Data Types Declarations
+ *----------------------------------------------------------------------------*/
+
+/* Interrupt sources */
+typedef enum
+{
+    SIM_SOURCE_TIMER2,          /* Compare match, the 1 ms software timer tick */
+    SIM_SOURCE_TIMER1,          /* Overflow, extends the profiler / TWI trace clock */
+    SIM_SOURCE_UART,            /* Byte received */
+    SIM_SOURCES
+} SIM_SourceType;
+
+typedef enum
+{
+    SIM_INPUT_BYTE,             /* A byte from the HMI, received at time_us */
+    SIM_INPUT_PIR,              /* The PIR output changes to 'value' */
+    SIM_INPUT_HOLD_BUS,         /* The next TWI START hangs until the TWI is initialized */
+    SIM_INPUT_EXPECT_DOOR       /* Not an input: the door must be in state 'value' by now */
+} SIM_InputKindType;
+
+typedef struct
+{
+    uint64 time_us;
+    SIM_InputKindType kind;
+    uint8 value;
+    uint8 request;              /* Request this byte completes, or SIM_NO_REQUEST */
+    uint16 order;               /* Position in the script at equal times */
+} SIM_InputType;
+
+typedef struct
+{
+    const char *name;
+    uint64 sent_us;             /* Last request byte received */
+    uint64 reply_us;            /* First reply byte started, 0 before */
+    uint64 end_us;              /* Last reply frame sent */
+    uint16 reply_bytes;
+} SIM_RequestType;
+
+/* Handed from a run ended by the watchdog to the next one */
+typedef struct
+{
+    uint8 resets;
+    boolean failed;             /* An expectation of an earlier run was not met */
+    uint64 reset_us;            /* Time of the last watchdog reset */
+    uint64 hang_us;             /* Time the bus was held, SIM_NEVER if it was not */
+    uint8 noinit[SIM_NOINIT_SIZE];
+} SIM_ResetType;
+
+/*------------------------------------------------------------------------------
+ *  Firmware Entry Points
+ *----------------------------------------------------------------------------*/
+
+/* control.c, built with -Dmain=control_main */
+int control_main(void);
+
+/* timer.c */
+void TIMER1_OVF_vect(void);
+void TIMER2_COMP_vect(void);
+
+/* .noinit section bounds, from noinit.ld as in the avr-libc linker scripts */
+extern uint8 __noinit_start[];
+extern uint8 __noinit_end[];
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+static SIM_InputType g_script[SIM_SCRIPT_SIZE];
+static uint16 g_script_length = 0;
+static uint16 g_script_next = 0;
+static uint64 g_script_time_us = 0;
+
+static SIM_RequestType g_requests[SIM_REQUESTS];
+static uint8 g_request_count = 0;
+static uint8 g_current_request = SIM_NO_REQUEST;
+
+/* Interrupt sources */
+static void (*g_receive)(uint8) = NULL;
+static uint8 g_pir_level = 0;
+static uint64 g_timer1_due_us = SIM_NEVER;
+static uint64 g_timer1_start_us = 0;
+static uint64 g_timer2_due_us = SIM_NEVER;
+static boolean g_in_interrupt = FALSE;
+
+static uint32 g_interrupts[SIM_SOURCES];
+static uint32 g_wakes[SIM_SOURCES];
+static boolean g_sleeping = FALSE;
+static uint64 g_asleep_us = 0;
+
+/* Print the door timeline as it happens */
+static boolean g_verbose = TRUE;
+
+/* Start of main() and end of the scenario */
+static uint64 g_boot_us = 0;
+static uint64 g_end_us = SIM_NEVER;
+
+/* Diagnostic frame being sent: bytes so far and whole length */
+static uint16 g_frame_bytes = 0;
+static uint16 g_frame_length = 0;
+
+static DOOR_StateType g_door_state = DOOR_STATE_LOCKED;
+
+static uint64 g_last_feed_us = SIM_NEVER;
+static uint64 g_longest_feed_gap_us = 0;
+
+/* A scripted expectation was not met */
+static boolean g_expectation_failed = FALSE;
+
+/* Shared with every run, watchdog resets the scenario expects */
+static SIM_ResetType *g_reset = NULL;
+static uint8 g_expected_resets = 0;
+
+/* Start of this run of the firmware, the first one or after a reset */
+static uint64 g_run_us = 0;
+
+/* Hang scenario: the lockdown entered again after the reset */
+static boolean g_hang = FALSE;
+static uint64 g_lockdown_resumed_us = SIM_NEVER;
+
+/*------------------------------------------------------------------------------
+ *  Clock and Interrupts
+ *----------------------------------------------------------------------------*/
+
+static uint64 nowUs(void)
+{
+    return EEPROM_MODEL_getTimeUs();
+}
+
+/* Scenario time in seconds, for the report */
+static double sinceBoot(uint64 time_us)
+{
+    return (double)(time_us - g_boot_us) / 1000000.0;
+}
+
+/* Prescaler of the clock select bits, 0 while the timer is stopped */
+static uint32 timerPrescaler(uint8 clock_select, boolean timer2)
+{
+    static const uint16 timer01[8] = {0, 1, 8, 64, 256, 1024, 0, 0};
+    static const uint16 timer2_prescalers[8] = {0, 1, 8, 32, 64, 128, 256, 1024};
+
+    return timer2 ? timer2_prescalers[clock_select & 0x07] : timer01[clock_select & 0x07];
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] updateTimers
+ * [Description]   Schedules the next TIMER2 compare and TIMER1 overflow
+ *                 interrupt from the registers, stops a timer whose
+ *                 interrupt or clock was turned off, and sets TCNT1 and
+ *                 TCNT2 for the code reading them.
+ *----------------------------------------------------------------------------*/
+static void updateTimers(uint64 now)
+{
+    uint32 prescaler;
+    uint64 period;
+
+    prescaler = timerPrescaler(TCCR2, TRUE);
+    if ((prescaler == 0) || !(TIMSK & (1 << OCIE2)))
+    {
+        g_timer2_due_us = SIM_NEVER;
+    }
+    else
+    {
+        period = ((uint64)(OCR2 + 1) * prescaler * 1000000ULL) / F_CPU;
+        if (g_timer2_due_us == SIM_NEVER)
+        {
+            g_timer2_due_us = now + period;
+        }
+        TCNT2 = (uint8)(((now + period - g_timer2_due_us) * F_CPU) / (prescaler * 1000000ULL));
+    }
+
+    prescaler = timerPrescaler(TCCR1B, FALSE);
+    if ((prescaler == 0) || !(TIMSK & (1 << TOIE1)))
+    {
+        g_timer1_due_us = SIM_NEVER;
+    }
+    else
+    {
+        period = (65536ULL * prescaler * 1000000ULL) / F_CPU;
+        if (g_timer1_due_us == SIM_NEVER)
+        {
+            g_timer1_start_us = now;
+            g_timer1_due_us = now + period;
+        }
+        TCNT1 = (uint16)(((now - g_timer1_start_us) * F_CPU) / (prescaler * 1000000ULL));
+    }
+}
+
+static uint64 nextInterruptUs(void)
+{
+    uint64 next = g_timer2_due_us;
+
+    if (g_timer1_due_us < next)
+    {
+        next = g_timer1_due_us;
+    }
+    if ((g_script_next < g_script_length) && (g_script[g_script_next].time_us < next))
+    {
+        next = g_script[g_script_next].time_us;
+    }
+
+    return next;
+}
+
+/* An interrupt while sleeping is a wake-up */
+static void countInterrupt(SIM_SourceType source)
+{
+    g_interrupts[source]++;
+    if (g_sleeping)
+    {
+        g_wakes[source]++;
+        g_sleeping = FALSE;
+    }
+}
+
+static void deliverInput(const SIM_InputType *input)
+{
+    if (input->kind == SIM_INPUT_PIR)
+    {
+        g_pir_level = input->value;
+        if (g_verbose)
+        {
+            printf("%9.3f s  PIR %s\n", sinceBoot(input->time_us), input->value ? "detects somebody" : "clear");
+        }
+        return;
+    }
+
+    if (input->kind == SIM_INPUT_HOLD_BUS)
+    {
+        EEPROM_MODEL_holdBus();
+        g_reset->hang_us = input->time_us;
+        printf("%9.3f s  TWI hangs at the next START\n", sinceBoot(input->time_us));
+        return;
+    }
+
+    if (input->kind == SIM_INPUT_EXPECT_DOOR)
+    {
+        if (DOOR_FSM_getState() != input->value)
+        {
+            printf("%9.3f s  door state %u, expected %u\n", sinceBoot(input->time_us), DOOR_FSM_getState(),
+                   input->value);
+            g_expectation_failed = TRUE;
+        }
+        return;
+    }
+
+    if (g_receive == NULL)
+    {
+        printf("%9.3f s  byte 0x%02X lost, receiver off\n", sinceBoot(input->time_us), input->value);
+        return;
+    }
+
+    countInterrupt(SIM_SOURCE_UART);
+    g_receive(input->value);
+
+    if (input->request != SIM_NO_REQUEST)
+    {
+        g_current_request = input->request;
+        g_requests[input->request].sent_us = input->time_us;
+    }
+}
+
+/* Nominal timeout of the watchdog as configured in WDTCR */
+static uint32 watchdogTimeoutUs(void)
+{
+    static const uint32 timeouts_us[8] = SIM_WATCHDOG_TIMEOUTS_US;
+
+    return timeouts_us[WDTCR & 0x07];
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] checkWatchdog
+ * [Description]   Ends the run once the watchdog has not been reset for its
+ *                 timeout: hands the .noinit RAM and the time to the next
+ *                 run, which the parent starts from reset.
+ *----------------------------------------------------------------------------*/
+static void checkWatchdog(uint64 now)
+{
+    if (!(WDTCR & (1 << WDE)) || (g_last_feed_us == SIM_NEVER) ||
+        ((now - g_last_feed_us) < watchdogTimeoutUs()))
+    {
+        return;
+    }
+
+    printf("%9.3f s  watchdog reset, %.1f ms after the last feed\n", sinceBoot(now),
+           (double)(now - g_last_feed_us) / 1000.0);
+    memcpy(g_reset->noinit, __noinit_start, (size_t)(__noinit_end - __noinit_start));
+    g_reset->reset_us = now;
+    g_reset->resets++;
+    g_reset->failed |= g_expectation_failed;
+    fflush(stdout);
+    _exit(SIM_EXIT_WATCHDOG_RESET);
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] deliverInterrupts
+ * [Description]   Runs the interrupts due by now, oldest first, unless
+ *                 interrupts are disabled or one is already running.
+ *----------------------------------------------------------------------------*/
+static void deliverInterrupts(void)
+{
+    uint64 now = nowUs();
+    uint64 due;
+
+    checkWatchdog(now);
+
+    if (g_in_interrupt || !(SREG & (1 << AVR_MODEL_SREG_I)))
+    {
+        return;
+    }
+
+    g_in_interrupt = TRUE;
+    for (;;)
+    {
+        updateTimers(now);
+        due = nextInterruptUs();
+        if (due > now)
+        {
+            break;
+        }
+
+        if (due == g_timer2_due_us)
+        {
+            g_timer2_due_us = SIM_NEVER;
+            updateTimers(due);
+            countInterrupt(SIM_SOURCE_TIMER2);
+            TIMER2_COMP_vect();
+        }
+        else if (due == g_timer1_due_us)
+        {
+            g_timer1_due_us = SIM_NEVER;
+            updateTimers(due);
+            g_timer1_start_us = due;
+            countInterrupt(SIM_SOURCE_TIMER1);
+            TIMER1_OVF_vect();
+        }
+        else
+        {
+            deliverInput(&g_script[g_script_next++]);
+        }
+    }
+    g_in_interrupt = FALSE;
+}
+
+/* Time passing outside the bus: interrupts are delivered on the way */
+static void runUntil(uint64 end_us)
+{
+    uint64 now;
+    uint64 next;
+
+    while ((now = nowUs()) < end_us)
+    {
+        next = nextInterruptUs();
+        if ((next <= now) || (next > end_us) || !(SREG & (1 << AVR_MODEL_SREG_I)))
+        {
+            next = end_us;
+        }
+        EEPROM_MODEL_advanceTime((uint32)(next - now));
+        deliverInterrupts();
+    }
+}
+
+/*------------------------------------------------------------------------------
+ *  Observation
+ *----------------------------------------------------------------------------*/
+
+static void observeDoor(void)
+{
+    static const char *const names[] = {"locked", "opening", "held open", "closing", "lockdown", "fault"};
+    DOOR_StateType state = DOOR_FSM_getState();
+
+    if (state != g_door_state)
+    {
+        g_door_state = state;
+        if ((state == DOOR_STATE_LOCKDOWN) && (g_reset->resets != 0) && (g_lockdown_resumed_us == SIM_NEVER))
+        {
+            g_lockdown_resumed_us = nowUs();
+        }
+        if (!g_verbose)
+        {
+            return;
+        }
+        printf("%9.3f s  door %s\n", sinceBoot(nowUs()), names[state]);
+    }
+}
+
+/* A byte sent to the HMI: a link byte or part of a diagnostic frame */
+static void observeSentByte(uint8 data)
+{
+    SIM_RequestType *request = (g_current_request != SIM_NO_REQUEST) ? &g_requests[g_current_request] : NULL;
+
+    if ((g_frame_bytes == 0) && (data != DIAG_FRAME_SOF))
+    {
+        if ((data == CLEAR) && g_verbose)
+        {
+            printf("%9.3f s  sends CLEAR\n", sinceBoot(nowUs()));
+        }
+        return;
+    }
+
+    if ((request != NULL) && (request->reply_us == 0))
+    {
+        request->reply_us = nowUs();
+    }
+
+    /* SOF, type, length, payload, CRC16 */
+    g_frame_bytes++;
+    if (g_frame_bytes == 3)
+    {
+        g_frame_length = (uint16)(3 + data + 2);
+    }
+    if ((g_frame_bytes >= 3) && (g_frame_bytes == g_frame_length))
+    {
+        g_frame_bytes = 0;
+        if (request != NULL)
+        {
+            request->end_us = nowUs() + SIM_UART_BYTE_US;
+            request->reply_bytes += g_frame_length;
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------
+ *  Report
+ *----------------------------------------------------------------------------*/
+
+/* Newest audit record of 'event' in the EEPROM, FALSE if there is none */
+static boolean findAuditRecord(AUDIT_EventType event, uint16 *detail)
+{
+    uint8 record[AUDIT_RECORD_SIZE];
+    uint16 newest = 0;
+    uint16 sequence;
+    boolean found = FALSE;
+    uint8 record_idx;
+    uint8 byte_idx;
+
+    for (record_idx = 0; record_idx < AUDIT_RING_RECORDS; record_idx++)
+    {
+        for (byte_idx = 0; byte_idx < AUDIT_RECORD_SIZE; byte_idx++)
+        {
+            record[byte_idx] = EEPROM_MODEL_peek(AUDIT_RING_BASE_ADDRESS + (record_idx * AUDIT_RECORD_SIZE) + byte_idx);
+        }
+        sequence = (uint16)(record[AUDIT_SEQUENCE_OFFSET] | (record[AUDIT_SEQUENCE_OFFSET + 1] << 8));
+
+        if ((record[AUDIT_EVENT_OFFSET] == event) &&
+            (CRC8_compute(record, AUDIT_CHECK_OFFSET) == record[AUDIT_CHECK_OFFSET]) &&
+            (!found || (sequence > newest)))
+        {
+            newest = sequence;
+            *detail = (uint16)(record[AUDIT_DETAIL_OFFSET] | (record[AUDIT_DETAIL_OFFSET + 1] << 8));
+            found = TRUE;
+        }
+    }
+
+    return found;
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] reportRecovery
+ * [Description]   Hang scenario: prints the time from the hang to the reset
+ *                 and to the lockdown being served again, checks that the
+ *                 reset was logged with the protocol task running. TRUE if
+ *                 it was and the lockdown resumed.
+ *----------------------------------------------------------------------------*/
+static boolean reportRecovery(void)
+{
+    uint16 task = MONITOR_NO_TASK;
+    boolean logged = findAuditRecord(AUDIT_EVENT_WATCHDOG_RESET, &task);
+
+    if ((g_reset->resets == 0) || (g_reset->hang_us == SIM_NEVER))
+    {
+        printf("no watchdog reset after the hang\n");
+        return FALSE;
+    }
+
+    printf("TWI hang at %.3f s: watchdog reset after %.1f ms", sinceBoot(g_reset->hang_us),
+           (double)(g_reset->reset_us - g_reset->hang_us) / 1000.0);
+    if (g_lockdown_resumed_us != SIM_NEVER)
+    {
+        printf(", lockdown served again after %.1f ms\n", (double)(g_lockdown_resumed_us - g_reset->hang_us) / 1000.0);
+    }
+    else
+    {
+        printf(", the lockdown was not served again\n");
+    }
+
+    if (!logged)
+    {
+        printf("no watchdog_reset record in the audit log\n");
+    }
+    else
+    {
+        printf("audit log: watchdog_reset, task %u running\n", task);
+    }
+
+    /* The protocol task is the first one control.c registers */
+    return (boolean)(logged && (task == 0) && (g_lockdown_resumed_us != SIM_NEVER));
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] finish
+ * [Description]   Prints the reply times, the task statistics, the watchdog
+ *                 margin, the interrupts and the sleep time, and ends the
+ *                 program: status 1 if a request went unanswered, a
+ *                 scripted expectation failed or the watchdog reset the
+ *                 controller a number of times the scenario did not expect.
+ *                 The interrupts and the sleep time count from the start
+ *                 of this run.
+ *----------------------------------------------------------------------------*/
+static void finish(void)
+{
+    /* Registration order of control.c */
+    static const char *const task_names[MONITOR_TASKS] = {[0] = "protocol", [1] = "door", [MONITOR_IDLE_TASK] = "idle"};
+    static const char *const source_names[SIM_SOURCES] = {"TIMER2 compare (tick)", "TIMER1 overflow", "UART receive"};
+    static const uint16 wake_cycles[SIM_WAKE_ASSUMPTIONS] = SIM_WAKE_CYCLES;
+    double seconds = (double)(nowUs() - g_run_us) / 1000000.0;
+    uint64 wakes = 0;
+    MONITOR_TaskStatsType stats;
+    boolean failed = g_expectation_failed;
+    uint8 index;
+
+    printf("\n");
+    for (index = 0; index < g_request_count; index++)
+    {
+        const SIM_RequestType *request = &g_requests[index];
+
+        if (request->name == NULL)
+        {
+            continue; /* Sent before a reset */
+        }
+        if (request->reply_us == 0)
+        {
+            printf("%s: no reply\n", request->name);
+            failed = TRUE;
+            continue;
+        }
+        printf("%s: reply starts %.1f ms after the request, %u bytes, ends after %.1f ms\n", request->name,
+               (double)(request->reply_us - request->sent_us) / 1000.0, request->reply_bytes,
+               (double)(request->end_us - request->sent_us) / 1000.0);
+    }
+
+    for (index = 0; index < MONITOR_TASKS; index++)
+    {
+        if (task_names[index] == NULL)
+        {
+            continue;
+        }
+        MONITOR_getStats(index, &stats);
+        printf("task %s: %u runs, longest %.1f ms, budget %.1f ms, %u over budget\n", task_names[index],
+               stats.runs, stats.wcet_us / 1000.0, stats.budget_us / 1000.0, stats.misses);
+    }
+
+    printf("longest time between watchdog resets: %.1f ms (timeout %.0f ms nominal)\n",
+           g_longest_feed_gap_us / 1000.0, watchdogTimeoutUs() / 1000.0);
+    printf("watchdog resets of the controller: %u, %u expected\n", g_reset->resets, g_expected_resets);
+    if ((g_reset->resets != g_expected_resets) || g_reset->failed)
+    {
+        failed = TRUE;
+    }
+    if (g_hang && !reportRecovery())
+    {
+        failed = TRUE;
+    }
+
+    /* Every enabled interrupt wakes the CPU from idle sleep */
+    printf("\n%.0f s simulated\n", seconds);
+    for (index = 0; index < SIM_SOURCES; index++)
+    {
+        printf("%s: %lu interrupts (%.1f/s), %lu of them woke the CPU\n", source_names[index],
+               (unsigned long)g_interrupts[index], g_interrupts[index] / seconds, (unsigned long)g_wakes[index]);
+        wakes += g_wakes[index];
+    }
+    printf("asleep %.3f%% of the time, %.1f wake-ups/s, the code itself taking no time\n",
+           100.0 * (double)g_asleep_us / (seconds * 1000000.0), wakes / seconds);
+    for (index = 0; index < SIM_WAKE_ASSUMPTIONS; index++)
+    {
+        double awake_us = ((double)wakes * wake_cycles[index] * 1000000.0) / F_CPU;
+
+        printf("derived, with %u cycles per wake-up: asleep %.1f%% of the time\n", wake_cycles[index],
+               100.0 * ((double)g_asleep_us - awake_us) / (seconds * 1000000.0));
+    }
+
+    exit(failed ? 1 : 0);
+}
+
+/*------------------------------------------------------------------------------
+ *  AVR and Peripheral Stand-ins
+ *----------------------------------------------------------------------------*/
+
+static void busClockHook(void)
+{
+    deliverInterrupts();
+    observeDoor();
+}
+
+static void delayHook(double microseconds)
+{
+    runUntil(nowUs() + (uint64)microseconds);
+}
+
+/* sleep_cpu(): until the next interrupt, which always comes (the tick) */
+static void sleepHook(void)
+{
+    uint64 start = nowUs();
+
+    observeDoor();
+    if (start >= g_end_us)
+    {
+        finish();
+    }
+
+    /* A PIR change is no interrupt, the CPU sleeps on */
+    g_sleeping = TRUE;
+    while (g_sleeping)
+    {
+        updateTimers(nowUs());
+        runUntil(nextInterruptUs());
+    }
+    g_asleep_us += nowUs() - start;
+}
+
+static void watchdogHook(void)
+{
+    uint64 now = nowUs();
+
+    if ((g_last_feed_us != SIM_NEVER) && ((now - g_last_feed_us) > g_longest_feed_gap_us))
+    {
+        g_longest_feed_gap_us = now - g_last_feed_us;
+    }
+    g_last_feed_us = now;
+}
+
+/* PIR output on PC2 */
+static uint8 readPortC(void)
+{
+    return (uint8)((PORTC & (uint8)~(1 << PIR_OUTPUT_PIN_ID)) | (uint8)(g_pir_level << PIR_OUTPUT_PIN_ID));
+}
+
+/* UART: the bytes of the script arrive through the receive callback */
+void UART_init(const UART_ConfigType *Config_Ptr)
+{
+    (void)Config_Ptr;
+}
+
+void UART_setReceiveCallBack(void (*a_ptr)(uint8))
+{
+    g_receive = a_ptr;
+}
+
+void UART_sendByte(const uint8 data)
+{
+    deliverInterrupts();
+    observeDoor();
+    observeSentByte(data);
+    runUntil(nowUs() + SIM_UART_BYTE_US);
+}
+
+/*------------------------------------------------------------------------------
+ *  HMI Script
+ *----------------------------------------------------------------------------*/
+
+/* The next bytes start being sent 'ms' after the start of main() */
+static void scriptAt(uint32 ms)
+{
+    g_script_time_us = g_boot_us + ((uint64)ms * 1000);
+}
+
+static void scriptAdd(SIM_InputKindType kind, uint8 value, uint8 request)
+{
+    if (g_script_length == SIM_SCRIPT_SIZE)
+    {
+        fprintf(stderr, "script full\n");
+        exit(2);
+    }
+
+    g_script[g_script_length].time_us = g_script_time_us;
+    g_script[g_script_length].kind = kind;
+    g_script[g_script_length].value = value;
+    g_script[g_script_length].request = request;
+    g_script[g_script_length].order = g_script_length;
+    g_script_length++;
+}
+
+static int compareInputs(const void *first, const void *second)
+{
+    const SIM_InputType *a = first;
+    const SIM_InputType *b = second;
+
+    if (a->time_us != b->time_us)
+    {
+        return (a->time_us < b->time_us) ? -1 : 1;
+    }
+    return (int)a->order - (int)b->order;
+}
+
+static void scriptByte(uint8 value)
+{
+    g_script_time_us += SIM_UART_BYTE_US;
+    scriptAdd(SIM_INPUT_BYTE, value, SIM_NO_REQUEST);
+}
+
+static void scriptPassword(uint8 first_digit)
+{
+    uint8 digit_idx;
+
+    scriptByte(RECIEVE_START_PASSWORD);
+    for (digit_idx = 0; digit_idx < KEYPAD_PASSWORD_SIZE; digit_idx++)
+    {
+        scriptByte((uint8)((first_digit + digit_idx) % 10));
+    }
+}
+
+static void scriptPir(uint32 ms, uint8 level)
+{
+    scriptAt(ms);
+    scriptAdd(SIM_INPUT_PIR, level, SIM_NO_REQUEST);
+}
+
+/* A diagnostic request, its reply is timed from its last byte */
+static void scriptRequest(uint32 ms, const char *name, uint8 command, boolean with_cursor)
+{
+    if (g_request_count == SIM_REQUESTS)
+    {
+        fprintf(stderr, "too many requests\n");
+        exit(2);
+    }
+    g_requests[g_request_count].name = name;
+
+    scriptAt(ms);
+    if (with_cursor)
+    {
+        scriptByte(command);
+        scriptByte(0);
+        g_script_time_us += SIM_UART_BYTE_US;
+        scriptAdd(SIM_INPUT_BYTE, 0, g_request_count);
+    }
+    else
+    {
+        g_script_time_us += SIM_UART_BYTE_US;
+        scriptAdd(SIM_INPUT_BYTE, command, g_request_count);
+    }
+    g_request_count++;
+}
+
+/* A door opening with the right password, somebody in the doorway for 'presence_ms' */
+static void scriptDoorCycle(uint32 ms, uint32 presence_ms)
+{
+    scriptAt(ms);
+    scriptByte(START_PHASE_TWO_DOOR);
+    scriptPassword(1);
+    scriptAt(ms + 200);
+    scriptByte(START_MOTOR);
+    scriptPir(ms + 300, 1);
+    scriptPir(ms + 300 + presence_ms, 0);
+}
+
+/* A wrong password, the HMI answers the refusal with 'decision' */
+static void scriptWrongPassword(uint32 ms, uint8 decision)
+{
+    scriptAt(ms);
+    scriptByte(START_PHASE_TWO_DOOR);
+    scriptPassword(3);
+    scriptAt(ms + 300);
+    scriptByte(decision);
+}
+
+static void scriptExpectDoor(uint32 ms, DOOR_StateType state)
+{
+    scriptAt(ms);
+    scriptAdd(SIM_INPUT_EXPECT_DOOR, (uint8)state, SIM_NO_REQUEST);
+}
+
+/* User 'user_id' with the password starting at 'first_digit', enrolled with the master password */
+static void scriptEnroll(uint32 ms, uint16 user_id, uint8 flags, uint8 first_digit)
+{
+    uint8 digit_idx;
+
+    scriptAt(ms);
+    scriptByte(USER_ENROLL_REQUEST);
+    for (digit_idx = 0; digit_idx < KEYPAD_PASSWORD_SIZE; digit_idx++)
+    {
+        scriptByte((uint8)((1 + digit_idx) % 10));
+    }
+    scriptByte((uint8)user_id);
+    scriptByte((uint8)(user_id >> 8));
+    scriptByte(flags);
+    for (digit_idx = 0; digit_idx < KEYPAD_PASSWORD_SIZE; digit_idx++)
+    {
+        scriptByte((uint8)((first_digit + digit_idx) % 10));
+    }
+}
+
+/* A refused password followed by a decision the refusal does not grant, then the HMI's real answer */
+static void scriptForgedDecision(uint32 ms, uint8 operation, uint8 first_digit, uint8 forged, uint8 decision)
+{
+    scriptAt(ms);
+    scriptByte(operation);
+    scriptPassword(first_digit);
+    scriptAt(ms + 200);
+    scriptByte(forged);
+    scriptAt(ms + 300);
+    scriptByte(decision);
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] scriptDoorScenario
+ * [Description]   The HMI side: passwords set, a door cycle with somebody in
+ *                 the doorway for 20 s, status requests while the door opens,
+ *                 is held and closes, an audit export of the full ring, then
+ *                 three refused passwords and requests during the lockdown.
+ *                 The refusals come with a START_MOTOR and, for a user
+ *                 without the admin flag, a RESET_PASSWORD that must be
+ *                 ignored: the door stays locked, then locks down.
+ *----------------------------------------------------------------------------*/
+static void scriptDoorScenario(void)
+{
+    scriptAt(500);
+    scriptPassword(1);
+    scriptPassword(1);
+
+    scriptDoorCycle(1000, 19700);
+
+    scriptRequest(3000, "0x6B (TWI stats) while opening", TWI_STATS_REQUEST, FALSE);
+    scriptRequest(9000, "0x6A (audit export, full ring) while opening", AUDIT_EXPORT_REQUEST, TRUE);
+    scriptRequest(17000, "0x6B while held open", TWI_STATS_REQUEST, FALSE);
+    scriptRequest(28000, "0x6B while closing", TWI_STATS_REQUEST, FALSE);
+    scriptRequest(32000, "0x6E (door stats) while closing", DOOR_STATS_REQUEST, FALSE);
+
+    scriptEnroll(36000, 7, USER_FLAG_ENABLED, 5);
+    scriptForgedDecision(40000, START_PHASE_TWO_DOOR, 3, START_MOTOR, PASSWORD_INCORRECT);
+    scriptForgedDecision(40500, START_PHASE_TWO_CHANGE, 5, RESET_PASSWORD, PASSWORD_INCORRECT);
+    scriptWrongPassword(41000, SYSTEM_LOCK_SEQUENCE);
+    scriptExpectDoor(40900, DOOR_STATE_LOCKED);
+    scriptExpectDoor(41500, DOOR_STATE_LOCKDOWN);
+
+    scriptRequest(70000, "0x6B during the lockdown", TWI_STATS_REQUEST, FALSE);
+    scriptRequest(95000, "0x6A (audit export, full ring) during the lockdown", AUDIT_EXPORT_REQUEST, TRUE);
+    scriptRequest(105000, "0x6D (task stats)", TASK_STATS_REQUEST, FALSE);
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] scriptDayScenario
+ * [Description]   24 hours: 60 door cycles with 20 s of presence each, 4
+ *                 mistyped passwords, one lockdown, a TWI stats request every
+ *                 hour and one audit export.
+ *----------------------------------------------------------------------------*/
+static void scriptDayScenario(void)
+{
+    uint8 index;
+
+    scriptAt(500);
+    scriptPassword(1);
+    scriptPassword(1);
+
+    for (index = 0; index < 60; index++)
+    {
+        scriptDoorCycle(600000UL + (index * 1400000UL) + ((index % 7) * 37000UL), 20000);
+    }
+    for (index = 0; index < 4; index++)
+    {
+        scriptWrongPassword(3000000UL + (index * 20000000UL), PASSWORD_INCORRECT);
+    }
+    for (index = 0; index < 3; index++)
+    {
+        scriptWrongPassword(50000000UL + (index * 500), (index < 2) ? PASSWORD_INCORRECT : SYSTEM_LOCK_SEQUENCE);
+    }
+    for (index = 0; index < 24; index++)
+    {
+        scriptRequest(2400000UL + (index * 3600000UL), "0x6B hourly", TWI_STATS_REQUEST, FALSE);
+    }
+    scriptRequest(43500000UL, "0x6A (audit export, full ring)", AUDIT_EXPORT_REQUEST, TRUE);
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] scriptHangScenario
+ * [Description]   Three wrong passwords and a lockdown, then 10 s into it the
+ *                 TWI hangs on the audit export request. The watchdog has to
+ *                 reset the controller, which logs the reset and serves the
+ *                 lockdown again from the start; a door cycle afterwards.
+ *----------------------------------------------------------------------------*/
+static void scriptHangScenario(void)
+{
+    uint8 attempt;
+
+    scriptAt(500);
+    scriptPassword(1);
+    scriptPassword(1);
+
+    for (attempt = 0; attempt < 3; attempt++)
+    {
+        scriptWrongPassword(1000 + (attempt * 500), (attempt < 2) ? PASSWORD_INCORRECT : SYSTEM_LOCK_SEQUENCE);
+    }
+
+    scriptAt(12000);
+    scriptAdd(SIM_INPUT_HOLD_BUS, 0, SIM_NO_REQUEST);
+    scriptRequest(12000, "0x6A (audit export) with the TWI hung", AUDIT_EXPORT_REQUEST, TRUE);
+
+    /* Reset about 1 s later, the 60 s lockdown then starts over */
+    scriptExpectDoor(14000, DOOR_STATE_LOCKDOWN);
+    scriptExpectDoor(70000, DOOR_STATE_LOCKDOWN);
+    scriptExpectDoor(80000, DOOR_STATE_LOCKED);
+
+    scriptDoorCycle(85000, 2000);
+    scriptExpectDoor(90000, DOOR_STATE_OPENING);
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] runController
+ * [Description]   Runs the firmware from reset in a child process until a
+ *                 run ends other than by the watchdog, returns its status.
+ *                 A run after a watchdog reset gets the .noinit RAM back,
+ *                 WDRF set and the time of the reset; what the HMI sent
+ *                 before is gone, the PIR level stays.
+ *----------------------------------------------------------------------------*/
+static int runController(void)
+{
+    pid_t child;
+    int status = 0;
+
+    for (;;)
+    {
+        fflush(stdout);
+        child = fork();
+        if (child == 0)
+        {
+            if (g_reset->resets != 0)
+            {
+                memcpy(__noinit_start, g_reset->noinit, (size_t)(__noinit_end - __noinit_start));
+                MCUCSR |= (uint8)(1 << WDRF);
+                EEPROM_MODEL_advanceTime((uint32)(g_reset->reset_us - nowUs()));
+
+                while ((g_script_next < g_script_length) && (g_script[g_script_next].time_us < g_reset->reset_us))
+                {
+                    const SIM_InputType *input = &g_script[g_script_next++];
+
+                    if (input->kind == SIM_INPUT_PIR)
+                    {
+                        g_pir_level = input->value;
+                    }
+                    if (input->request != SIM_NO_REQUEST)
+                    {
+                        g_requests[input->request].name = NULL;
+                    }
+                }
+            }
+            g_run_us = nowUs();
+            control_main();
+            _exit(2);
+        }
+
+        waitpid(child, &status, 0);
+        if (!WIFEXITED(status) || (WEXITSTATUS(status) != SIM_EXIT_WATCHDOG_RESET))
+        {
+            return WIFEXITED(status) ? WEXITSTATUS(status) : 2;
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------
+ *  Main
+ *----------------------------------------------------------------------------*/
+
+int main(int argc, char **argv)
+{
+    const char *scenario = (argc > 1) ? argv[1] : "door";
+    boolean day = (boolean)(strcmp(scenario, "day") == 0);
+    uint8 record_idx;
+
+    if ((__noinit_end - __noinit_start) > SIM_NOINIT_SIZE)
+    {
+        fprintf(stderr, ".noinit larger than SIM_NOINIT_SIZE\n");
+        return 2;
+    }
+    g_reset = mmap(NULL, sizeof(*g_reset), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (g_reset == MAP_FAILED)
+    {
+        perror("mmap");
+        return 2;
+    }
+    g_reset->hang_us = SIM_NEVER;
+    g_hang = (boolean)(strcmp(scenario, "hang") == 0);
+
+    /* A controller in service: blank credentials, an audit ring already full */
+    EEPROM_MODEL_erase();
+    AUDIT_init();
+    for (record_idx = 0; record_idx < AUDIT_RING_RECORDS; record_idx++)
+    {
+        AUDIT_log(AUDIT_EVENT_DOOR_OPENED, record_idx);
+        AUDIT_flush();
+    }
+    EEPROM_MODEL_advanceTime(EEPROM_MODEL_WRITE_CYCLE_US);
+
+    AVR_MODEL_setPinReader(AVR_MODEL_PORT_C, readPortC);
+    AVR_MODEL_setDelayHook(delayHook);
+    AVR_MODEL_setSleepHook(sleepHook);
+    AVR_MODEL_setWatchdogHook(watchdogHook);
+    EEPROM_MODEL_setClockHook(busClockHook);
+
+    g_boot_us = nowUs();
+    g_end_us = g_boot_us + ((uint64)(day ? SIM_DAY_RUN_MS : (g_hang ? SIM_HANG_RUN_MS : SIM_DOOR_RUN_MS)) * 1000);
+    g_verbose = (boolean)!day;
+    if (day)
+    {
+        scriptDayScenario();
+    }
+    else if (g_hang)
+    {
+        g_expected_resets = 1;
+        scriptHangScenario();
+    }
+    else
+    {
+        scriptDoorScenario();
+    }
+    qsort(g_script, g_script_length, sizeof(g_script[0]), compareInputs);
+
+    printf("control ECU co-simulation, %s scenario, times from the start of main()\n", day ? "day" : (g_hang ? "hang" : "door"));
+    return runController();
+}
@@ -0,0 +1,749 @@
+/*------------------------------------------------------------------------------
+ *  Module      : HMI ECU Co-simulation
+ *  File        : sim_hmi.c
+ *  Description : Runs the HMI ECU firmware, its main() and every module but
+ *                the UART driver unchanged, on a simulated clock with a
+ *                keypad, an LCD and a scripted control ECU. An ideal typist
+ *                enters the first PIN, releasing each key as soon as the HMI
+ *                shows it took it. Reports how long the PIN takes from the
+ *                first press to the end of the last password byte sent. With
+ *                'typeahead' a user types without waiting for the screens at
+ *                a fixed rate, with contact bounce, and the fastest rate
+ *                without a lost key is reported
+ *  Author      : Hassan Darwish
+ *
+ *  The clock advances with the _delay busy waits, by SIM_UART_BYTE_US per
+ *  byte sent when the sender has to wait for the previous one, by
+ *  SIM_PASS_US per SW_TIMER_millis() call outside an interrupt (every pass
+ *  of the main loop makes one) and by SIM_PIN_READ_US per keypad read. The rest of the CPU time is not
+ *  modelled. The TIMER2 compare (tick) and TIMER1 overflow interrupts are
+ *  delivered when they fall due.
+ *
+ *  Only main() and the pins are used, so the firmware of an earlier
+ *  revision runs too: make -C host HMI=<its hmi_ecu directory>
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "hmi_constants.h"
+#include "gpio.h"
+#include "keypad.h"
+#include "lcd.h"
+#include "uart.h"
+#include "avr_model.h"
+
+#include <avr/interrupt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/* One byte on the control ECU link: 10 bits at 9600 baud */
+#define SIM_UART_BYTE_US                        1042
+
+/*
+ * CPU time of a main loop pass with nothing to do and of a keypad pin read
+ * through its driver. Not measured, small next to the LCD and link times.
+ */
+#define SIM_PASS_US                             20
+#define SIM_PIN_READ_US                         1
+
+/* The control ECU co-simulation starts its replies within 1 ms */
+#define SIM_REPLY_US                            1000
+
+/* A run that has not finished by then failed */
+#define SIM_RUN_LIMIT_MS                        20000UL
+
+/* PIN entry: first press, PIN typed and the release gaps tried */
+#define SIM_TYPIST_START_MS                     1000
+#define SIM_TYPIST_PIN                          "12345E"
+#define SIM_TYPIST_GAPS_MS                      {5, 10, 20, 30}
+#define SIM_TYPIST_GAP_COUNT                    4
+
+/*
+ * Type-ahead: the PIN set twice in one burst from SIM_TYPEAHEAD_START_MS,
+ * then the door opened with "+PIN Enter" SIM_MENU_REACTION_MS after the
+ * verdict. Each keystroke is held half its period, the contacts bounce for
+ * SIM_BOUNCE_US after each edge. Rates from 1 to SIM_MAX_RATE keys/s, each
+ * with SIM_SEEDS bounce patterns.
+ */
+#define SIM_TYPEAHEAD_START_MS                  300
+#define SIM_TYPEAHEAD_SETUP                     "12345E12345E"
+#define SIM_TYPEAHEAD_DOOR                      "+12345E"
+#define SIM_MENU_REACTION_MS                    300
+#define SIM_BOUNCE_US                           1500
+#define SIM_MAX_RATE                            80
+#define SIM_SEEDS                               8
+
+#define SIM_KEYSTROKES                          32
+#define SIM_RECEIVE_QUEUE_SIZE                  16
+#define SIM_ENTRIES                             4
+
+#define SIM_NEVER                               0xFFFFFFFFFFFFFFFFULL
+
+/*------------------------------------------------------------------------------
+ *  Data Types Declarations
+ *----------------------------------------------------------------------------*/
+
+/* A key pressed at down_us and released at up_us (SIM_NEVER: still held) */
+typedef struct
+{
+    uint8 button;
+    uint64 down_us;
+    uint64 up_us;
+} SIM_KeystrokeType;
+
+/* A byte from the control ECU, received by the HMI at time_us */
+typedef struct
+{
+    uint64 time_us;
+    uint8 value;
+} SIM_ReceivedType;
+
+/*------------------------------------------------------------------------------
+ *  Firmware Entry Points
+ *----------------------------------------------------------------------------*/
+
+/* hmi.c, built with -Dmain=hmi_main */
+int hmi_main(void);
+
+/* sw_timer.c, built with -DSW_TIMER_millis=SW_TIMER_millisFirmware */
+uint32 SW_TIMER_millisFirmware(void);
+
+/* timer.c */
+void TIMER1_OVF_vect(void);
+void TIMER2_COMP_vect(void);
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+/* Key reported for each button, the 4x4 layout of the Proteus keypad */
+static const uint8 g_layout[KEYPAD_NUM_ROWS * KEYPAD_NUM_COLS] =
+{
+    7, 8, 9, '%',
+    4, 5, 6, '*',
+    1, 2, 3, '-',
+    '^', 0, 13, '+'
+};
+
+/* Run being simulated, for the report */
+static char g_run_name[32];
+static boolean g_verbose = TRUE;
+static uint32 g_seed = 1;
+static uint32 g_rate = 0;
+
+static uint64 g_now_us = 0;
+static uint64 g_end_us = SIM_NEVER;
+
+/* Interrupt sources */
+static uint64 g_timer1_due_us = SIM_NEVER;
+static uint64 g_timer1_start_us = 0;
+static uint64 g_timer2_due_us = SIM_NEVER;
+static boolean g_in_interrupt = FALSE;
+
+/* Keypad */
+static SIM_KeystrokeType g_keys[SIM_KEYSTROKES];
+static uint8 g_key_count = 0;
+static uint32 g_bounce_us = 0;
+
+/* Typist: the keys left to press and the release gap */
+static const char *g_typist_text = NULL;
+static uint8 g_typist_typed = 0;
+static uint32 g_typist_gap_us = 0;
+
+/* LCD: enable line at the last look and '*' characters written */
+static uint8 g_lcd_enable = 0;
+static uint8 g_stars = 0;
+
+/* Link: end of the byte being sent, bytes waiting for the HMI */
+static uint64 g_send_end_us = 0;
+static uint8 g_start_bytes = 0;
+static SIM_ReceivedType g_received[SIM_RECEIVE_QUEUE_SIZE];
+static uint8 g_received_head = 0;
+static uint8 g_received_count = 0;
+
+/* Passwords received by the control ECU and when their last byte ended */
+static uint8 g_entries[SIM_ENTRIES][KEYPAD_PASSWORD_SIZE];
+static uint64 g_entry_end_us[SIM_ENTRIES];
+static uint8 g_entry_count = 0;
+static uint8 g_entry_digit = KEYPAD_PASSWORD_SIZE;
+
+/* Called with the index of each password the control ECU receives */
+static void (*g_on_entry)(uint8) = NULL;
+
+/*------------------------------------------------------------------------------
+ *  Clock and Interrupts
+ *----------------------------------------------------------------------------*/
+
+static void finish(boolean failed)
+{
+    exit(failed ? 1 : 0);
+}
+
+/* Prescaler of the clock select bits, 0 while the timer is stopped */
+static uint32 timerPrescaler(uint8 clock_select, boolean timer2)
+{
+    static const uint16 timer01[8] = {0, 1, 8, 64, 256, 1024, 0, 0};
+    static const uint16 timer2_prescalers[8] = {0, 1, 8, 32, 64, 128, 256, 1024};
+
+    return timer2 ? timer2_prescalers[clock_select & 0x07] : timer01[clock_select & 0x07];
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] updateTimers
+ * [Description]   Schedules the next TIMER2 compare and TIMER1 overflow
+ *                 interrupt from the registers, stops a timer whose
+ *                 interrupt or clock was turned off, and sets TCNT1 and
+ *                 TCNT2 for the code reading them.
+ *----------------------------------------------------------------------------*/
+static void updateTimers(uint64 now)
+{
+    uint32 prescaler;
+    uint64 period;
+
+    prescaler = timerPrescaler(TCCR2, TRUE);
+    if ((prescaler == 0) || !(TIMSK & (1 << OCIE2)))
+    {
+        g_timer2_due_us = SIM_NEVER;
+    }
+    else
+    {
+        period = ((uint64)(OCR2 + 1) * prescaler * 1000000ULL) / F_CPU;
+        if (g_timer2_due_us == SIM_NEVER)
+        {
+            g_timer2_due_us = now + period;
+        }
+        TCNT2 = (uint8)(((now + period - g_timer2_due_us) * F_CPU) / (prescaler * 1000000ULL));
+    }
+
+    prescaler = timerPrescaler(TCCR1B, FALSE);
+    if ((prescaler == 0) || !(TIMSK & (1 << TOIE1)))
+    {
+        g_timer1_due_us = SIM_NEVER;
+    }
+    else
+    {
+        period = (65536ULL * prescaler * 1000000ULL) / F_CPU;
+        if (g_timer1_due_us == SIM_NEVER)
+        {
+            g_timer1_start_us = now;
+            g_timer1_due_us = now + period;
+        }
+        TCNT1 = (uint16)(((now - g_timer1_start_us) * F_CPU) / (prescaler * 1000000ULL));
+    }
+}
+
+static uint64 nextInterruptUs(void)
+{
+    return (g_timer1_due_us < g_timer2_due_us) ? g_timer1_due_us : g_timer2_due_us;
+}
+
+/* Runs the interrupts due by now, unless disabled or one is already running */
+static void deliverInterrupts(void)
+{
+    uint64 due;
+
+    if (g_in_interrupt || !(SREG & (1 << AVR_MODEL_SREG_I)))
+    {
+        return;
+    }
+
+    g_in_interrupt = TRUE;
+    for (;;)
+    {
+        updateTimers(g_now_us);
+        due = nextInterruptUs();
+        if (due > g_now_us)
+        {
+            break;
+        }
+
+        if (due == g_timer2_due_us)
+        {
+            g_timer2_due_us = SIM_NEVER;
+            updateTimers(due);
+            TIMER2_COMP_vect();
+        }
+        else
+        {
+            g_timer1_due_us = SIM_NEVER;
+            updateTimers(due);
+            g_timer1_start_us = due;
+            TIMER1_OVF_vect();
+        }
+    }
+    g_in_interrupt = FALSE;
+}
+
+/* Time passing, interrupts are delivered on the way. Ends a run past its limit. */
+static void runUntil(uint64 end_us)
+{
+    uint64 next;
+
+    while (g_now_us < end_us)
+    {
+        if (g_now_us >= g_end_us)
+        {
+            if (g_verbose)
+            {
+                printf("%s: not done after %lu ms\n", g_run_name, SIM_RUN_LIMIT_MS);
+            }
+            finish(TRUE);
+        }
+
+        next = nextInterruptUs();
+        if ((next <= g_now_us) || (next > end_us) || !(SREG & (1 << AVR_MODEL_SREG_I)))
+        {
+            next = end_us;
+        }
+        g_now_us = (next < g_end_us) ? next : g_end_us;
+        deliverInterrupts();
+    }
+}
+
+/*------------------------------------------------------------------------------
+ *  Keypad and Typist
+ *----------------------------------------------------------------------------*/
+
+static uint8 buttonOf(char key)
+{
+    uint8 value = (key == 'E') ? KEYPAD_ENTER_BUTTON : ((key >= '0') && (key <= '9')) ? (uint8)(key - '0') : (uint8)key;
+    uint8 button;
+
+    for (button = 0; g_layout[button] != value; button++)
+    {
+    }
+    return button;
+}
+
+static void addKeystroke(char key, uint64 down_us, uint64 up_us)
+{
+    if (g_key_count == SIM_KEYSTROKES)
+    {
+        fprintf(stderr, "too many keystrokes\n");
+        exit(2);
+    }
+
+    g_keys[g_key_count].button = buttonOf(key);
+    g_keys[g_key_count].down_us = down_us;
+    g_keys[g_key_count].up_us = up_us;
+    g_key_count++;
+}
+
+/* Contact of a keystroke, random for g_bounce_us after each edge */
+static boolean isClosed(const SIM_KeystrokeType *key)
+{
+    if (g_now_us < key->down_us)
+    {
+        return FALSE;
+    }
+    if (g_now_us < (key->down_us + g_bounce_us))
+    {
+        return (boolean)(rand() & 1);
+    }
+    if ((key->up_us == SIM_NEVER) || (g_now_us < key->up_us))
+    {
+        return TRUE;
+    }
+    if (g_now_us < (key->up_us + g_bounce_us))
+    {
+        return (boolean)(rand() & 1);
+    }
+    return FALSE;
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] readPortB
+ * [Description]   PINB of the keypad matrix: rows on PB0..PB3, columns on
+ *                 PB4..PB7 pulled high. A row driven low pulls down the
+ *                 columns of its closed switches (test_keypad.c models the
+ *                 ghosting of several keys, the typists here press one key
+ *                 at a time).
+ *----------------------------------------------------------------------------*/
+static uint8 readPortB(void)
+{
+    uint8 low_rows = (uint8)(DDRB & (uint8)~PORTB & 0x0F);
+    uint8 low_cols = 0;
+    uint8 key_idx;
+
+    runUntil(g_now_us + SIM_PIN_READ_US);
+
+    for (key_idx = 0; key_idx < g_key_count; key_idx++)
+    {
+        uint8 row = (uint8)(g_keys[key_idx].button / KEYPAD_NUM_COLS);
+        uint8 col = (uint8)(g_keys[key_idx].button % KEYPAD_NUM_COLS);
+
+        if ((low_rows & (1 << row)) && isClosed(&g_keys[key_idx]))
+        {
+            low_cols |= (uint8)(1 << col);
+        }
+    }
+
+    return (uint8)((0xF0 & (uint8)~(low_cols << 4)) | (uint8)(0x0F & (uint8)~low_rows));
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] observeTypist
+ * [Description]   The ideal typist releases the key held once the HMI shows
+ *                 it took it: its '*' is on the LCD, or for Enter the
+ *                 password started being sent. The next key is pressed
+ *                 g_typist_gap_us after the release.
+ *----------------------------------------------------------------------------*/
+static void observeTypist(void)
+{
+    SIM_KeystrokeType *key = &g_keys[(g_key_count > 0) ? (g_key_count - 1) : 0];
+    boolean taken;
+
+    if ((g_typist_text == NULL) || (key->up_us != SIM_NEVER) || (g_now_us < key->down_us))
+    {
+        return;
+    }
+
+    if (g_typist_text[g_typist_typed - 1] == 'E')
+    {
+        taken = (boolean)(g_start_bytes > 0);
+    }
+    else
+    {
+        taken = (boolean)(g_stars >= g_typist_typed);
+    }
+    if (!taken)
+    {
+        return;
+    }
+
+    key->up_us = g_now_us;
+    if (g_typist_text[g_typist_typed] != '\0')
+    {
+        addKeystroke(g_typist_text[g_typist_typed++], g_now_us + g_typist_gap_us, SIM_NEVER);
+    }
+}
+
+/*------------------------------------------------------------------------------
+ *  LCD and Control ECU Link
+ *----------------------------------------------------------------------------*/
+
+/*
+ * lcd.h: RS and E on PORTC, the 8-bit data bus on PORTA. The driver waits
+ * after every change of E, so looking at each busy wait sees every edge:
+ * a character is written on the falling edge of E with RS high.
+ */
+static void observeLcd(void)
+{
+    uint8 enable = (uint8)((PORTC >> LCD_E_PIN_ID) & 1);
+
+    if (g_lcd_enable && !enable && (PORTC & (1 << LCD_RS_PIN_ID)) && (PORTA == '*'))
+    {
+        g_stars++;
+    }
+    g_lcd_enable = enable;
+}
+
+/* A byte from the control ECU, started 'delay_us' after 'time_us' */
+static void sendToHmi(uint64 time_us, uint32 delay_us, uint8 value)
+{
+    uint8 slot;
+
+    if (g_received_count == SIM_RECEIVE_QUEUE_SIZE)
+    {
+        fprintf(stderr, "receive queue full\n");
+        exit(2);
+    }
+
+    slot = (uint8)((g_received_head + g_received_count) % SIM_RECEIVE_QUEUE_SIZE);
+    g_received[slot].time_us = time_us + delay_us + SIM_UART_BYTE_US;
+    g_received[slot].value = value;
+    g_received_count++;
+}
+
+static boolean isReceived(void)
+{
+    return (boolean)((g_received_count > 0) && (g_received[g_received_head].time_us <= g_now_us));
+}
+
+/* The control ECU: collects the passwords, SEND_START_PASSWORD and 5 digits */
+static void controlReceive(uint8 data, uint64 time_us)
+{
+    if (g_entry_digit < KEYPAD_PASSWORD_SIZE)
+    {
+        g_entries[g_entry_count][g_entry_digit++] = data;
+        if (g_entry_digit == KEYPAD_PASSWORD_SIZE)
+        {
+            g_entry_end_us[g_entry_count] = time_us;
+            g_entry_count++;
+            if (g_on_entry != NULL)
+            {
+                g_on_entry((uint8)(g_entry_count - 1));
+            }
+        }
+        return;
+    }
+
+    if ((data == SEND_START_PASSWORD) && (g_entry_count < SIM_ENTRIES))
+    {
+        g_entry_digit = 0;
+    }
+}
+
+/* Entry 'index' matches the PIN of the script */
+static boolean isPin(uint8 index, const char *pin)
+{
+    uint8 digit_idx;
+
+    for (digit_idx = 0; digit_idx < KEYPAD_PASSWORD_SIZE; digit_idx++)
+    {
+        if (g_entries[index][digit_idx] != (uint8)(pin[digit_idx] - '0'))
+        {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/*------------------------------------------------------------------------------
+ *  AVR and Peripheral Stand-ins
+ *----------------------------------------------------------------------------*/
+
+static void delayHook(double microseconds)
+{
+    observeLcd();
+    observeTypist();
+    runUntil(g_now_us + (uint64)microseconds);
+}
+
+/* Read at the start of every main loop pass */
+uint32 SW_TIMER_millis(void)
+{
+    if (!g_in_interrupt)
+    {
+        runUntil(g_now_us + SIM_PASS_US);
+    }
+    return SW_TIMER_millisFirmware();
+}
+
+void UART_init(const UART_ConfigType *Config_Ptr)
+{
+    (void)Config_Ptr;
+}
+
+/* The sender waits while the previous byte is still being sent */
+void UART_sendByte(const uint8 data)
+{
+    if (g_send_end_us > g_now_us)
+    {
+        runUntil(g_send_end_us);
+    }
+    g_send_end_us = g_now_us + SIM_UART_BYTE_US;
+
+    if (data == SEND_START_PASSWORD)
+    {
+        g_start_bytes++;
+        observeTypist();
+    }
+    controlReceive(data, g_send_end_us);
+}
+
+uint8 UART_isDataAvailable(void)
+{
+    return isReceived();
+}
+
+uint8 UART_recieveByte(void)
+{
+    uint8 value;
+
+    while (!isReceived())
+    {
+        runUntil((g_received_count > 0) ? g_received[g_received_head].time_us : g_end_us);
+    }
+
+    value = g_received[g_received_head].value;
+    g_received_head = (uint8)((g_received_head + 1) % SIM_RECEIVE_QUEUE_SIZE);
+    g_received_count--;
+    return value;
+}
+
+void UART_flush(void)
+{
+    while (isReceived())
+    {
+        (void)UART_recieveByte();
+    }
+}
+
+/*------------------------------------------------------------------------------
+ *  Scenarios
+ *----------------------------------------------------------------------------*/
+
+/* PIN entry: the first password is all this scenario waits for */
+static void typistEntry(uint8 index)
+{
+    boolean failed = (boolean)!isPin(index, SIM_TYPIST_PIN);
+
+    printf("%s: PIN typed and sent in %.1f ms%s\n", g_run_name,
+           (double)(g_entry_end_us[index] - g_keys[0].down_us) / 1000.0, failed ? ", wrong digits" : "");
+    finish(failed);
+}
+
+static void startTypist(uint32 gap_ms)
+{
+    g_typist_text = SIM_TYPIST_PIN;
+    g_typist_gap_us = gap_ms * 1000UL;
+    snprintf(g_run_name, sizeof(g_run_name), "release gap %2lu ms", (unsigned long)gap_ms);
+    g_on_entry = typistEntry;
+    addKeystroke(g_typist_text[g_typist_typed++], (uint64)SIM_TYPIST_START_MS * 1000, SIM_NEVER);
+}
+
+/* Keys typed at g_rate keys/s from 'time_us', the time after the last one */
+static uint64 typeBurst(const char *keys, uint64 time_us)
+{
+    uint64 period_us = 1000000ULL / g_rate;
+
+    for (; *keys != '\0'; keys++)
+    {
+        addKeystroke(*keys, time_us, time_us + (period_us / 2));
+        time_us += period_us;
+    }
+    return time_us;
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] typeAheadEntry
+ * [Description]   The control ECU side of the type-ahead run: the verdict on
+ *                 the two setup entries (the user starts typing the door
+ *                 burst once it is shown), then the end of the run with the
+ *                 door entry. The run passes if all three carry the PIN.
+ *----------------------------------------------------------------------------*/
+static void typeAheadEntry(uint8 index)
+{
+    const char *pin = SIM_TYPEAHEAD_DOOR + 1;
+    uint64 verdict_us;
+    uint8 digit_idx;
+    boolean same = TRUE;
+
+    if (index == 1)
+    {
+        for (digit_idx = 0; digit_idx < KEYPAD_PASSWORD_SIZE; digit_idx++)
+        {
+            same &= (boolean)(g_entries[0][digit_idx] == g_entries[1][digit_idx]);
+        }
+        sendToHmi(g_entry_end_us[1], SIM_REPLY_US, same ? RECIEVE_TRUE : RECIEVE_FALSE);
+        verdict_us = g_entry_end_us[1] + SIM_REPLY_US + SIM_UART_BYTE_US;
+        typeBurst(SIM_TYPEAHEAD_DOOR, verdict_us + (SIM_MENU_REACTION_MS * 1000ULL));
+    }
+    else if (index == 2)
+    {
+        finish((boolean)!(isPin(0, pin) && isPin(1, pin) && isPin(2, pin)));
+    }
+}
+
+static void startTypeAhead(uint32 rate)
+{
+    srand(g_seed);
+    g_verbose = FALSE;
+    g_rate = rate;
+    g_bounce_us = SIM_BOUNCE_US;
+    g_on_entry = typeAheadEntry;
+    typeBurst(SIM_TYPEAHEAD_SETUP, (uint64)SIM_TYPEAHEAD_START_MS * 1000);
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] runFirmware
+ * [Description]   Runs main() in a child process set up by 'scenario', so
+ *                 every run starts from reset. TRUE if the run passed.
+ *----------------------------------------------------------------------------*/
+static boolean runFirmware(void (*scenario)(uint32), uint32 parameter)
+{
+    pid_t child;
+    int status = 0;
+
+    fflush(stdout);
+    child = fork();
+    if (child == 0)
+    {
+        AVR_MODEL_setPinReader(AVR_MODEL_PORT_B, readPortB);
+        AVR_MODEL_setDelayHook(delayHook);
+        g_end_us = SIM_RUN_LIMIT_MS * 1000ULL;
+        scenario(parameter);
+        hmi_main();
+        _exit(2);
+    }
+    waitpid(child, &status, 0);
+
+    return (boolean)(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+}
+
+/*------------------------------------------------------------------------------
+ *  Main
+ *----------------------------------------------------------------------------*/
+
+static boolean runPinEntry(void)
+{
+    static const uint32 gaps_ms[SIM_TYPIST_GAP_COUNT] = SIM_TYPIST_GAPS_MS;
+    boolean passed = TRUE;
+    uint8 gap_idx;
+
+    printf("HMI ECU co-simulation, PIN entry: %s by an ideal typist, clean contacts, "
+           "first press to the end of the last byte\n", SIM_TYPIST_PIN);
+    for (gap_idx = 0; gap_idx < SIM_TYPIST_GAP_COUNT; gap_idx++)
+    {
+        passed &= runFirmware(startTypist, gaps_ms[gap_idx]);
+    }
+
+    return passed;
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] runTypeAhead
+ * [Description]   Every rate with every seed, up to the first rate where all
+ *                 of them lose keys. Prints the rates where a seed lost a key
+ *                 and the fastest rate up to which none did.
+ *----------------------------------------------------------------------------*/
+static boolean runTypeAhead(void)
+{
+    uint32 fastest = 0;
+    uint32 rate;
+    uint8 lost = 0;
+
+    printf("HMI ECU co-simulation, type-ahead: \"%s\" then \"%s\", %u us bounce, %u seeds per rate\n",
+           SIM_TYPEAHEAD_SETUP, SIM_TYPEAHEAD_DOOR, SIM_BOUNCE_US, SIM_SEEDS);
+    for (rate = 1; (rate <= SIM_MAX_RATE) && (lost < SIM_SEEDS); rate++)
+    {
+        lost = 0;
+        for (g_seed = 1; g_seed <= SIM_SEEDS; g_seed++)
+        {
+            lost += !runFirmware(startTypeAhead, rate);
+        }
+
+        if (lost > 0)
+        {
+            printf("%2lu keys/s: keys lost with %u of %u seeds\n", (unsigned long)rate, lost, SIM_SEEDS);
+        }
+        else if (fastest == (rate - 1))
+        {
+            fastest = rate;
+        }
+    }
+
+    printf("no key lost up to %lu keys/s\n", (unsigned long)fastest);
+    return (boolean)(fastest > 0);
+}
+
+/*------------------------------------------------------------------------------
+ *  Main
+ *----------------------------------------------------------------------------*/
+
+int main(int argc, char **argv)
+{
+    boolean type_ahead = (boolean)((argc > 1) && (strcmp(argv[1], "typeahead") == 0));
+
+    return (type_ahead ? runTypeAhead() : runPinEntry()) ? 0 : 1;
+}
@@ -0,0 +1,448 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Audit Log Test
+ *  File        : test_audit_log.c
+ *  Description : Logs, flushes and exports audit records on the 24C16 model:
+ *                16-bit details, ring wrap-around, resuming after a reboot,
+ *                logging while a stepped export runs and records torn by a
+ *                power cut in any byte of their write
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "twi.h"
+#include "external_eeprom.h"
+#include "eeprom_queue.h"
+#include "audit_log.h"
+#include "crc.h"
+#include "control_constants.h"
+#include "eeprom_model.h"
+#include "host_test.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/* Large enough for a full ring export */
+#define AUDIT_TEST_CAPTURE_SIZE                 2048
+
+/* Records logged before the one whose write is cut */
+#define AUDIT_TEST_BEFORE_CUT                   5
+
+/* UART rate of the Control ECU, for the frame transmit time */
+#define AUDIT_TEST_BAUD_RATE                    9600
+
+/* Exit status of the process whose power is cut */
+#define AUDIT_TEST_CUT_WHOLE                    0x01
+#define AUDIT_TEST_CUT_FAILED                   0x02
+
+/*------------------------------------------------------------------------------
+ *  Data Types Declarations
+ *----------------------------------------------------------------------------*/
+
+/* Result of decoding one captured export */
+typedef struct
+{
+    uint16 records;
+    uint16 first_sequence;
+    uint16 last_sequence;
+    uint16 next_cursor;
+    uint8 skipped;
+    uint16 dropped;
+    boolean in_order;           /* Sequence numbers follow each other */
+    boolean details_match;      /* Every detail is its sequence number + 0x1000 */
+    boolean complete;           /* END frame received, every frame CRC correct */
+} AUDIT_TEST_ExportType;
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+static TWI_ConfigType g_twi_configuration = {TWI_ADDRESS, TWI_BITRATE};
+
+static uint8 g_capture[AUDIT_TEST_CAPTURE_SIZE];
+static uint16 g_capture_length = 0;
+
+/*------------------------------------------------------------------------------
+ *  Private Functions
+ *----------------------------------------------------------------------------*/
+
+static void captureByte(uint8 data)
+{
+    if (g_capture_length < AUDIT_TEST_CAPTURE_SIZE)
+    {
+        g_capture[g_capture_length++] = data;
+    }
+}
+
+/* Power cycle: the RAM stage and the write-behind queue are gone */
+static void reboot(void)
+{
+    EEPROM_MODEL_advanceTime(EEPROM_MODEL_WRITE_CYCLE_US);
+    AUDIT_init();
+}
+
+/* The detail of each test record is derived from its sequence number */
+static void logRecords(uint16 first_sequence, uint16 count)
+{
+    uint16 record_idx;
+
+    for (record_idx = 0; record_idx < count; record_idx++)
+    {
+        AUDIT_log(AUDIT_EVENT_DOOR_OPENED, (uint16)(first_sequence + record_idx + 0x1000));
+        if (((record_idx + 1) % AUDIT_STAGE_RECORDS) == 0)
+        {
+            HOST_CHECK(AUDIT_flush() == SUCCESS);
+        }
+    }
+    HOST_CHECK(AUDIT_flush() == SUCCESS);
+    HOST_CHECK(EEPROM_QUEUE_flush() == SUCCESS);
+}
+
+static void decodeExport(AUDIT_TEST_ExportType *result)
+{
+    uint16 position = 0;
+    uint16 crc;
+    uint8 type;
+    uint8 length;
+    uint8 byte_idx;
+    uint8 offset;
+
+    result->records = 0;
+    result->skipped = 0;
+    result->in_order = TRUE;
+    result->details_match = TRUE;
+    result->complete = FALSE;
+
+    while ((position + 5) <= g_capture_length)
+    {
+        if (g_capture[position] != DIAG_FRAME_SOF)
+        {
+            return;
+        }
+        type = g_capture[position + 1];
+        length = g_capture[position + 2];
+        if ((position + 5 + length) > g_capture_length)
+        {
+            return;
+        }
+
+        crc = CRC16_INITIAL_VALUE;
+        for (byte_idx = 0; byte_idx < (uint8)(length + 2); byte_idx++)
+        {
+            crc = CRC16_update(crc, g_capture[position + 1 + byte_idx]);
+        }
+        if (crc != (uint16)(g_capture[position + 3 + length] | (g_capture[position + 4 + length] << 8)))
+        {
+            return;
+        }
+
+        const uint8 *payload = &g_capture[position + 3];
+
+        if (type == AUDIT_EXPORT_FRAME_DATA)
+        {
+            for (offset = 0; (offset + AUDIT_RECORD_SIZE) <= length; offset += AUDIT_RECORD_SIZE)
+            {
+                const uint8 *record = &payload[offset];
+                uint16 sequence = (uint16)(record[AUDIT_SEQUENCE_OFFSET] | (record[AUDIT_SEQUENCE_OFFSET + 1] << 8));
+                uint16 detail = (uint16)(record[AUDIT_DETAIL_OFFSET] | (record[AUDIT_DETAIL_OFFSET + 1] << 8));
+
+                if (result->records == 0)
+                {
+                    result->first_sequence = sequence;
+                }
+                else if (sequence != (uint16)(result->last_sequence + 1))
+                {
+                    result->in_order = FALSE;
+                }
+                if ((detail != (uint16)(sequence + 0x1000)) || (record[AUDIT_EVENT_OFFSET] != AUDIT_EVENT_DOOR_OPENED))
+                {
+                    result->details_match = FALSE;
+                }
+                result->last_sequence = sequence;
+                result->records++;
+            }
+        }
+        else if ((type == AUDIT_EXPORT_FRAME_END) && (length == AUDIT_EXPORT_END_LENGTH))
+        {
+            result->next_cursor = (uint16)(payload[0] | (payload[1] << 8));
+            result->skipped = payload[2];
+            result->dropped = (uint16)(payload[3] | (payload[4] << 8));
+            result->complete = TRUE;
+        }
+
+        position = (uint16)(position + 5 + length);
+    }
+}
+
+static void exportAll(AUDIT_TEST_ExportType *result)
+{
+    g_capture_length = 0;
+    AUDIT_exportBegin(AUDIT_EXPORT_ALL);
+    while (AUDIT_exportStep(captureByte))
+    {
+    }
+    decodeExport(result);
+}
+
+static void testRoundTrip(void)
+{
+    AUDIT_TEST_ExportType result;
+
+    EEPROM_MODEL_erase();
+    reboot();
+    logRecords(0, 3);
+    reboot();
+
+    exportAll(&result);
+    HOST_CHECK(result.complete);
+    HOST_CHECK_EQUAL(result.records, 3);
+    HOST_CHECK_EQUAL(result.first_sequence, 0);
+    HOST_CHECK(result.in_order);
+    HOST_CHECK(result.details_match);
+    HOST_CHECK_EQUAL(result.next_cursor, 3);
+    HOST_CHECK_EQUAL(result.skipped, 0);
+}
+
+/* Events logged while the stage is full are counted and reported in the END frame */
+static void testDroppedCount(void)
+{
+    AUDIT_TEST_ExportType result;
+    uint16 dropped_before;
+    uint8 record_idx;
+
+    EEPROM_MODEL_erase();
+    reboot();
+    dropped_before = AUDIT_getDroppedCount();
+
+    for (record_idx = 0; record_idx < (AUDIT_STAGE_RECORDS + 2); record_idx++)
+    {
+        AUDIT_log(AUDIT_EVENT_DOOR_OPENED, (uint16)(record_idx + 0x1000));
+    }
+    HOST_CHECK_EQUAL(AUDIT_getDroppedCount(), dropped_before + 2);
+
+    exportAll(&result);
+    HOST_CHECK(result.complete);
+    HOST_CHECK_EQUAL(result.records, AUDIT_STAGE_RECORDS);
+    HOST_CHECK_EQUAL(result.dropped, AUDIT_getDroppedCount());
+
+    /* The export handed the stage to the queue, nothing may land after the next erase */
+    HOST_CHECK(EEPROM_QUEUE_flush() == SUCCESS);
+}
+
+static void testWrapAround(void)
+{
+    AUDIT_TEST_ExportType result;
+
+    EEPROM_MODEL_erase();
+    reboot();
+    logRecords(0, 100);
+    reboot();
+
+    /* Only the newest ring's worth survives, oldest first */
+    exportAll(&result);
+    HOST_CHECK(result.complete);
+    HOST_CHECK_EQUAL(result.records, AUDIT_RING_RECORDS);
+    HOST_CHECK_EQUAL(result.first_sequence, 100 - AUDIT_RING_RECORDS);
+    HOST_CHECK_EQUAL(result.last_sequence, 99);
+    HOST_CHECK(result.in_order);
+    HOST_CHECK(result.details_match);
+    HOST_CHECK_EQUAL(result.next_cursor, 100);
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] cutRecordWrite
+ * [Description]   Runs in a child process, whose exit stands for the power
+ *                 cut: logs one record and commits the first page it touches
+ *                 with only 'programmed_bytes' cells programmed. A record
+ *                 spanning two pages never gets its second write cycle.
+ *----------------------------------------------------------------------------*/
+static int cutRecordWrite(uint16 sequence, uint8 programmed_bytes)
+{
+    EEPROM_MODEL_StatsType stats;
+    int status = 0;
+
+    EEPROM_MODEL_advanceTime(EEPROM_MODEL_WRITE_CYCLE_US);
+    EEPROM_MODEL_resetStats();
+    EEPROM_MODEL_cutPowerDuringNextWrite(programmed_bytes);
+
+    AUDIT_log(AUDIT_EVENT_DOOR_OPENED, (uint16)(sequence + 0x1000));
+    if (AUDIT_flush() == ERROR)
+    {
+        status |= AUDIT_TEST_CUT_FAILED;
+    }
+    EEPROM_QUEUE_service();
+
+    EEPROM_MODEL_getStats(&stats);
+    if (stats.write_cycles != 1)
+    {
+        status |= AUDIT_TEST_CUT_FAILED;
+    }
+    /* The record lies in one page and the cut came after its last cell */
+    if ((stats.bytes_programmed == AUDIT_RECORD_SIZE) && (programmed_bytes >= AUDIT_RECORD_SIZE))
+    {
+        status |= AUDIT_TEST_CUT_WHOLE;
+    }
+
+    return status;
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] testTornRecord
+ * [Description]   After the reboot a torn record is ignored and logging
+ *                 resumes in its slot with the next sequence number.
+ *----------------------------------------------------------------------------*/
+static void testTornRecord(uint16 first_sequence, uint8 programmed_bytes)
+{
+    AUDIT_TEST_ExportType result;
+    uint16 cut_sequence = (uint16)(first_sequence + AUDIT_TEST_BEFORE_CUT);
+    pid_t child;
+    int status = 0;
+
+    EEPROM_MODEL_erase();
+    reboot();
+    logRecords(0, cut_sequence);
+
+    child = fork();
+    if (child == 0)
+    {
+        _exit(cutRecordWrite(cut_sequence, programmed_bytes));
+    }
+    waitpid(child, &status, 0);
+    HOST_CHECK(WIFEXITED(status) && !(WEXITSTATUS(status) & AUDIT_TEST_CUT_FAILED));
+
+    reboot();
+    exportAll(&result);
+    HOST_CHECK(result.complete);
+    HOST_CHECK(result.in_order);
+    HOST_CHECK(result.details_match);
+    HOST_CHECK_EQUAL(result.first_sequence, 0);
+    if (WEXITSTATUS(status) & AUDIT_TEST_CUT_WHOLE)
+    {
+        HOST_CHECK_EQUAL(result.last_sequence, cut_sequence);
+    }
+    else
+    {
+        HOST_CHECK_EQUAL(result.last_sequence, cut_sequence - 1);
+        HOST_CHECK(result.skipped <= 1);
+    }
+
+    /* The next record continues the numbering and replaces the torn one */
+    logRecords((uint16)(result.last_sequence + 1), 1);
+    reboot();
+    exportAll(&result);
+    HOST_CHECK(result.in_order);
+    HOST_CHECK(result.details_match);
+    HOST_CHECK_EQUAL(result.skipped, 0);
+    HOST_CHECK_EQUAL(result.next_cursor, (uint16)(result.last_sequence + 1));
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] testLogDuringExport
+ * [Description]   Records logged between two export steps are not sent, the
+ *                 END cursor points at the first of them. They fill the
+ *                 slots from the oldest one on, more than the first step
+ *                 read, so some of them land where the export still reads.
+ *----------------------------------------------------------------------------*/
+static void testLogDuringExport(void)
+{
+    AUDIT_TEST_ExportType result;
+
+    EEPROM_MODEL_erase();
+    reboot();
+    logRecords(0, 12);
+
+    g_capture_length = 0;
+    AUDIT_exportBegin(AUDIT_EXPORT_ALL);
+    HOST_CHECK(AUDIT_exportStep(captureByte) == TRUE);
+    logRecords(12, AUDIT_EXPORT_FRAME_RECORDS + 2);
+    while (AUDIT_exportStep(captureByte))
+    {
+    }
+
+    decodeExport(&result);
+    HOST_CHECK(result.complete);
+    HOST_CHECK(result.in_order);
+    HOST_CHECK_EQUAL(result.records, 12);
+    HOST_CHECK_EQUAL(result.last_sequence, 11);
+    HOST_CHECK_EQUAL(result.next_cursor, 12);
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] reportExportCost
+ * [Description]   Cost of the longest export step on a full ring, one EEPROM
+ *                 read and one frame at the Control ECU's 9600 baud (10 bit
+ *                 times per byte), and the number of steps.
+ *----------------------------------------------------------------------------*/
+static void reportExportCost(void)
+{
+    EEPROM_MODEL_StatsType stats;
+    uint64 step_us;
+    uint64 max_step_us = 0;
+    uint16 max_step_bytes = 0;
+    uint16 steps = 0;
+    uint16 step_start;
+    boolean more;
+
+    EEPROM_MODEL_erase();
+    reboot();
+    logRecords(0, AUDIT_RING_RECORDS);
+    EEPROM_MODEL_advanceTime(EEPROM_MODEL_WRITE_CYCLE_US);
+
+    g_capture_length = 0;
+    HOST_CHECK(AUDIT_exportBegin(AUDIT_EXPORT_ALL) == SUCCESS);
+    do
+    {
+        step_start = g_capture_length;
+        EEPROM_MODEL_resetStats();
+        more = AUDIT_exportStep(captureByte);
+        EEPROM_MODEL_getStats(&stats);
+
+        step_us = stats.bus_time_us + (((uint64)(g_capture_length - step_start) * 10 * 1000000) / AUDIT_TEST_BAUD_RATE);
+        if (step_us > max_step_us)
+        {
+            max_step_us = step_us;
+            max_step_bytes = (uint16)(g_capture_length - step_start);
+        }
+        steps++;
+    } while (more);
+
+    HOST_CHECK_EQUAL(steps, ((AUDIT_RING_RECORDS + AUDIT_EXPORT_FRAME_RECORDS - 1) / AUDIT_EXPORT_FRAME_RECORDS) + 1);
+    printf("AUDIT_exportStep: %u steps for a full ring (%u bytes), longest %llu us (%u bytes sent)\n",
+           steps, g_capture_length, (unsigned long long)max_step_us, max_step_bytes);
+}
+
+/*------------------------------------------------------------------------------
+ *  Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+    uint16 first_sequence;
+    uint8 programmed_bytes;
+
+    TWI_init(&g_twi_configuration);
+
+    testRoundTrip();
+    testDroppedCount();
+    testWrapAround();
+    testLogDuringExport();
+    reportExportCost();
+
+    /* Every record position of the first pages, cut at every byte */
+    for (first_sequence = 0; first_sequence < 8; first_sequence++)
+    {
+        for (programmed_bytes = 0; programmed_bytes <= AUDIT_RECORD_SIZE; programmed_bytes++)
+        {
+            testTornRecord(first_sequence, programmed_bytes);
+        }
+    }
+
+    return HOST_RESULT("test_audit_log");
+}
@@ -0,0 +1,285 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Credential Store Test
+ *  File        : test_credential_store.c
+ *  Description : Cuts the power at every byte of the slot write of
+ *                CREDENTIAL_save() and checks that the next boot still
+ *                loads the previous or the new password, never nothing,
+ *                from the slot CREDENTIAL_getActiveSlot() reports.
+ *                Built once per storage backend: the 24C16 model, or the
+ *                on-chip EEPROM model of avr_model.c with
+ *                -DCREDENTIAL_STORAGE_BACKEND=1
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "external_eeprom.h"
+#include "credential_store.h"
+#include "host_test.h"
+
+#if (CREDENTIAL_STORAGE_BACKEND == CREDENTIAL_BACKEND_INTERNAL)
+#include "avr_model.h"
+#include <avr/interrupt.h>
+#else
+#include "twi.h"
+#include "control_constants.h"
+#include "eeprom_model.h"
+#endif
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/* Saves in a row, so the cut hits both slots and several sequence numbers */
+#define CREDENTIAL_TEST_GENERATIONS             4
+
+#if (CREDENTIAL_STORAGE_BACKEND == CREDENTIAL_BACKEND_INTERNAL)
+#define CREDENTIAL_TEST_NAME                    "test_credential_store_internal"
+#define CREDENTIAL_TEST_BACKEND                 "internal EEPROM"
+#else
+#define CREDENTIAL_TEST_NAME                    "test_credential_store"
+#define CREDENTIAL_TEST_BACKEND                 "external 24C16"
+#endif
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+#if (CREDENTIAL_STORAGE_BACKEND == CREDENTIAL_BACKEND_EXTERNAL)
+static TWI_ConfigType g_twi_configuration = {TWI_ADDRESS, TWI_BITRATE};
+#endif
+
+/*------------------------------------------------------------------------------
+ *  Private Functions
+ *----------------------------------------------------------------------------*/
+
+/* The memory model of the backend under test */
+#if (CREDENTIAL_STORAGE_BACKEND == CREDENTIAL_BACKEND_INTERNAL)
+static void eraseMemory(void)
+{
+    AVR_MODEL_eraseEeprom();
+}
+
+static void cutPowerDuringNextWrite(uint8 programmed_bytes)
+{
+    AVR_MODEL_cutEepromPower(programmed_bytes);
+}
+
+/* Power comes back: the write in progress has ended, RAM is gone */
+static void powerUp(void)
+{
+    AVR_MODEL_advanceTime(AVR_MODEL_EEPROM_WRITE_US);
+    AVR_MODEL_restoreEepromPower();
+}
+
+static uint64 timeUs(void)
+{
+    return AVR_MODEL_getTimeUs();
+}
+#else
+static void eraseMemory(void)
+{
+    EEPROM_MODEL_erase();
+}
+
+static void cutPowerDuringNextWrite(uint8 programmed_bytes)
+{
+    EEPROM_MODEL_cutPowerDuringNextWrite(programmed_bytes);
+}
+
+static void powerUp(void)
+{
+    EEPROM_MODEL_advanceTime(EEPROM_MODEL_WRITE_CYCLE_US);
+}
+
+static uint64 timeUs(void)
+{
+    return EEPROM_MODEL_getTimeUs();
+}
+#endif
+
+static void makePassword(uint8 generation, uint8 *password)
+{
+    uint8 digit_idx;
+
+    for (digit_idx = 0; digit_idx < CREDENTIAL_PASSWORD_SIZE; digit_idx++)
+    {
+        password[digit_idx] = (uint8)((generation + digit_idx) % 10);
+    }
+}
+
+static boolean samePassword(const uint8 *first, const uint8 *second)
+{
+    uint8 digit_idx;
+
+    for (digit_idx = 0; digit_idx < CREDENTIAL_PASSWORD_SIZE; digit_idx++)
+    {
+        if (first[digit_idx] != second[digit_idx])
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] cutSave
+ * [Description]   Boots on an erased part, saves 'generation' passwords, then
+ *                 saves one more with the power cut after 'programmed_bytes'
+ *                 cells of its slot and boots again.
+ *----------------------------------------------------------------------------*/
+static void cutSave(uint8 generation, uint8 programmed_bytes)
+{
+    uint8 old_password[CREDENTIAL_PASSWORD_SIZE];
+    uint8 new_password[CREDENTIAL_PASSWORD_SIZE];
+    uint8 loaded[CREDENTIAL_PASSWORD_SIZE];
+    uint8 save_result;
+    uint8 old_slot;
+    uint8 new_slot;
+    uint8 loop_idx;
+
+    eraseMemory();
+    CREDENTIAL_init();
+    HOST_CHECK_EQUAL(CREDENTIAL_getActiveSlot(), CREDENTIAL_NO_SLOT);
+
+    /* The saves alternate between the slots, A first */
+    for (loop_idx = 0; loop_idx < generation; loop_idx++)
+    {
+        makePassword(loop_idx, old_password);
+        HOST_CHECK(CREDENTIAL_save(old_password) == SUCCESS);
+        HOST_CHECK_EQUAL(CREDENTIAL_getActiveSlot(), loop_idx % 2);
+    }
+
+    old_slot = CREDENTIAL_getActiveSlot();
+    new_slot = (old_slot == 0) ? 1 : 0;
+
+    makePassword(generation, new_password);
+    cutPowerDuringNextWrite(programmed_bytes);
+    save_result = CREDENTIAL_save(new_password);
+
+    /* Power comes back: the write cycle time has passed, RAM is gone */
+    powerUp();
+    CREDENTIAL_init();
+
+    if (CREDENTIAL_load(loaded) == ERROR)
+    {
+        /* Only allowed when there was nothing to keep */
+        HOST_CHECK_EQUAL(generation, 0);
+        HOST_CHECK(save_result == ERROR);
+        HOST_CHECK_EQUAL(CREDENTIAL_getActiveSlot(), CREDENTIAL_NO_SLOT);
+        return;
+    }
+
+    /* The cut slot is never the active one unless its record is complete */
+    HOST_CHECK_EQUAL(CREDENTIAL_getActiveSlot(), samePassword(loaded, new_password) ? new_slot : old_slot);
+
+    if (save_result == SUCCESS)
+    {
+        /* Reported saved: the new password must be the one in use */
+        HOST_CHECK(samePassword(loaded, new_password));
+    }
+    else if (generation == 0)
+    {
+        HOST_CHECK(samePassword(loaded, new_password));
+    }
+    else
+    {
+        HOST_CHECK(samePassword(loaded, old_password) || samePassword(loaded, new_password));
+    }
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] reportSaveCost
+ * [Description]   Time one save (write and read-back), one load and the boot
+ *                 scan take on the backend, with the bus cost on the 24C16.
+ *----------------------------------------------------------------------------*/
+static void reportSaveCost(void)
+{
+    uint8 password[CREDENTIAL_PASSWORD_SIZE];
+    uint64 start;
+    uint64 save_us;
+    uint64 load_us;
+    uint64 init_us;
+#if (CREDENTIAL_STORAGE_BACKEND == CREDENTIAL_BACKEND_INTERNAL)
+    uint32 writes;
+#else
+    EEPROM_MODEL_StatsType stats;
+#endif
+
+    eraseMemory();
+    makePassword(0, password);
+    CREDENTIAL_init();
+    HOST_CHECK(CREDENTIAL_save(password) == SUCCESS);
+    powerUp();
+
+#if (CREDENTIAL_STORAGE_BACKEND == CREDENTIAL_BACKEND_INTERNAL)
+    writes = AVR_MODEL_getEepromWrites();
+    start = timeUs();
+    HOST_CHECK(CREDENTIAL_save(password) == SUCCESS);
+    save_us = timeUs() - start;
+    printf("CREDENTIAL_save: %lu byte write(s), %llu us\n",
+           (unsigned long)(AVR_MODEL_getEepromWrites() - writes), (unsigned long long)save_us);
+#else
+    EEPROM_MODEL_resetStats();
+    start = timeUs();
+    HOST_CHECK(CREDENTIAL_save(password) == SUCCESS);
+    save_us = timeUs() - start;
+    EEPROM_MODEL_getStats(&stats);
+    printf("CREDENTIAL_save: %lu transactions, %lu bytes, %lu write cycle(s), %lu busy polls, %llu us of bus time\n",
+           (unsigned long)stats.transactions, (unsigned long)stats.bytes, (unsigned long)stats.write_cycles,
+           (unsigned long)stats.busy_nacks, (unsigned long long)stats.bus_time_us);
+#endif
+
+    powerUp();
+    start = timeUs();
+    HOST_CHECK(CREDENTIAL_load(password) == SUCCESS);
+    load_us = timeUs() - start;
+
+#if (CREDENTIAL_STORAGE_BACKEND == CREDENTIAL_BACKEND_EXTERNAL)
+    EEPROM_MODEL_resetStats();
+#endif
+    start = timeUs();
+    CREDENTIAL_init();
+    init_us = timeUs() - start;
+#if (CREDENTIAL_STORAGE_BACKEND == CREDENTIAL_BACKEND_EXTERNAL)
+    EEPROM_MODEL_getStats(&stats);
+    printf("CREDENTIAL_init: %lu transactions, %lu bytes, %llu us of bus time\n",
+           (unsigned long)stats.transactions, (unsigned long)stats.bytes, (unsigned long long)stats.bus_time_us);
+#endif
+
+    printf("%s latency: save %llu us, load %llu us, boot scan %llu us\n", CREDENTIAL_TEST_BACKEND,
+           (unsigned long long)save_us, (unsigned long long)load_us, (unsigned long long)init_us);
+}
+
+/*------------------------------------------------------------------------------
+ *  Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+    uint8 generation;
+    uint8 programmed_bytes;
+
+#if (CREDENTIAL_STORAGE_BACKEND == CREDENTIAL_BACKEND_INTERNAL)
+    /* The EE_RDY interrupt programs the bytes after the first */
+    sei();
+#else
+    TWI_init(&g_twi_configuration);
+#endif
+
+    /* 0 to CREDENTIAL_RECORD_SIZE cells of the slot page reach the memory */
+    for (generation = 0; generation <= CREDENTIAL_TEST_GENERATIONS; generation++)
+    {
+        for (programmed_bytes = 0; programmed_bytes <= CREDENTIAL_RECORD_SIZE; programmed_bytes++)
+        {
+            cutSave(generation, programmed_bytes);
+        }
+    }
+
+    reportSaveCost();
+
+    return HOST_RESULT(CREDENTIAL_TEST_NAME);
+}
@@ -0,0 +1,294 @@
+/*------------------------------------------------------------------------------
+ *  Module      : 24Cxx EEPROM Model Test
+ *  File        : test_eeprom_model.c
+ *  Description : Checks the 24C16 model against the datasheet behaviour the
+ *                EEPROM code relies on: page wrap-around, block select bits,
+ *                NACK during the write cycle (and the driver waiting it
+ *                out), sequential read roll-over, wear counters, power cut
+ *                injection, bus time and contents persisting in the
+ *                backing file
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "twi.h"
+#include "external_eeprom.h"
+#include "control_constants.h"
+#include "eeprom_model.h"
+#include "host_test.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/* Device address of block 0 for a write, the block number goes in bits 3..1 */
+#define MODEL_TEST_DEVICE_WRITE                 0xA0
+
+/* Written by a child process, read back through a fresh mapping */
+#define MODEL_TEST_PERSIST_ADDRESS              0x07F0
+#define MODEL_TEST_PERSIST_VALUE                0x5A
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+/* Same configuration as the Control ECU: 31.25 kHz SCL at 8 MHz */
+static TWI_ConfigType g_twi_configuration = {TWI_ADDRESS, TWI_BITRATE};
+
+/*------------------------------------------------------------------------------
+ *  Private Functions
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] rawPageWrite
+ * [Description]   Page write sent byte by byte on the bus, without the
+ *                 driver's page boundary handling.
+ *----------------------------------------------------------------------------*/
+static void rawPageWrite(uint8 block, uint8 word_address, const uint8 *data, uint8 length)
+{
+    uint8 byte_idx;
+
+    TWI_start();
+    TWI_writeByte((uint8)(MODEL_TEST_DEVICE_WRITE | (block << 1)));
+    TWI_writeByte(word_address);
+    for (byte_idx = 0; byte_idx < length; byte_idx++)
+    {
+        TWI_writeByte(data[byte_idx]);
+    }
+    TWI_stop();
+}
+
+static void waitWriteCycle(void)
+{
+    EEPROM_MODEL_advanceTime(EEPROM_MODEL_WRITE_CYCLE_US);
+}
+
+static void testPersistence(void)
+{
+    pid_t child = fork();
+    int status = 0;
+
+    if (child == 0)
+    {
+        /* Separate process: erase the part and leave one byte behind */
+        uint8 value = MODEL_TEST_PERSIST_VALUE;
+
+        EEPROM_MODEL_erase();
+        exit(EEPROM_writePage(MODEL_TEST_PERSIST_ADDRESS, &value, 1) == SUCCESS ? 0 : 1);
+    }
+
+    waitpid(child, &status, 0);
+    HOST_CHECK(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+
+    /* First access of this process: the model maps the file again */
+    HOST_CHECK_EQUAL(EEPROM_MODEL_peek(MODEL_TEST_PERSIST_ADDRESS), MODEL_TEST_PERSIST_VALUE);
+    HOST_CHECK_EQUAL(EEPROM_MODEL_getWear(MODEL_TEST_PERSIST_ADDRESS), 1);
+}
+
+static void testPageWrap(void)
+{
+    uint8 data[EEPROM_MODEL_PAGE_SIZE];
+    uint8 byte_idx;
+
+    for (byte_idx = 0; byte_idx < EEPROM_MODEL_PAGE_SIZE; byte_idx++)
+    {
+        data[byte_idx] = byte_idx;
+    }
+
+    /* 16 bytes from the middle of page 0x0020: the second half wraps to its start */
+    EEPROM_MODEL_erase();
+    rawPageWrite(0, 0x28, data, EEPROM_MODEL_PAGE_SIZE);
+    waitWriteCycle();
+
+    for (byte_idx = 0; byte_idx < 8; byte_idx++)
+    {
+        HOST_CHECK_EQUAL(EEPROM_MODEL_peek(0x0028 + byte_idx), byte_idx);
+        HOST_CHECK_EQUAL(EEPROM_MODEL_peek(0x0020 + byte_idx), byte_idx + 8);
+    }
+    HOST_CHECK_EQUAL(EEPROM_MODEL_peek(0x0030), 0xFF);
+    HOST_CHECK_EQUAL(EEPROM_MODEL_peek(0x001F), 0xFF);
+}
+
+static void testBlockSelect(void)
+{
+    uint8 value = 0xC3;
+    uint8 read_value = 0;
+
+    EEPROM_MODEL_erase();
+    rawPageWrite(5, 0x10, &value, 1);
+    waitWriteCycle();
+
+    HOST_CHECK_EQUAL(EEPROM_MODEL_peek(0x0510), 0xC3);
+    HOST_CHECK_EQUAL(EEPROM_MODEL_peek(0x0010), 0xFF);
+
+    /* The driver puts A10..A8 in the device address the same way */
+    HOST_CHECK(EEPROM_readByte(0x0510, &read_value) == SUCCESS);
+    HOST_CHECK_EQUAL(read_value, 0xC3);
+}
+
+static void testBusyNack(void)
+{
+    EEPROM_MODEL_StatsType stats;
+    uint8 value = 0x11;
+
+    EEPROM_MODEL_erase();
+    rawPageWrite(0, 0x00, &value, 1);
+
+    /* Write cycle running: the device address is not acknowledged */
+    EEPROM_MODEL_resetStats();
+    TWI_start();
+    TWI_writeByte(MODEL_TEST_DEVICE_WRITE);
+    HOST_CHECK_EQUAL(TWI_getStatus(), TWI_MT_SLA_W_NACK);
+    TWI_stop();
+    HOST_CHECK(EEPROM_isReady() == FALSE);
+
+    EEPROM_MODEL_getStats(&stats);
+    HOST_CHECK_EQUAL(stats.busy_nacks, 2);
+
+    waitWriteCycle();
+    TWI_start();
+    TWI_writeByte(MODEL_TEST_DEVICE_WRITE);
+    HOST_CHECK_EQUAL(TWI_getStatus(), TWI_MT_SLA_W_ACK);
+    TWI_stop();
+    HOST_CHECK(EEPROM_isReady() == TRUE);
+}
+
+static void testWaitReady(void)
+{
+    EEPROM_MODEL_StatsType stats;
+    uint8 value = 0x22;
+    uint64 start;
+
+    /* The driver polls on its own until the write cycle is over */
+    EEPROM_MODEL_erase();
+    rawPageWrite(0, 0x01, &value, 1);
+    start = EEPROM_MODEL_getTimeUs();
+    EEPROM_MODEL_resetStats();
+    HOST_CHECK(EEPROM_waitReady() == SUCCESS);
+    EEPROM_MODEL_getStats(&stats);
+    HOST_CHECK(EEPROM_MODEL_getTimeUs() - start >= EEPROM_MODEL_WRITE_CYCLE_US);
+    HOST_CHECK(stats.busy_nacks > 0);
+    HOST_CHECK(EEPROM_isReady() == TRUE);
+
+    /* Idle memory: a single acknowledged poll */
+    EEPROM_MODEL_resetStats();
+    HOST_CHECK(EEPROM_waitReady() == SUCCESS);
+    EEPROM_MODEL_getStats(&stats);
+    HOST_CHECK_EQUAL(stats.transactions, 1);
+    HOST_CHECK_EQUAL(stats.busy_nacks, 0);
+
+    /* A memory that never answers is given up on */
+    EEPROM_MODEL_setAbsent(TRUE);
+    HOST_CHECK(EEPROM_waitReady() == ERROR);
+    EEPROM_MODEL_setAbsent(FALSE);
+}
+
+static void testSequentialRollover(void)
+{
+    uint8 last = 0x7E;
+    uint8 first = 0xE7;
+    uint8 data[2] = {0, 0};
+
+    EEPROM_MODEL_erase();
+    HOST_CHECK(EEPROM_writePage(EEPROM_SIZE - 1, &last, 1) == SUCCESS);
+    HOST_CHECK(EEPROM_writePage(0x0000, &first, 1) == SUCCESS);
+
+    /* A sequential read past the last cell continues at address 0 */
+    HOST_CHECK(EEPROM_readBlock(EEPROM_SIZE - 1, data, 2) == SUCCESS);
+    HOST_CHECK_EQUAL(data[0], 0x7E);
+    HOST_CHECK_EQUAL(data[1], 0xE7);
+}
+
+static void testWear(void)
+{
+    uint8 data[4] = {1, 2, 3, 4};
+    uint32 before_first = EEPROM_MODEL_getWear(0x0100);
+    uint32 before_next = EEPROM_MODEL_getWear(0x0104);
+
+    HOST_CHECK(EEPROM_writePage(0x0100, data, 4) == SUCCESS);
+    HOST_CHECK(EEPROM_writePage(0x0100, data, 4) == SUCCESS);
+
+    /* Only the latched cells are programmed */
+    HOST_CHECK_EQUAL(EEPROM_MODEL_getWear(0x0100) - before_first, 2);
+    HOST_CHECK_EQUAL(EEPROM_MODEL_getWear(0x0103) - before_first, 2);
+    HOST_CHECK_EQUAL(EEPROM_MODEL_getWear(0x0104) - before_next, 0);
+}
+
+static void testPowerCut(void)
+{
+    uint8 data[8] = {10, 11, 12, 13, 14, 15, 16, 17};
+    uint8 read_back[8];
+    uint8 byte_idx;
+    uint8 intact = 0;
+
+    EEPROM_MODEL_erase();
+    EEPROM_MODEL_cutPowerDuringNextWrite(3);
+    HOST_CHECK(EEPROM_writePage(0x0200, data, 8) == SUCCESS);
+    HOST_CHECK(EEPROM_readBlock(0x0200, read_back, 8) == SUCCESS);
+
+    for (byte_idx = 0; byte_idx < 8; byte_idx++)
+    {
+        if (read_back[byte_idx] == data[byte_idx])
+        {
+            intact++;
+        }
+    }
+    HOST_CHECK_EQUAL(read_back[0], 10);
+    HOST_CHECK_EQUAL(read_back[2], 12);
+    HOST_CHECK(intact < 8);
+
+    /* The injection only applies to one write cycle */
+    HOST_CHECK(EEPROM_writePage(0x0200, data, 8) == SUCCESS);
+    HOST_CHECK(EEPROM_readBlock(0x0200, read_back, 8) == SUCCESS);
+    HOST_CHECK_EQUAL(read_back[7], 17);
+}
+
+static void testBusTime(void)
+{
+    EEPROM_MODEL_StatsType stats;
+    uint8 value;
+
+    waitWriteCycle();
+    EEPROM_MODEL_resetStats();
+    HOST_CHECK(EEPROM_readByte(0x0123, &value) == SUCCESS);
+    EEPROM_MODEL_getStats(&stats);
+
+    /* START, SLA+W, word address, repeated START, SLA+R, data, STOP */
+    HOST_CHECK_EQUAL(stats.transactions, 1);
+    HOST_CHECK_EQUAL(stats.repeated_starts, 1);
+    HOST_CHECK_EQUAL(stats.bytes, 4);
+    HOST_CHECK_EQUAL(stats.nacks, 0);
+
+    /* 4 x 9 + 3 SCL periods of 32 us at 31.25 kHz */
+    HOST_CHECK_EQUAL(stats.bus_time_us, 39 * 32);
+}
+
+/*------------------------------------------------------------------------------
+ *  Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+    /* Before anything maps the file in this process */
+    testPersistence();
+
+    TWI_init(&g_twi_configuration);
+
+    testPageWrap();
+    testBlockSelect();
+    testBusyNack();
+    testWaitReady();
+    testSequentialRollover();
+    testWear();
+    testPowerCut();
+    testBusTime();
+
+    return HOST_RESULT("test_eeprom_model");
+}
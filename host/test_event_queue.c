@@ -0,0 +1,210 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Event Queue Stress Test
+ *  File        : test_event_queue.c
+ *  Description : Posts bursts of events from a SIGALRM handler standing in
+ *                for the interrupts while the main program drains the queue,
+ *                so posts land in the middle of EVENT_QUEUE_get(). Checks
+ *                that every accepted event comes out once, whole and in
+ *                order, and that the dropped count matches the refused posts
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "event_queue.h"
+#include "sw_timer.h"
+#include "host_test.h"
+
+#include <signal.h>
+#include <time.h>
+#include <sys/time.h>
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/* Interrupt period and length of each run */
+#define STRESS_INTERRUPT_PERIOD_US              20
+#define STRESS_RUN_MS                           500
+
+/* Events posted by one interrupt: 1 to STRESS_MAX_BURST */
+#define STRESS_MAX_BURST                        8
+
+/* Work done per event by the slow consumer, the queue then overflows */
+#define STRESS_SLOW_CONSUMER_LOOPS              20000
+
+/*------------------------------------------------------------------------------
+ *  Data Types Declarations
+ *----------------------------------------------------------------------------*/
+
+typedef struct
+{
+    uint32 interrupts;
+    uint32 posted;
+    uint32 refused;
+    uint32 consumed;
+    uint32 wrong;           /* Events not equal to the next one posted */
+    uint16 dropped;         /* EVENT_QUEUE_getDroppedCount() at the end */
+} STRESS_ResultType;
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+/* Producer side, only changed by the handler */
+static volatile uint32 g_sequence = 0;
+static volatile uint32 g_interrupts = 0;
+static volatile uint32 g_refused = 0;
+static volatile uint32 g_random = 1;
+
+/*------------------------------------------------------------------------------
+ *  Private Functions
+ *----------------------------------------------------------------------------*/
+
+/* Time stamp of a posted event: its sequence number */
+uint32 SW_TIMER_micros(void)
+{
+    return g_sequence;
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] interruptHandler
+ * [Description]   The interrupts: each event carries its sequence number in
+ *                 its id, data and time stamp. A refused event keeps its
+ *                 number for the next post.
+ *----------------------------------------------------------------------------*/
+static void interruptHandler(int signal_number)
+{
+    uint8 burst;
+
+    (void)signal_number;
+
+    g_interrupts++;
+    g_random = (g_random * 1103515245UL) + 12345UL;
+    burst = (uint8)(1 + ((g_random >> 16) % STRESS_MAX_BURST));
+
+    while (burst-- > 0)
+    {
+        if (EVENT_QUEUE_post((uint8)(g_sequence % EVENT_TYPES), (uint8)(g_sequence / EVENT_TYPES)))
+        {
+            g_sequence++;
+        }
+        else
+        {
+            g_refused++;
+        }
+    }
+}
+
+static void setInterruptPeriod(uint32 period_us)
+{
+    struct itimerval timer = {{0, (long)period_us}, {0, (long)period_us}};
+
+    setitimer(ITIMER_REAL, &timer, NULL);
+}
+
+static uint64 elapsedMs(const struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64)((now.tv_sec - start->tv_sec) * 1000) + (uint64)((now.tv_nsec - start->tv_nsec) / 1000000);
+}
+
+static boolean isExpected(const EVENT_Type *event, uint32 sequence)
+{
+    return (boolean)((event->id == (uint8)(sequence % EVENT_TYPES)) &&
+                     (event->data == (uint8)(sequence / EVENT_TYPES)) &&
+                     (event->time_us == sequence));
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] runStress
+ * [Description]   Drains the queue for STRESS_RUN_MS while the interrupts
+ *                 post, 'work_loops' of busy work per event, then stops the
+ *                 interrupts and drains what is left.
+ *----------------------------------------------------------------------------*/
+static void runStress(uint32 work_loops, STRESS_ResultType *result)
+{
+    struct timespec start;
+    EVENT_Type event;
+    uint32 expected = 0;
+    volatile uint32 work;
+
+    EVENT_QUEUE_init();
+    g_sequence = 0;
+    g_interrupts = 0;
+    g_refused = 0;
+    result->consumed = 0;
+    result->wrong = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    setInterruptPeriod(STRESS_INTERRUPT_PERIOD_US);
+
+    while (elapsedMs(&start) < STRESS_RUN_MS)
+    {
+        if (!EVENT_QUEUE_get(&event))
+        {
+            continue;
+        }
+
+        result->wrong += !isExpected(&event, expected);
+        expected++;
+        result->consumed++;
+
+        for (work = 0; work < work_loops; work++)
+        {
+        }
+    }
+
+    setInterruptPeriod(0);
+    while (EVENT_QUEUE_get(&event))
+    {
+        result->wrong += !isExpected(&event, expected);
+        expected++;
+        result->consumed++;
+    }
+
+    result->interrupts = g_interrupts;
+    result->posted = g_sequence;
+    result->refused = g_refused;
+    result->dropped = EVENT_QUEUE_getDroppedCount();
+}
+
+static void checkResult(const char *name, const STRESS_ResultType *result)
+{
+    printf("%s: %lu interrupts, %lu events posted, %lu refused, %lu consumed, %lu wrong, dropped count %u\n",
+           name, (unsigned long)result->interrupts, (unsigned long)result->posted, (unsigned long)result->refused,
+           (unsigned long)result->consumed, (unsigned long)result->wrong, result->dropped);
+
+    HOST_CHECK(result->interrupts > 0);
+    HOST_CHECK_EQUAL(result->wrong, 0);
+    HOST_CHECK_EQUAL(result->consumed, result->posted);
+    HOST_CHECK_EQUAL(result->dropped, (result->refused > 0xFFFF) ? 0xFFFF : result->refused);
+}
+
+/*------------------------------------------------------------------------------
+ *  Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+    struct sigaction action = {0};
+    STRESS_ResultType result;
+
+    action.sa_handler = interruptHandler;
+    sigaction(SIGALRM, &action, NULL);
+
+    /* Posts interrupt the consumer at every point of EVENT_QUEUE_get() */
+    runStress(0, &result);
+    checkResult("fast consumer", &result);
+
+    /* The queue stays full, posts are refused while slots are released */
+    runStress(STRESS_SLOW_CONSUMER_LOOPS, &result);
+    checkResult("slow consumer", &result);
+    HOST_CHECK(result.refused > 0);
+
+    return HOST_RESULT("test_event_queue");
+}
@@ -0,0 +1,396 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Keypad Scan Test
+ *  File        : test_keypad.c
+ *  Description : Runs the HMI keypad scan against a model of the diode-less
+ *                4x4 matrix behind PINB: every button, contact bounce,
+ *                rollover of overlapping keys and every rectangle with three
+ *                pressed corners, where the fourth one reads pressed too.
+ *                Checks the events, their order and that no ghost key is
+ *                ever reported
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "keypad.h"
+#include "sw_timer.h"
+#include "avr_model.h"
+#include "host_test.h"
+
+#include <stddef.h>
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/* Events kept by one test step */
+#define KEYPAD_TEST_MAX_EVENTS                  32
+
+/* Long enough for any change to be debounced */
+#define KEYPAD_TEST_SETTLE_MS                   20
+
+/* Button of a row and column, as numbered by the scan (bit of the bitmap) */
+#define KEYPAD_TEST_BUTTON(row, col)            (uint8)(((row) * KEYPAD_NUM_COLS) + (col))
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+/* Key reported for each button, the 4x4 layout of the Proteus keypad */
+static const uint8 g_layout[KEYPAD_BUTTONS] =
+{
+    7, 8, 9, '%',
+    4, 5, 6, '*',
+    1, 2, 3, '-',
+    '^', 0, 13, '+'
+};
+
+/* Closed switches, bit n for button n */
+static uint16 g_contacts = 0;
+
+/* Scan timer registered by KEYPAD_init */
+static void (*g_scan_callback)(void *) = NULL;
+static uint32 g_now_ms = 0;
+
+static KEYPAD_EventType g_events[KEYPAD_TEST_MAX_EVENTS];
+static uint8 g_event_count = 0;
+
+/*------------------------------------------------------------------------------
+ *  Software Timer Stand-ins
+ *----------------------------------------------------------------------------*/
+
+uint32 SW_TIMER_millis(void)
+{
+    return g_now_ms;
+}
+
+SW_TIMER_IdType SW_TIMER_start(uint32 milliseconds, SW_TIMER_ModeType mode,
+                               void (*a_callback)(void *), void *a_context)
+{
+    (void)milliseconds;
+    (void)mode;
+    (void)a_context;
+
+    g_scan_callback = a_callback;
+    return 0;
+}
+
+/*------------------------------------------------------------------------------
+ *  Private Functions
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] readKeypadPins
+ * [Description]   PINB of the matrix: rows on PB0..PB3, columns on PB4..PB7
+ *                 pulled high. A row driven low pulls down the columns of its
+ *                 closed switches, and without diodes every row and column
+ *                 those reach through other closed switches.
+ *----------------------------------------------------------------------------*/
+static uint8 readKeypadPins(void)
+{
+    uint8 low_rows = (uint8)(DDRB & (uint8)~PORTB & 0x0F);
+    uint8 low_cols = 0;
+    boolean grown;
+    uint8 row;
+    uint8 col;
+
+    do
+    {
+        grown = FALSE;
+        for (row = 0; row < KEYPAD_NUM_ROWS; row++)
+        {
+            for (col = 0; col < KEYPAD_NUM_COLS; col++)
+            {
+                if (!(g_contacts & (1 << KEYPAD_TEST_BUTTON(row, col))))
+                {
+                    continue;
+                }
+                if ((low_rows & (1 << row)) && !(low_cols & (1 << col)))
+                {
+                    low_cols |= (uint8)(1 << col);
+                    grown = TRUE;
+                }
+                if ((low_cols & (1 << col)) && !(low_rows & (1 << row)))
+                {
+                    low_rows |= (uint8)(1 << row);
+                    grown = TRUE;
+                }
+            }
+        }
+    } while (grown);
+
+    return (uint8)((0xF0 & (uint8)~(low_cols << 4)) | (uint8)(0x0F & (uint8)~low_rows));
+}
+
+/* Lets time pass, one scan every KEYPAD_SCAN_PERIOD_MS, and keeps the events */
+static void runMs(uint32 milliseconds)
+{
+    KEYPAD_EventType event;
+
+    while (milliseconds-- > 0)
+    {
+        g_now_ms++;
+        if ((g_now_ms % KEYPAD_SCAN_PERIOD_MS) == 0)
+        {
+            g_scan_callback(NULL);
+        }
+
+        while (KEYPAD_getEvent(&event))
+        {
+            if (g_event_count < KEYPAD_TEST_MAX_EVENTS)
+            {
+                g_events[g_event_count++] = event;
+            }
+        }
+    }
+}
+
+/* Starts a step on a scan boundary with no key down */
+static void startStep(void)
+{
+    g_contacts = 0;
+    runMs(KEYPAD_TEST_SETTLE_MS);
+    runMs(KEYPAD_SCAN_PERIOD_MS - (g_now_ms % KEYPAD_SCAN_PERIOD_MS));
+    g_event_count = 0;
+}
+
+static void checkEvent(uint8 index, uint8 button, KEYPAD_EventKindType kind)
+{
+    HOST_CHECK(index < g_event_count);
+    if (index < g_event_count)
+    {
+        HOST_CHECK_EQUAL(g_events[index].key, g_layout[button]);
+        HOST_CHECK_EQUAL(g_events[index].kind, kind);
+    }
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] testEveryButton
+ * [Description]   One press and one release per button, stamped with the
+ *                 time of the first scan that saw the contact change.
+ *----------------------------------------------------------------------------*/
+static void testEveryButton(void)
+{
+    uint8 button;
+    uint32 pressed_ms;
+    uint32 released_ms;
+
+    for (button = 0; button < KEYPAD_BUTTONS; button++)
+    {
+        startStep();
+
+        /* Closed just before the next scan */
+        pressed_ms = g_now_ms + KEYPAD_SCAN_PERIOD_MS;
+        g_contacts = (uint16)(1 << button);
+        runMs(KEYPAD_TEST_SETTLE_MS);
+        released_ms = g_now_ms + KEYPAD_SCAN_PERIOD_MS;
+        g_contacts = 0;
+        runMs(KEYPAD_TEST_SETTLE_MS);
+
+        HOST_CHECK_EQUAL(g_event_count, 2);
+        checkEvent(0, button, KEYPAD_EVENT_PRESS);
+        checkEvent(1, button, KEYPAD_EVENT_RELEASE);
+        HOST_CHECK_EQUAL(g_events[0].time_ms, pressed_ms);
+        HOST_CHECK_EQUAL(g_events[1].time_ms, released_ms);
+    }
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] testBounce
+ * [Description]   Contact chatter shorter than the debounce time on press
+ *                 and release gives a single press and a single release.
+ *----------------------------------------------------------------------------*/
+static void testBounce(void)
+{
+    uint8 bounce_idx;
+    const uint16 button_mask = (uint16)(1 << KEYPAD_TEST_BUTTON(2, 1));
+
+    startStep();
+
+    for (bounce_idx = 0; bounce_idx < 3; bounce_idx++)
+    {
+        g_contacts ^= button_mask;
+        runMs(1);
+        g_contacts ^= button_mask;
+        runMs(2);
+    }
+    g_contacts = button_mask;
+    runMs(KEYPAD_TEST_SETTLE_MS);
+
+    for (bounce_idx = 0; bounce_idx < 3; bounce_idx++)
+    {
+        g_contacts ^= button_mask;
+        runMs(3);
+    }
+    g_contacts = 0;
+    runMs(KEYPAD_TEST_SETTLE_MS);
+
+    HOST_CHECK_EQUAL(g_event_count, 2);
+    checkEvent(0, KEYPAD_TEST_BUTTON(2, 1), KEYPAD_EVENT_PRESS);
+    checkEvent(1, KEYPAD_TEST_BUTTON(2, 1), KEYPAD_EVENT_RELEASE);
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] testRollover
+ * [Description]   Keys pressed before the previous one is released, without
+ *                 forming a rectangle: every key comes out, in the order of
+ *                 the contact changes.
+ *----------------------------------------------------------------------------*/
+static void testRollover(const uint8 *buttons, uint8 count)
+{
+    uint8 key_idx;
+
+    startStep();
+
+    for (key_idx = 0; key_idx < count; key_idx++)
+    {
+        g_contacts |= (uint16)(1 << buttons[key_idx]);
+        runMs(KEYPAD_TEST_SETTLE_MS);
+    }
+    for (key_idx = 0; key_idx < count; key_idx++)
+    {
+        g_contacts &= (uint16)~(1 << buttons[key_idx]);
+        runMs(KEYPAD_TEST_SETTLE_MS);
+    }
+
+    HOST_CHECK_EQUAL(g_event_count, 2 * count);
+    for (key_idx = 0; key_idx < count; key_idx++)
+    {
+        checkEvent(key_idx, buttons[key_idx], KEYPAD_EVENT_PRESS);
+        checkEvent((uint8)(count + key_idx), buttons[key_idx], KEYPAD_EVENT_RELEASE);
+    }
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] testTogether
+ * [Description]   Contacts closing between the same two scans come out in
+ *                 button order.
+ *----------------------------------------------------------------------------*/
+static void testTogether(void)
+{
+    startStep();
+
+    g_contacts = (uint16)((1 << KEYPAD_TEST_BUTTON(3, 2)) | (1 << KEYPAD_TEST_BUTTON(0, 1)));
+    runMs(KEYPAD_TEST_SETTLE_MS);
+    g_contacts = 0;
+    runMs(KEYPAD_TEST_SETTLE_MS);
+
+    HOST_CHECK_EQUAL(g_event_count, 4);
+    checkEvent(0, KEYPAD_TEST_BUTTON(0, 1), KEYPAD_EVENT_PRESS);
+    checkEvent(1, KEYPAD_TEST_BUTTON(3, 2), KEYPAD_EVENT_PRESS);
+    checkEvent(2, KEYPAD_TEST_BUTTON(0, 1), KEYPAD_EVENT_RELEASE);
+    checkEvent(3, KEYPAD_TEST_BUTTON(3, 2), KEYPAD_EVENT_RELEASE);
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] testThreeCorners
+ * [Description]   Three corners of a rectangle pressed one after the other,
+ *                 the fourth ('ghost') reads pressed while they are held.
+ *                 The first two keys come out, the third is held back until
+ *                 the first one is released, the ghost never comes out.
+ *----------------------------------------------------------------------------*/
+static void testThreeCorners(uint8 first_row, uint8 second_row, uint8 first_col, uint8 second_col, uint8 ghost)
+{
+    uint8 corners[4];
+    uint8 pressed[3];
+    uint8 count = 0;
+    uint8 corner_idx;
+    uint8 event_idx;
+    uint8 released;
+    uint8 held_back;
+
+    corners[0] = KEYPAD_TEST_BUTTON(first_row, first_col);
+    corners[1] = KEYPAD_TEST_BUTTON(first_row, second_col);
+    corners[2] = KEYPAD_TEST_BUTTON(second_row, first_col);
+    corners[3] = KEYPAD_TEST_BUTTON(second_row, second_col);
+    for (corner_idx = 0; corner_idx < 4; corner_idx++)
+    {
+        if (corner_idx != ghost)
+        {
+            pressed[count++] = corners[corner_idx];
+        }
+    }
+
+    startStep();
+
+    for (corner_idx = 0; corner_idx < 3; corner_idx++)
+    {
+        g_contacts |= (uint16)(1 << pressed[corner_idx]);
+        runMs(KEYPAD_TEST_SETTLE_MS);
+    }
+    runMs(10 * KEYPAD_TEST_SETTLE_MS);
+
+    /* The rectangle is on the matrix: only the first two keys */
+    HOST_CHECK_EQUAL(g_event_count, 2);
+    checkEvent(0, pressed[0], KEYPAD_EVENT_PRESS);
+    checkEvent(1, pressed[1], KEYPAD_EVENT_PRESS);
+
+    /* Breaking it lets the third key through, on the same scan as the release */
+    g_contacts &= (uint16)~(1 << pressed[0]);
+    runMs(KEYPAD_TEST_SETTLE_MS);
+    HOST_CHECK_EQUAL(g_event_count, 4);
+    released = (pressed[0] < pressed[2]) ? 2 : 3;
+    held_back = (pressed[0] < pressed[2]) ? 3 : 2;
+    checkEvent(released, pressed[0], KEYPAD_EVENT_RELEASE);
+    checkEvent(held_back, pressed[2], KEYPAD_EVENT_PRESS);
+
+    g_contacts = 0;
+    runMs(KEYPAD_TEST_SETTLE_MS);
+    HOST_CHECK_EQUAL(g_event_count, 6);
+
+    for (event_idx = 0; event_idx < g_event_count; event_idx++)
+    {
+        HOST_CHECK(g_events[event_idx].key != g_layout[corners[ghost]]);
+    }
+}
+
+/*------------------------------------------------------------------------------
+ *  Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+    static const uint8 diagonal[3] = {KEYPAD_TEST_BUTTON(0, 0), KEYPAD_TEST_BUTTON(1, 1), KEYPAD_TEST_BUTTON(2, 2)};
+    static const uint8 one_row[4] = {KEYPAD_TEST_BUTTON(1, 3), KEYPAD_TEST_BUTTON(1, 0), KEYPAD_TEST_BUTTON(1, 2),
+                                     KEYPAD_TEST_BUTTON(1, 1)};
+    static const uint8 one_column[3] = {KEYPAD_TEST_BUTTON(3, 2), KEYPAD_TEST_BUTTON(0, 2), KEYPAD_TEST_BUTTON(2, 2)};
+    uint8 first_row;
+    uint8 second_row;
+    uint8 first_col;
+    uint8 second_col;
+    uint8 ghost;
+
+    AVR_MODEL_setPinReader(AVR_MODEL_PORT_B, readKeypadPins);
+    KEYPAD_init();
+    HOST_CHECK(g_scan_callback != NULL);
+
+    testEveryButton();
+    testBounce();
+    testTogether();
+    testRollover(diagonal, 3);
+    testRollover(one_row, 4);
+    testRollover(one_column, 3);
+
+    /* Any two keys on a row and a third under one of them: every rectangle
+     * of the matrix, each corner in turn left unpressed */
+    for (first_row = 0; first_row < KEYPAD_NUM_ROWS; first_row++)
+    {
+        for (second_row = (uint8)(first_row + 1); second_row < KEYPAD_NUM_ROWS; second_row++)
+        {
+            for (first_col = 0; first_col < KEYPAD_NUM_COLS; first_col++)
+            {
+                for (second_col = (uint8)(first_col + 1); second_col < KEYPAD_NUM_COLS; second_col++)
+                {
+                    for (ghost = 0; ghost < 4; ghost++)
+                    {
+                        testThreeCorners(first_row, second_row, first_col, second_col, ghost);
+                    }
+                }
+            }
+        }
+    }
+
+    return HOST_RESULT("test_keypad");
+}
@@ -0,0 +1,200 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Lockout Counter Test
+ *  File        : test_lockout_counter.c
+ *  Description : Checks on the 24C16 model that the failed-attempt count
+ *                survives a reboot, that a reset is stored before it returns
+ *                (power cut right after a good login) and that the counter
+ *                keeps working once its area has been used up and erased,
+ *                also after the memory could not be read or erased
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "twi.h"
+#include "external_eeprom.h"
+#include "lockout_counter.h"
+#include "eeprom_queue.h"
+#include "audit_log.h"
+#include "control_constants.h"
+#include "eeprom_model.h"
+#include "host_test.h"
+
+#include <unistd.h>
+#include <sys/wait.h>
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/* Unused pages between the credential slots and the user table */
+#define LOCKOUT_TEST_FILLER_ADDRESS             0x0340
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+static TWI_ConfigType g_twi_configuration = {TWI_ADDRESS, TWI_BITRATE};
+
+/*------------------------------------------------------------------------------
+ *  Private Functions
+ *----------------------------------------------------------------------------*/
+
+/* Power cycle: only what reached the memory is left */
+static void reboot(void)
+{
+    EEPROM_MODEL_advanceTime(EEPROM_MODEL_WRITE_CYCLE_US);
+    LOCKOUT_init();
+}
+
+static void testFailuresPersist(void)
+{
+    uint8 failure_idx;
+
+    EEPROM_MODEL_erase();
+    reboot();
+    HOST_CHECK_EQUAL(LOCKOUT_getFailures(), 0);
+
+    for (failure_idx = 0; failure_idx < LOCKOUT_MAX_FAILURES; failure_idx++)
+    {
+        HOST_CHECK(LOCKOUT_recordFailure() == SUCCESS);
+    }
+
+    reboot();
+    HOST_CHECK_EQUAL(LOCKOUT_getFailures(), LOCKOUT_MAX_FAILURES);
+    HOST_CHECK(LOCKOUT_isLocked() == TRUE);
+}
+
+static void testResetSurvivesPowerCut(void)
+{
+    pid_t child;
+    int status = 0;
+
+    EEPROM_MODEL_erase();
+    reboot();
+    HOST_CHECK(LOCKOUT_recordFailure() == SUCCESS);
+    HOST_CHECK(LOCKOUT_recordFailure() == SUCCESS);
+
+    /* The good login: the child's exit is the power cut right after it */
+    child = fork();
+    if (child == 0)
+    {
+        _exit((LOCKOUT_reset() == SUCCESS) ? 0 : 1);
+    }
+    waitpid(child, &status, 0);
+    HOST_CHECK(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+
+    reboot();
+    HOST_CHECK_EQUAL(LOCKOUT_getFailures(), 0);
+    HOST_CHECK(LOCKOUT_isLocked() == FALSE);
+}
+
+static void testAreaReuse(void)
+{
+    uint8 cycle_idx;
+
+    EEPROM_MODEL_erase();
+    reboot();
+
+    /* One byte retired per reset, more resets than the area has bytes */
+    for (cycle_idx = 0; cycle_idx < (LOCKOUT_AREA_SIZE + 6); cycle_idx++)
+    {
+        HOST_CHECK(LOCKOUT_recordFailure() == SUCCESS);
+        HOST_CHECK(LOCKOUT_reset() == SUCCESS);
+    }
+
+    reboot();
+    HOST_CHECK_EQUAL(LOCKOUT_getFailures(), 0);
+
+    HOST_CHECK(LOCKOUT_recordFailure() == SUCCESS);
+    reboot();
+    HOST_CHECK_EQUAL(LOCKOUT_getFailures(), 1);
+}
+
+/* An unreadable counter at boot owes a lockdown, the reset after it must stay in the area */
+static void testResetAfterReadError(void)
+{
+    EEPROM_MODEL_erase();
+    reboot();
+
+    EEPROM_MODEL_setAbsent(TRUE);
+    LOCKOUT_init();
+    EEPROM_MODEL_setAbsent(FALSE);
+    HOST_CHECK(LOCKOUT_isLocked() == TRUE);
+
+    HOST_CHECK(LOCKOUT_reset() == SUCCESS);
+    HOST_CHECK_EQUAL(EEPROM_MODEL_peek(AUDIT_RING_BASE_ADDRESS), 0xFF);
+
+    reboot();
+    HOST_CHECK_EQUAL(LOCKOUT_getFailures(), 0);
+}
+
+/* Same once the area is used up and the erase before a failure did not go through */
+static void testResetAfterEraseError(void)
+{
+    uint8 filler = 0x5A;
+    uint8 cycle_idx;
+
+    EEPROM_MODEL_erase();
+    reboot();
+    for (cycle_idx = 0; cycle_idx < LOCKOUT_AREA_SIZE; cycle_idx++)
+    {
+        HOST_CHECK(LOCKOUT_recordFailure() == SUCCESS);
+        HOST_CHECK(LOCKOUT_reset() == SUCCESS);
+    }
+
+    /* Other pages fill the write-behind queue, the erase has to commit one of them */
+    EEPROM_MODEL_setAbsent(TRUE);
+    for (cycle_idx = 0; cycle_idx < EEPROM_QUEUE_ENTRIES; cycle_idx++)
+    {
+        HOST_CHECK(EEPROM_QUEUE_write(LOCKOUT_TEST_FILLER_ADDRESS + (cycle_idx * EEPROM_PAGE_SIZE), &filler, 1) == SUCCESS);
+    }
+    HOST_CHECK(LOCKOUT_recordFailure() == ERROR);
+    EEPROM_MODEL_setAbsent(FALSE);
+
+    HOST_CHECK(LOCKOUT_reset() == SUCCESS);
+    HOST_CHECK_EQUAL(EEPROM_MODEL_peek(AUDIT_RING_BASE_ADDRESS), 0xFF);
+
+    reboot();
+    HOST_CHECK_EQUAL(LOCKOUT_getFailures(), 0);
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] reportResetCost
+ * [Description]   Bus cost of a reset, stored before it returns.
+ *----------------------------------------------------------------------------*/
+static void reportResetCost(void)
+{
+    EEPROM_MODEL_StatsType stats;
+
+    EEPROM_MODEL_erase();
+    reboot();
+    HOST_CHECK(LOCKOUT_recordFailure() == SUCCESS);
+    EEPROM_MODEL_advanceTime(EEPROM_MODEL_WRITE_CYCLE_US);
+
+    EEPROM_MODEL_resetStats();
+    HOST_CHECK(LOCKOUT_reset() == SUCCESS);
+    EEPROM_MODEL_getStats(&stats);
+    printf("LOCKOUT_reset: %lu transactions, %lu bytes, %llu us of bus time\n",
+           (unsigned long)stats.transactions, (unsigned long)stats.bytes, (unsigned long long)stats.bus_time_us);
+}
+
+/*------------------------------------------------------------------------------
+ *  Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+    TWI_init(&g_twi_configuration);
+
+    testFailuresPersist();
+    testResetSurvivesPowerCut();
+    testAreaReuse();
+    testResetAfterReadError();
+    testResetAfterEraseError();
+    reportResetCost();
+
+    return HOST_RESULT("test_lockout_counter");
+}
@@ -0,0 +1,429 @@
+/*------------------------------------------------------------------------------
+ *  Module      : 24Cxx EEPROM Model (host builds)
+ *  File        : twi_24c16_model.c
+ *  Description : Host implementation of the TWI driver interface (twi.h)
+ *                talking to a file-backed 24C16: device address block select,
+ *                16 bytes page buffer with wrap-around, NACK while the
+ *                internal write cycle runs, per-byte wear counters and bus
+ *                time accounting at the SCL rate the target would use
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "twi.h"
+#include "eeprom_model.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/* 24Cxx device type identifier (upper nibble of the device address) */
+#define EEPROM_MODEL_DEVICE_TYPE                0xA0
+
+/* Default backing file */
+#define EEPROM_MODEL_DEFAULT_FILE               "eeprom_24c16.bin"
+
+/* Backing file layout: memory array followed by one wear counter per cell */
+#define EEPROM_MODEL_FILE_SIZE                  (EEPROM_MODEL_SIZE + (EEPROM_MODEL_SIZE * sizeof(uint32)))
+
+/*------------------------------------------------------------------------------
+ *  Data Types Declarations
+ *----------------------------------------------------------------------------*/
+
+typedef enum
+{
+    MODEL_BUS_IDLE,         /* No transaction */
+    MODEL_EXPECT_ADDRESS,   /* START sent, next byte is the device address */
+    MODEL_WORD_ADDRESS,     /* Device addressed for write, next byte is the word address */
+    MODEL_WRITE_DATA,       /* Bytes go to the page buffer */
+    MODEL_READ_DATA,        /* Device addressed for read */
+    MODEL_IGNORED           /* Device did not acknowledge, it ignores the bus */
+} EEPROM_MODEL_BusStateType;
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+static uint8 *g_memory = NULL;
+static uint32 *g_wear = NULL;
+
+static EEPROM_MODEL_BusStateType g_bus_state = MODEL_BUS_IDLE;
+static uint8 g_status = 0xF8;           /* "No relevant state information" */
+
+/* Internal address counter of the memory (11 bits) */
+static uint16 g_address_pointer = 0;
+
+/* Page buffer latched by the current write transaction */
+static uint8 g_latch[EEPROM_MODEL_PAGE_SIZE];
+static uint16 g_latch_mask = 0;
+static uint16 g_latch_page = 0;
+
+/* Simulated time in nanoseconds and end of the running write cycle */
+static uint64 g_time_ns = 0;
+static uint64 g_busy_until_ns = 0;
+static uint32 g_bit_time_ns = 10000;    /* 100 kHz until TWI_init() */
+static void (*g_clock_hook)(void) = NULL;
+
+/* Fault injection, 0xFF when disabled */
+static uint8 g_power_cut_bytes = 0xFF;
+static boolean g_absent = FALSE;
+static boolean g_bus_held = FALSE;
+
+static EEPROM_MODEL_StatsType g_stats;
+static uint64 g_bus_time_ns = 0;
+
+/*------------------------------------------------------------------------------
+ *  Private Functions
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ * [Function Name] EEPROM_MODEL_open
+ * [Description]   Maps the backing file, creating an erased part if needed.
+ *----------------------------------------------------------------------------*/
+static void EEPROM_MODEL_open(void)
+{
+    const char *path = getenv("EEPROM_MODEL_FILE");
+    off_t size;
+    int fd;
+
+    if (g_memory != NULL)
+    {
+        return;
+    }
+
+    if (path == NULL)
+    {
+        path = EEPROM_MODEL_DEFAULT_FILE;
+    }
+
+    fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+    {
+        perror(path);
+        exit(1);
+    }
+
+    size = lseek(fd, 0, SEEK_END);
+    if (size != (off_t)EEPROM_MODEL_FILE_SIZE)
+    {
+        /* New or foreign file: start from an erased part with no wear */
+        uint8 erased[EEPROM_MODEL_SIZE];
+
+        memset(erased, 0xFF, sizeof(erased));
+        if ((ftruncate(fd, 0) != 0) ||
+            (pwrite(fd, erased, sizeof(erased), 0) != (ssize_t)sizeof(erased)) ||
+            (ftruncate(fd, EEPROM_MODEL_FILE_SIZE) != 0))
+        {
+            perror(path);
+            exit(1);
+        }
+    }
+
+    g_memory = mmap(NULL, EEPROM_MODEL_FILE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (g_memory == MAP_FAILED)
+    {
+        perror("mmap");
+        exit(1);
+    }
+
+    g_wear = (uint32 *)(g_memory + EEPROM_MODEL_SIZE);
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] EEPROM_MODEL_clock
+ * [Description]   Advances time by a number of SCL periods of bus activity.
+ *----------------------------------------------------------------------------*/
+static void EEPROM_MODEL_clock(uint8 scl_periods)
+{
+    uint64 duration = (uint64)scl_periods * g_bit_time_ns;
+
+    g_time_ns += duration;
+    g_bus_time_ns += duration;
+
+    if (g_clock_hook != NULL)
+    {
+        g_clock_hook();
+    }
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] EEPROM_MODEL_isBusy
+ * [Description]   TRUE while the internal write cycle runs.
+ *----------------------------------------------------------------------------*/
+static boolean EEPROM_MODEL_isBusy(void)
+{
+    return (g_time_ns < g_busy_until_ns) ? TRUE : FALSE;
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] EEPROM_MODEL_commitPage
+ * [Description]   STOP after a write: programs the latched bytes.
+ *----------------------------------------------------------------------------*/
+static void EEPROM_MODEL_commitPage(void)
+{
+    uint8 offset;
+    uint8 programmed = 0;
+
+    for (offset = 0; offset < EEPROM_MODEL_PAGE_SIZE; offset++)
+    {
+        uint16 address = (uint16)(g_latch_page + offset);
+
+        if (!(g_latch_mask & (1u << offset)))
+        {
+            continue;
+        }
+
+        if (programmed < g_power_cut_bytes)
+        {
+            g_memory[address] = g_latch[offset];
+        }
+        else
+        {
+            g_memory[address] = (uint8)rand(); /* Interrupted cell */
+        }
+
+        g_wear[address]++;
+        programmed++;
+    }
+
+    g_stats.write_cycles++;
+    g_stats.bytes_programmed += programmed;
+    g_power_cut_bytes = 0xFF;
+    g_latch_mask = 0;
+    g_busy_until_ns = g_time_ns + ((uint64)EEPROM_MODEL_WRITE_CYCLE_US * 1000);
+}
+
+/*------------------------------------------------------------------------------
+ *  TWI Driver Interface
+ *----------------------------------------------------------------------------*/
+
+void TWI_init(const TWI_ConfigType * Config_Ptr)
+{
+    /* Same TWBR computation as the AVR driver, prescaler 1 */
+    uint8 twbr_value = (uint8)(((F_CPU / Config_Ptr->bit_rate) - 16) / 2);
+
+    g_bit_time_ns = (uint32)((1000000000ULL * (16 + (2 * (uint32)twbr_value))) / F_CPU);
+    g_bus_held = FALSE;
+
+    EEPROM_MODEL_open();
+}
+
+void TWI_start(void)
+{
+    EEPROM_MODEL_open();
+    EEPROM_MODEL_clock(1);
+
+    /* The driver waits for TWINT, which never comes: only the clock hook gets out */
+    while (g_bus_held)
+    {
+        EEPROM_MODEL_clock(1);
+    }
+
+    if (g_bus_state == MODEL_BUS_IDLE)
+    {
+        g_status = TWI_START;
+        g_stats.transactions++;
+    }
+    else
+    {
+        g_status = TWI_REP_START;
+        g_stats.repeated_starts++;
+    }
+
+    g_bus_state = MODEL_EXPECT_ADDRESS;
+}
+
+void TWI_stop(void)
+{
+    EEPROM_MODEL_clock(1);
+
+    if ((g_bus_state == MODEL_WRITE_DATA) && (g_latch_mask != 0))
+    {
+        EEPROM_MODEL_commitPage();
+    }
+
+    g_latch_mask = 0;
+    g_bus_state = MODEL_BUS_IDLE;
+}
+
+void TWI_writeByte(uint8 data)
+{
+    EEPROM_MODEL_clock(9);
+    g_stats.bytes++;
+
+    switch (g_bus_state)
+    {
+        case MODEL_EXPECT_ADDRESS:
+            if (((data & 0xF0) != EEPROM_MODEL_DEVICE_TYPE) || EEPROM_MODEL_isBusy() || g_absent)
+            {
+                /* Not our address, the memory is programming a page or cut off */
+                if (EEPROM_MODEL_isBusy() && ((data & 0xF0) == EEPROM_MODEL_DEVICE_TYPE))
+                {
+                    g_stats.busy_nacks++;
+                }
+                g_stats.nacks++;
+                g_status = (data & 1) ? TWI_MT_SLA_R_NACK : TWI_MT_SLA_W_NACK;
+                g_bus_state = MODEL_IGNORED;
+            }
+            else if (data & 1)
+            {
+                /* Current address read, the block bits are ignored as on the real part */
+                g_status = TWI_MT_SLA_R_ACK;
+                g_bus_state = MODEL_READ_DATA;
+            }
+            else
+            {
+                /* Block select bits A10..A8 */
+                g_address_pointer = (uint16)((data & 0x0E) << 7);
+                g_status = TWI_MT_SLA_W_ACK;
+                g_bus_state = MODEL_WORD_ADDRESS;
+            }
+            break;
+
+        case MODEL_WORD_ADDRESS:
+            g_address_pointer = (uint16)((g_address_pointer & 0x0700) | data);
+            g_latch_page = (uint16)(g_address_pointer & ~(EEPROM_MODEL_PAGE_SIZE - 1));
+            g_latch_mask = 0;
+            g_status = TWI_MT_DATA_ACK;
+            g_bus_state = MODEL_WRITE_DATA;
+            break;
+
+        case MODEL_WRITE_DATA:
+        {
+            uint8 offset = (uint8)(g_address_pointer & (EEPROM_MODEL_PAGE_SIZE - 1));
+
+            g_latch[offset] = data;
+            g_latch_mask |= (uint16)(1u << offset);
+
+            /* The page address counter wraps inside the page */
+            g_address_pointer = (uint16)(g_latch_page | ((offset + 1) & (EEPROM_MODEL_PAGE_SIZE - 1)));
+            g_status = TWI_MT_DATA_ACK;
+            break;
+        }
+
+        default:
+            g_stats.nacks++;
+            g_status = TWI_MT_DATA_NACK;
+            break;
+    }
+}
+
+/*------------------------------------------------------------------------------
+ * [Function Name] EEPROM_MODEL_readNext
+ * [Description]   Sequential read, the counter rolls over the whole array.
+ *----------------------------------------------------------------------------*/
+static uint8 EEPROM_MODEL_readNext(void)
+{
+    uint8 data;
+
+    EEPROM_MODEL_clock(9);
+    g_stats.bytes++;
+
+    if (g_bus_state != MODEL_READ_DATA)
+    {
+        return 0xFF; /* Nobody drives SDA */
+    }
+
+    data = g_memory[g_address_pointer];
+    g_address_pointer = (uint16)((g_address_pointer + 1) & (EEPROM_MODEL_SIZE - 1));
+
+    return data;
+}
+
+uint8 TWI_readByteWithACK(void)
+{
+    uint8 data = EEPROM_MODEL_readNext();
+
+    g_status = TWI_MR_DATA_ACK;
+    return data;
+}
+
+uint8 TWI_readByteWithNACK(void)
+{
+    uint8 data = EEPROM_MODEL_readNext();
+
+    g_status = TWI_MR_DATA_NACK;
+    return data;
+}
+
+uint8 TWI_getStatus(void)
+{
+    return g_status;
+}
+
+/*------------------------------------------------------------------------------
+ *  Model Interface
+ *----------------------------------------------------------------------------*/
+
+void EEPROM_MODEL_getStats(EEPROM_MODEL_StatsType *stats)
+{
+    *stats = g_stats;
+    stats->bus_time_us = g_bus_time_ns / 1000;
+}
+
+void EEPROM_MODEL_resetStats(void)
+{
+    memset(&g_stats, 0, sizeof(g_stats));
+    g_bus_time_ns = 0;
+}
+
+uint32 EEPROM_MODEL_getWear(uint16 address)
+{
+    EEPROM_MODEL_open();
+    return g_wear[address & (EEPROM_MODEL_SIZE - 1)];
+}
+
+uint64 EEPROM_MODEL_getTimeUs(void)
+{
+    return g_time_ns / 1000;
+}
+
+void EEPROM_MODEL_advanceTime(uint32 microseconds)
+{
+    g_time_ns += (uint64)microseconds * 1000;
+}
+
+void EEPROM_MODEL_setClockHook(void (*a_hook)(void))
+{
+    g_clock_hook = a_hook;
+}
+
+void EEPROM_MODEL_cutPowerDuringNextWrite(uint8 programmed_bytes)
+{
+    g_power_cut_bytes = programmed_bytes;
+}
+
+void EEPROM_MODEL_setAbsent(boolean absent)
+{
+    g_absent = absent;
+}
+
+void EEPROM_MODEL_holdBus(void)
+{
+    g_bus_held = TRUE;
+}
+
+void EEPROM_MODEL_erase(void)
+{
+    EEPROM_MODEL_open();
+    memset(g_memory, 0xFF, EEPROM_MODEL_SIZE);
+    g_busy_until_ns = 0;
+}
+
+uint8 EEPROM_MODEL_peek(uint16 address)
+{
+    EEPROM_MODEL_open();
+    return g_memory[address & (EEPROM_MODEL_SIZE - 1)];
+}
@@ -0,0 +1,22 @@
+/*------------------------------------------------------------------------------
+ *  Module      : AVR Register Model (host builds)
+ *  File        : delay.h
+ *  Description : Host stand-in for <util/delay.h>: the busy waits are handed
+ *                to the delay hook of avr_model.c, which lets a simulation
+ *                account for the time they take
+ *  Author      : Hassan Darwish
+ *----------------------------------------------------------------------------*/
+
+#ifndef UTIL_DELAY_H_
+#define UTIL_DELAY_H_
+
+/*------------------------------------------------------------------------------
+ *  Function Declarations
+ *----------------------------------------------------------------------------*/
+
+void AVR_MODEL_delayUs(double microseconds);
+
+#define _delay_us(us)                           AVR_MODEL_delayUs((double)(us))
+#define _delay_ms(ms)                           AVR_MODEL_delayUs((double)(ms) * 1000.0)
+
+#endif /* UTIL_DELAY_H_ */
@@ -0,0 +1,750 @@
+/*------------------------------------------------------------------------------
+ *  Module      : Audit Log Decoder (Linux host tool)
+ *  File        : audit_decode.c
+ *  Description : Requests the audit log from the Control ECU over a serial
+ *                port (or decodes a captured byte stream) and prints it as CSV
+ *  Author      : Hassan Darwish
+ *
+ *  Build :
+ *      gcc -O2 -I../control_ecu -o audit_decode audit_decode.c ../control_ecu/crc.c
+ *
+ *  Usage :
+ *      audit_decode -d /dev/ttyUSB0 [-c cursor]   request and decode
+ *      audit_decode -f capture.bin                decode a captured stream
+ *      audit_decode -t (-d device | -f capture)   EEPROM transaction timings
+ *      audit_decode -s (-d device | -f capture)   door transition latencies
+ *      audit_decode -m (-d device | -f capture)   task execution times
+ *      audit_decode -p (-d device | -f capture)   profiled region cycle counts
+ *      audit_decode -d device -a admin -e id:credential[:admin]
+ *                                                 enroll a user
+ *      audit_decode -d device -a admin -r id      remove a user
+ *
+ *  'admin' is the master password or the credential of a user enrolled with
+ *  the admin flag, credentials are given as their five keypad digits.
+ *
+ *  The export is resumable: after an interrupted or corrupted transfer the
+ *  tool asks again starting at the sequence number after the last record it
+ *  printed. The cursor to use for the next incremental export is printed on
+ *  stderr at the end.
+ *----------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *  INCLUDES
+ *----------------------------------------------------------------------------*/
+
+#include "crc.h"
+#include "audit_log.h"
+#include "twi_trace.h"
+#include "door_fsm.h"
+#include "task_monitor.h"
+#include "profile.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/select.h>
+
+/*------------------------------------------------------------------------------
+ *  Pre-Processor Constants and Configurations
+ *----------------------------------------------------------------------------*/
+
+/* Must match the diagnostics requests in control_constants.h */
+#define AUDIT_EXPORT_REQUEST                    0x6A
+#define TWI_STATS_REQUEST                       0x6B
+#define PROFILE_DUMP_REQUEST                    0x6C
+#define TASK_STATS_REQUEST                      0x6D
+#define DOOR_STATS_REQUEST                      0x6E
+#define USER_ENROLL_REQUEST                     0x6F
+#define USER_REMOVE_REQUEST                     0x70
+
+/* User administration replies and user flags, as in control_constants.h and user_table.h */
+#define ADMIN_REPLY_TRUE                        0x5B
+#define ADMIN_CREDENTIAL_SIZE                   5
+#define ADMIN_FLAG_ENABLED                      0x01
+#define ADMIN_FLAG_ADMIN                        0x02
+
+#define DECODER_TIMEOUT_MS                      2000
+#define DECODER_MAX_RETRIES                     5
+
+/* Frame parser results */
+#define FRAME_OK                                0
+#define FRAME_TIMEOUT                           1
+#define FRAME_BAD_CRC                           2
+
+/*------------------------------------------------------------------------------
+ *  Global Variables
+ *----------------------------------------------------------------------------*/
+
+static int g_fd = -1;
+static int g_is_tty = 0;
+
+static const char *g_twi_op_names[] =
+{
+    "write_byte", "read_byte", "write_page", "read_block", "wait_ready", "ready_poll"
+};
+
+/* Indexed by DOOR_StateType, the last entry is the table's any/same marker */
+static const char *g_door_state_names[] =
+{
+    "locked", "opening", "held", "closing", "lockdown", "fault", "*"
+};
+
+static const char *g_door_event_names[] =
+{
+    "open", "lockdown", "timeout", "pir_clear", "fault"
+};
+
+/* Indexed by PROFILE_RegionType */
+static const char *g_profile_region_names[] =
+{
+    "EEPROM_readBlock", "isPasswordCorrect", "LCD_displayCharacter", "KEYPAD_scan"
+};
+
+static const char *g_event_names[] =
+{
+    "unknown", "boot", "door_opened", "door_closed", "access_denied",
+    "lockdown_start", "lockdown_end", "password_changed", "user_enrolled",
+    "user_deleted", "watchdog_reset", "storage_error"
+};
+
+/*------------------------------------------------------------------------------
+ *  Functions
+ *----------------------------------------------------------------------------*/
+
+/* Read one byte, returns -1 on timeout or end of file */
+static int readByte(void)
+{
+    unsigned char byte;
+
+    if (g_is_tty)
+    {
+        fd_set set;
+        struct timeval timeout = {DECODER_TIMEOUT_MS / 1000, (DECODER_TIMEOUT_MS % 1000) * 1000};
+
+        FD_ZERO(&set);
+        FD_SET(g_fd, &set);
+        if (select(g_fd + 1, &set, NULL, NULL, &timeout) <= 0)
+        {
+            return -1;
+        }
+    }
+
+    if (read(g_fd, &byte, 1) != 1)
+    {
+        return -1;
+    }
+
+    return byte;
+}
+
+/* Wait for a frame start and read a whole frame */
+static int readFrame(unsigned char *type, unsigned char *payload, unsigned char *length)
+{
+    unsigned short crc = CRC16_INITIAL_VALUE;
+    int value;
+    int idx;
+    unsigned short received_crc;
+
+    do
+    {
+        value = readByte();
+        if (value < 0)
+        {
+            return FRAME_TIMEOUT;
+        }
+    } while (value != AUDIT_EXPORT_SOF);
+
+    if ((value = readByte()) < 0)
+    {
+        return FRAME_TIMEOUT;
+    }
+    *type = (unsigned char)value;
+    crc = CRC16_update(crc, *type);
+
+    if ((value = readByte()) < 0)
+    {
+        return FRAME_TIMEOUT;
+    }
+    *length = (unsigned char)value;
+    crc = CRC16_update(crc, *length);
+
+    for (idx = 0; idx < *length; idx++)
+    {
+        if ((value = readByte()) < 0)
+        {
+            return FRAME_TIMEOUT;
+        }
+        payload[idx] = (unsigned char)value;
+        crc = CRC16_update(crc, payload[idx]);
+    }
+
+    if ((value = readByte()) < 0)
+    {
+        return FRAME_TIMEOUT;
+    }
+    received_crc = (unsigned short)value;
+    if ((value = readByte()) < 0)
+    {
+        return FRAME_TIMEOUT;
+    }
+    received_crc |= (unsigned short)(value << 8);
+
+    return (received_crc == crc) ? FRAME_OK : FRAME_BAD_CRC;
+}
+
+/* Little endian fields of a frame payload */
+static unsigned long getField(const unsigned char *payload, int offset, int size)
+{
+    unsigned long value = 0;
+
+    while (size-- > 0)
+    {
+        value = (value << 8) | payload[offset + size];
+    }
+
+    return value;
+}
+
+/* Request the TWI trace statistics and print one CSV line per operation */
+static int dumpTwiStats(void)
+{
+    unsigned char payload[256];
+    unsigned char type;
+    unsigned char length;
+    int bucket;
+
+    if (g_is_tty)
+    {
+        unsigned char request = TWI_STATS_REQUEST;
+
+        tcflush(g_fd, TCIOFLUSH);
+        if (write(g_fd, &request, 1) != 1)
+        {
+            perror("write");
+            return 1;
+        }
+    }
+
+    printf("operation,count,errors,max_us,avg_address_us,avg_transfer_us");
+    for (bucket = 0; bucket < (TWI_TRACE_BUCKETS - 1); bucket++)
+    {
+        printf(",lt_%lu_us", (unsigned long)TWI_TRACE_TICK_US << (bucket + 1));
+    }
+    printf(",ge_%lu_us\n", (unsigned long)TWI_TRACE_TICK_US << (TWI_TRACE_BUCKETS - 1));
+
+    for (;;)
+    {
+        if (readFrame(&type, payload, &length) != FRAME_OK)
+        {
+            fprintf(stderr, "statistics incomplete\n");
+            return 1;
+        }
+
+        if (type == DIAG_FRAME_TWI_OPERATION && length == 15 + (2 * TWI_TRACE_BUCKETS))
+        {
+            unsigned long count = getField(payload, 1, 2);
+            unsigned long tick_us = TWI_TRACE_TICK_US;
+
+            printf("%s,%lu,%lu,%lu,%lu,%lu",
+                   (payload[0] < TWI_TRACE_OPS) ? g_twi_op_names[payload[0]] : "unknown",
+                   count, getField(payload, 3, 2), getField(payload, 5, 2) * tick_us,
+                   count ? (getField(payload, 7, 4) * tick_us) / count : 0,
+                   count ? (getField(payload, 11, 4) * tick_us) / count : 0);
+            for (bucket = 0; bucket < TWI_TRACE_BUCKETS; bucket++)
+            {
+                printf(",%lu", getField(payload, 15 + (2 * bucket), 2));
+            }
+            printf("\n");
+        }
+        else if (type == DIAG_FRAME_TWI_BUS && length == 5)
+        {
+            fflush(stdout);
+            fprintf(stderr, "nacks: %lu, poll retries: %lu\n",
+                    getField(payload, 0, 2), getField(payload, 2, 2));
+            return 0;
+        }
+    }
+}
+
+/* Request the door state machine statistics and print one CSV line per transition */
+static int dumpDoorStats(void)
+{
+    unsigned char payload[256];
+    unsigned char type;
+    unsigned char length;
+
+    if (g_is_tty)
+    {
+        unsigned char request = DOOR_STATS_REQUEST;
+
+        tcflush(g_fd, TCIOFLUSH);
+        if (write(g_fd, &request, 1) != 1)
+        {
+            perror("write");
+            return 1;
+        }
+    }
+
+    printf("row,state,event,next,count,last_us,max_us\n");
+
+    for (;;)
+    {
+        if (readFrame(&type, payload, &length) != FRAME_OK)
+        {
+            fprintf(stderr, "statistics incomplete\n");
+            return 1;
+        }
+
+        if (type == DIAG_FRAME_DOOR_TRANSITION && length == 14)
+        {
+            printf("%u,%s,%s,%s,%lu,%lu,%lu\n", payload[0],
+                   (payload[1] <= DOOR_STATES) ? g_door_state_names[payload[1]] : "unknown",
+                   (payload[2] < DOOR_EVENTS) ? g_door_event_names[payload[2]] : "unknown",
+                   (payload[3] <= DOOR_STATES) ? g_door_state_names[payload[3]] : "unknown",
+                   getField(payload, 4, 2), getField(payload, 6, 4), getField(payload, 10, 4));
+        }
+        else if (type == DIAG_FRAME_DOOR_STATE && length == 2)
+        {
+            fflush(stdout);
+            fprintf(stderr, "state: %s\n",
+                    (payload[0] < DOOR_STATES) ? g_door_state_names[payload[0]] : "unknown");
+            return 0;
+        }
+    }
+}
+
+/* Request the task monitor statistics and print one CSV line per task */
+static int dumpTaskStats(void)
+{
+    unsigned char payload[256];
+    unsigned char type;
+    unsigned char length;
+
+    if (g_is_tty)
+    {
+        unsigned char request = TASK_STATS_REQUEST;
+
+        tcflush(g_fd, TCIOFLUSH);
+        if (write(g_fd, &request, 1) != 1)
+        {
+            perror("write");
+            return 1;
+        }
+    }
+
+    printf("task,runs,misses,wcet_us,budget_us,period_ms\n");
+
+    for (;;)
+    {
+        if (readFrame(&type, payload, &length) != FRAME_OK)
+        {
+            fprintf(stderr, "statistics incomplete\n");
+            return 1;
+        }
+
+        if (type == DIAG_FRAME_TASK_STATS && length == 15)
+        {
+            if (payload[0] == MONITOR_IDLE_TASK)
+            {
+                printf("idle");
+            }
+            else
+            {
+                printf("%u", payload[0]);
+            }
+            printf(",%lu,%lu,%lu,%lu,%lu\n", getField(payload, 1, 2), getField(payload, 3, 2),
+                   getField(payload, 5, 4), getField(payload, 9, 4), getField(payload, 13, 2));
+        }
+        else if (type == DIAG_FRAME_EVENT_QUEUE && length == 3)
+        {
+            fflush(stdout);
+            fprintf(stderr, "events dropped: %lu (queue of %u)\n", getField(payload, 0, 2), payload[2]);
+        }
+        else if (type == DIAG_FRAME_TASK_RESET && length == 2)
+        {
+            fflush(stdout);
+            if (!payload[0])
+            {
+                fprintf(stderr, "last reset: not by the watchdog\n");
+            }
+            else if (payload[1] == MONITOR_NO_TASK)
+            {
+                fprintf(stderr, "last reset: watchdog, between tasks\n");
+            }
+            else
+            {
+                fprintf(stderr, "last reset: watchdog, in task %u\n", payload[1]);
+            }
+            return 0;
+        }
+    }
+}
+
+/*
+ * Request the profiled regions and print one CSV line per region that ran,
+ * the lines wait for the end frame which carries the CPU clock
+ */
+static int dumpProfile(void)
+{
+    unsigned char payload[256];
+    unsigned char regions[PROFILE_REGIONS][15];
+    unsigned char type;
+    unsigned char length;
+    int region_count = 0;
+    int region_idx;
+
+    if (g_is_tty)
+    {
+        unsigned char request = PROFILE_DUMP_REQUEST;
+
+        tcflush(g_fd, TCIOFLUSH);
+        if (write(g_fd, &request, 1) != 1)
+        {
+            perror("write");
+            return 1;
+        }
+    }
+
+    for (;;)
+    {
+        if (readFrame(&type, payload, &length) != FRAME_OK)
+        {
+            fprintf(stderr, "statistics incomplete\n");
+            return 1;
+        }
+
+        if (type == DIAG_FRAME_PROFILE_REGION && length == 15 && region_count < PROFILE_REGIONS)
+        {
+            memcpy(regions[region_count++], payload, 15);
+        }
+        else if (type == DIAG_FRAME_PROFILE_END && length == 3)
+        {
+            double cycles_per_us = (payload[0] != 0) ? payload[0] : 1;
+
+            printf("region,count,min_cycles,max_cycles,avg_cycles,total_cycles,min_us,max_us,avg_us\n");
+
+            for (region_idx = 0; region_idx < region_count; region_idx++)
+            {
+                const unsigned char *region = regions[region_idx];
+                unsigned long count = getField(region, 1, 2);
+                unsigned long min = getField(region, 3, 4);
+                unsigned long max = getField(region, 7, 4);
+                unsigned long total = getField(region, 11, 4);
+                unsigned long avg = (count != 0) ? (total / count) : 0;
+
+                if (count == 0)
+                {
+                    continue;
+                }
+
+                printf("%s,%lu,%lu,%lu,%lu,%lu,%.1f,%.1f,%.1f\n",
+                       (region[0] < PROFILE_REGIONS) ? g_profile_region_names[region[0]] : "unknown",
+                       count, min, max, avg, total,
+                       min / cycles_per_us, max / cycles_per_us, avg / cycles_per_us);
+            }
+
+            fflush(stdout);
+            fprintf(stderr, "%u MHz, %lu cycles of overhead removed per run\n",
+                    payload[0], getField(payload, 1, 2));
+            return 0;
+        }
+    }
+}
+
+/* Keypad digits of a credential written as text, returns 0 if it is not five digits */
+static int parseCredential(const char *text, unsigned char *credential)
+{
+    int digit_idx;
+
+    for (digit_idx = 0; digit_idx < ADMIN_CREDENTIAL_SIZE; digit_idx++)
+    {
+        if (text[digit_idx] < '0' || text[digit_idx] > '9')
+        {
+            return 0;
+        }
+        credential[digit_idx] = (unsigned char)(text[digit_idx] - '0');
+    }
+
+    return (text[ADMIN_CREDENTIAL_SIZE] == '\0' || text[ADMIN_CREDENTIAL_SIZE] == ':');
+}
+
+/*
+ * Send a user enroll ("id:credential[:admin]") or remove ("id") request
+ * authorised by the admin credential and print the Control ECU's answer
+ */
+static int administerUser(const char *admin, const char *enroll, const char *remove)
+{
+    unsigned char request[1 + ADMIN_CREDENTIAL_SIZE + 3 + ADMIN_CREDENTIAL_SIZE];
+    const char *user = (enroll != NULL) ? enroll : remove;
+    char *end;
+    unsigned long user_id = strtoul(user, &end, 0);
+    size_t length = 1 + ADMIN_CREDENTIAL_SIZE + 2;
+    int reply;
+
+    if (!g_is_tty || !parseCredential(admin, &request[1]) || user_id == 0 || user_id >= 0xFFFE)
+    {
+        fprintf(stderr, "user administration needs -d, -a with five digits and a user id from 1 to 65533\n");
+        return 2;
+    }
+
+    request[0] = (enroll != NULL) ? USER_ENROLL_REQUEST : USER_REMOVE_REQUEST;
+    request[1 + ADMIN_CREDENTIAL_SIZE] = (unsigned char)user_id;
+    request[2 + ADMIN_CREDENTIAL_SIZE] = (unsigned char)(user_id >> 8);
+
+    if (enroll != NULL)
+    {
+        if (*end != ':' || !parseCredential(end + 1, &request[length + 1]))
+        {
+            fprintf(stderr, "enroll as id:credential or id:credential:admin\n");
+            return 2;
+        }
+        request[length] = ADMIN_FLAG_ENABLED;
+        if (strcmp(end + 1 + ADMIN_CREDENTIAL_SIZE, ":admin") == 0)
+        {
+            request[length] |= ADMIN_FLAG_ADMIN;
+        }
+        length += 1 + ADMIN_CREDENTIAL_SIZE;
+    }
+
+    tcflush(g_fd, TCIOFLUSH);
+    if (write(g_fd, request, length) != (ssize_t)length)
+    {
+        perror("write");
+        return 1;
+    }
+
+    reply = readByte();
+    if (reply != ADMIN_REPLY_TRUE)
+    {
+        fprintf(stderr, "user %lu: %s\n", user_id, (reply < 0) ? "no answer" : "refused");
+        return 1;
+    }
+
+    fprintf(stderr, "user %lu: %s\n", user_id, (enroll != NULL) ? "enrolled" : "removed");
+    return 0;
+}
+
+/* Send the export request with its cursor */
+static void sendRequest(unsigned short cursor)
+{
+    unsigned char request[3] = {AUDIT_EXPORT_REQUEST, (unsigned char)cursor, (unsigned char)(cursor >> 8)};
+
+    tcflush(g_fd, TCIOFLUSH);
+    if (write(g_fd, request, sizeof(request)) != (ssize_t)sizeof(request))
+    {
+        perror("write");
+    }
+}
+
+/* Open the serial port as 9600 8N1 raw, the Control ECU UART settings */
+static int openSerial(const char *path)
+{
+    struct termios tty;
+    int fd = open(path, O_RDWR | O_NOCTTY);
+
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    if (tcgetattr(fd, &tty) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    cfmakeraw(&tty);
+    cfsetispeed(&tty, B9600);
+    cfsetospeed(&tty, B9600);
+    tty.c_cflag |= (CLOCAL | CREAD);
+    tty.c_cflag &= ~(CSTOPB | PARENB);
+    tty.c_cc[VMIN] = 1;
+    tty.c_cc[VTIME] = 0;
+
+    if (tcsetattr(fd, TCSANOW, &tty) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+int main(int argc, char **argv)
+{
+    const char *device = NULL;
+    const char *capture = NULL;
+    unsigned short cursor = AUDIT_EXPORT_ALL;
+    unsigned char payload[256];
+    unsigned char type;
+    unsigned char length;
+    int retries = 0;
+    int done = 0;
+    int twi_stats = 0;
+    int door_stats = 0;
+    int task_stats = 0;
+    int profile = 0;
+    const char *admin = NULL;
+    const char *enroll = NULL;
+    const char *remove = NULL;
+    int option;
+
+    while ((option = getopt(argc, argv, "d:f:c:tsmpa:e:r:")) != -1)
+    {
+        switch (option)
+        {
+            case 't': twi_stats = 1; break;
+            case 's': door_stats = 1; break;
+            case 'm': task_stats = 1; break;
+            case 'p': profile = 1; break;
+            case 'd': device = optarg; break;
+            case 'f': capture = optarg; break;
+            case 'c': cursor = (unsigned short)strtoul(optarg, NULL, 0); break;
+            case 'a': admin = optarg; break;
+            case 'e': enroll = optarg; break;
+            case 'r': remove = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-t | -s | -m | -p] (-d device [-c cursor] | -f capture)\n", argv[0]);
+                return 2;
+        }
+    }
+
+    if (device != NULL)
+    {
+        g_fd = openSerial(device);
+        g_is_tty = 1;
+    }
+    else if (capture != NULL)
+    {
+        g_fd = open(capture, O_RDONLY);
+    }
+
+    if (g_fd < 0)
+    {
+        fprintf(stderr, "usage: %s [-t | -s | -m | -p] (-d device [-c cursor] | -f capture)\n", argv[0]);
+        return 2;
+    }
+
+    if (admin != NULL && (enroll != NULL || remove != NULL))
+    {
+        int status = administerUser(admin, enroll, remove);
+
+        close(g_fd);
+        return status;
+    }
+
+    if (twi_stats)
+    {
+        int status = dumpTwiStats();
+
+        close(g_fd);
+        return status;
+    }
+
+    if (door_stats)
+    {
+        int status = dumpDoorStats();
+
+        close(g_fd);
+        return status;
+    }
+
+    if (task_stats)
+    {
+        int status = dumpTaskStats();
+
+        close(g_fd);
+        return status;
+    }
+
+    if (profile)
+    {
+        int status = dumpProfile();
+
+        close(g_fd);
+        return status;
+    }
+
+    printf("sequence,timestamp_s,event,detail\n");
+
+    if (g_is_tty)
+    {
+        sendRequest(cursor);
+    }
+
+    while (!done)
+    {
+        int status = readFrame(&type, payload, &length);
+
+        if (status != FRAME_OK)
+        {
+            if (!g_is_tty || (++retries > DECODER_MAX_RETRIES))
+            {
+                fprintf(stderr, "export incomplete, resume with -c %u\n", cursor);
+                return 1;
+            }
+
+            /* Resume right after the last record printed */
+            sendRequest(cursor);
+            continue;
+        }
+
+        if (type == AUDIT_EXPORT_FRAME_END && length == AUDIT_EXPORT_END_LENGTH)
+        {
+            cursor = (unsigned short)(payload[0] | (payload[1] << 8));
+            if (payload[2] != 0)
+            {
+                fprintf(stderr, "%u corrupt record(s) skipped by the Control ECU\n", payload[2]);
+            }
+            if (getField(payload, 3, 2) != 0)
+            {
+                fprintf(stderr, "%lu event(s) dropped since boot, the Control ECU stage was full\n",
+                        getField(payload, 3, 2));
+            }
+            done = 1;
+        }
+        else if (type == AUDIT_EXPORT_FRAME_DATA)
+        {
+            int offset;
+
+            for (offset = 0; offset + AUDIT_RECORD_SIZE <= length; offset += AUDIT_RECORD_SIZE)
+            {
+                const unsigned char *record = &payload[offset];
+                unsigned long timestamp = (unsigned long)record[AUDIT_TIMESTAMP_OFFSET] |
+                                          ((unsigned long)record[AUDIT_TIMESTAMP_OFFSET + 1] << 8) |
+                                          ((unsigned long)record[AUDIT_TIMESTAMP_OFFSET + 2] << 16) |
+                                          ((unsigned long)record[AUDIT_TIMESTAMP_OFFSET + 3] << 24);
+                unsigned short sequence = (unsigned short)(record[AUDIT_SEQUENCE_OFFSET] |
+                                                           (record[AUDIT_SEQUENCE_OFFSET + 1] << 8));
+                unsigned short detail = (unsigned short)(record[AUDIT_DETAIL_OFFSET] |
+                                                         (record[AUDIT_DETAIL_OFFSET + 1] << 8));
+                unsigned char event = record[AUDIT_EVENT_OFFSET];
+
+                /* Records already printed before a retry are skipped */
+                if ((cursor != AUDIT_EXPORT_ALL) && ((short)(sequence - cursor) < 0))
+                {
+                    continue;
+                }
+
+                printf("%u,%lu,%s,%u\n", sequence, timestamp,
+                       (event < sizeof(g_event_names) / sizeof(g_event_names[0])) ? g_event_names[event] : "unknown",
+                       detail);
+
+                cursor = (unsigned short)(sequence + 1);
+                if (cursor == AUDIT_EMPTY_SEQUENCE)
+                {
+                    cursor = 0;
+                }
+            }
+        }
+    }
+
+    fflush(stdout);
+    fprintf(stderr, "next cursor: %u\n", cursor);
+
+    close(g_fd);
+    return 0;
+}